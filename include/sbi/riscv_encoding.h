@@ -45,6 +45,7 @@
 #define MSTATUS_GVA			_ULL(0x0000004000000000)
 #define MSTATUS_GVA_SHIFT		38
 #define MSTATUS_MPV			_ULL(0x0000008000000000)
+#define MSTATUS_MPV_SHIFT		39
 #define MSTATUS_MPELP			_ULL(0x0000020000000000)
 #define MSTATUS_MDT			_ULL(0x0000040000000000)
 #else
@@ -58,6 +59,10 @@
 #endif
 #define MSTATUS32_SD			_UL(0x80000000)
 #define MSTATUS64_SD			_ULL(0x8000000000000000)
+#define MSTATUS_EXT_OFF			0
+#define MSTATUS_EXT_INITIAL		1
+#define MSTATUS_EXT_CLEAN		2
+#define MSTATUS_EXT_DIRTY		3
 #define MXL_XLEN_32			1
 #define MXL_XLEN_64			2
 #define MXL_TO_XLEN(x)			(1U << (x + 4))
@@ -92,6 +97,7 @@
 #define HSTATUS_VSBE			_UL(0x00000020)
 
 #define MTVEC_MODE			_UL(0x00000003)
+#define MTVEC_MODE_VECTORED		_UL(0x00000001)
 
 #define MCAUSE_IRQ_MASK			(_UL(1) << (__riscv_xlen - 1))
 
@@ -24,6 +24,21 @@ struct sbi_console_device {
 
 	/** Read a character from the console input */
 	int (*console_getc)(void);
+
+	/**
+	 * Write characters to the console output without waiting
+	 * and return the number of characters written (optional)
+	 */
+	unsigned long (*console_tx_try_puts)(const char *str, unsigned long len);
+
+	/** Enable or disable the console transmit interrupt (optional) */
+	void (*console_tx_irq_enable)(bool enable);
+
+	/**
+	 * Setup the console transmit interrupt after interrupt
+	 * controllers are initialized (optional)
+	 */
+	int (*console_tx_irq_init)(void);
 };
 
 #define __printf(a, b) __attribute__((format(printf, a, b)))
@@ -50,6 +65,9 @@ int __printf(1, 2) sbi_printf(const char *format, ...);
 
 int __printf(1, 2) sbi_dprintf(const char *format, ...);
 
+/** Print to the firmware log of the current HART only */
+int __printf(1, 2) sbi_lprintf(const char *format, ...);
+
 void __printf(1, 2) __attribute__((noreturn)) sbi_panic(const char *format, ...);
 
 const struct sbi_console_device *sbi_console_get_device(void);
@@ -58,6 +76,15 @@ void sbi_console_set_device(const struct sbi_console_device *dev);
 
 struct sbi_scratch;
 
+/** Wait for all buffered console output to reach the console device */
+void sbi_console_flush(void);
+
+/** Push buffered console output from the console transmit interrupt */
+void sbi_console_tx_process(void);
+
+/** Enable interrupt-driven buffered console output if supported */
+int sbi_console_tx_init(struct sbi_scratch *scratch);
+
 #define SBI_ASSERT(cond, args) do { \
 	if (unlikely(!(cond))) \
 		sbi_panic args; \
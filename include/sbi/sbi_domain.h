@@ -185,6 +185,22 @@ static inline bool sbi_domain_memregion_is_subset(
 	return false;
 }
 
+/**
+ * Interval of the flattened memory region index of a domain
+ *
+ * The intervals of a domain are sorted, non-overlapping and carry the
+ * flags of the memory region which decides accesses to all addresses
+ * of the interval. Addresses not covered by any region have no interval.
+ */
+struct sbi_domain_memindex {
+	/** First address of the interval */
+	unsigned long start;
+	/** Last address of the interval */
+	unsigned long end;
+	/** Flags of the deciding memory region */
+	unsigned long flags;
+};
+
 /** Representation of OpenSBI domain */
 struct sbi_domain {
 	/** Node in linked list of domains */
@@ -203,6 +219,10 @@ struct sbi_domain {
 	const struct sbi_hartmask *possible_harts;
 	/** Array of memory regions terminated by a region with order zero */
 	struct sbi_domain_memregion *regions;
+	/** Flattened index of the memory regions (built when finalized) */
+	struct sbi_domain_memindex *memindex;
+	/** Number of intervals in the memory region index */
+	u32 memindex_count;
 	/** HART id of the HART booting this domain */
 	u32 boot_hartid;
 	/** Arg1 (or 'a1' register) of next booting stage for this domain */
@@ -215,6 +235,10 @@ struct sbi_domain {
 	bool system_reset_allowed;
 	/** Is domain allowed to suspend the system */
 	bool system_suspend_allowed;
+	/** Time slice budget on each HART in microseconds (zero if none) */
+	u32 sched_budget_us;
+	/** Time slicing priority (higher runs first) */
+	u32 sched_priority;
 	/** Identifies whether to include the firmware region */
 	bool fw_region_inited;
 };
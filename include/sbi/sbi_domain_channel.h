@@ -0,0 +1,181 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#ifndef __SBI_DOMAIN_CHANNEL_H__
+#define __SBI_DOMAIN_CHANNEL_H__
+
+#include <sbi/sbi_list.h>
+#include <sbi/sbi_types.h>
+
+struct sbi_domain;
+struct sbi_scratch;
+
+/** Version of the channel shared memory layout */
+#define SBI_DOMAIN_CHANNEL_VERSION		1
+
+/** Default number of descriptors in each ring of a channel */
+#define SBI_DOMAIN_CHANNEL_DEFAULT_DESCS	64
+
+/**
+ * Message descriptor
+ *
+ * Payloads stay in the shared memory of the channel, descriptors only
+ * tell the receiver where to find them.
+ */
+struct sbi_domain_channel_desc {
+	/** Offset of the payload from the start of the shared memory */
+	u64 offset;
+	/** Length of the payload in bytes */
+	u32 len;
+	/** Message specific tag (not interpreted by M-mode) */
+	u32 tag;
+};
+
+/**
+ * Single producer single consumer descriptor ring
+ *
+ * The sender writes descriptor number N at index (N % desc_count) and
+ * then updates head to N + 1. The receiver updates tail once it is
+ * done with a descriptor and its payload. Both indices are free
+ * running and live in separate cache lines.
+ */
+struct sbi_domain_channel_ring {
+	/** Number of descriptors produced (written by the sender) */
+	u32 head;
+	u32 reserved0[15];
+	/** Number of descriptors consumed (written by the receiver) */
+	u32 tail;
+	u32 reserved1[15];
+};
+
+/**
+ * Header at the start of the channel shared memory
+ *
+ * ring[N] carries messages sent by end N of the channel. The two
+ * descriptor arrays follow the header and the rest of the shared
+ * memory starting at data_offset is the payload area. How the payload
+ * area is split between both ends is up to the domains.
+ */
+struct sbi_domain_channel_header {
+	/** Layout version (SBI_DOMAIN_CHANNEL_VERSION) */
+	u32 version;
+	/** Number of descriptors in each ring (power of 2) */
+	u32 desc_count;
+	/** Offset of the descriptor array of each ring */
+	u32 desc_offset[2];
+	/** Offset and size of the payload area */
+	u64 data_offset;
+	u64 data_size;
+	u64 reserved[4];
+	struct sbi_domain_channel_ring ring[2];
+};
+
+/** Channel information returned to the lower privilege mode */
+struct sbi_domain_channel_info {
+	/** Physical address of the shared memory */
+	u64 shmem_addr;
+	/** Size of the shared memory in bytes */
+	u64 shmem_size;
+	/** End of the channel used by the calling domain (0 or 1) */
+	u32 end;
+	/** Index of the peer domain */
+	u32 peer_domain;
+	/** Number of descriptors in each ring */
+	u32 desc_count;
+	u32 reserved;
+};
+
+/** One end of a channel */
+struct sbi_domain_channel_end {
+	/** Domain owning this end */
+	struct sbi_domain *dom;
+	/** HART index which receives doorbells for this end */
+	u32 doorbell_hartindex;
+	/** Doorbell rung but not yet delivered to the domain */
+	unsigned long pending;
+};
+
+/** Message channel between two domains */
+struct sbi_domain_channel {
+	/** Node in the list of channels */
+	struct sbi_dlist node;
+	/** Logical index of this channel */
+	u32 index;
+	/** Name of this channel */
+	char name[64];
+	/** Base address of the shared memory */
+	unsigned long shmem_addr;
+	/** Size of the shared memory in bytes */
+	unsigned long shmem_size;
+	/** Number of descriptors in each ring (power of 2) */
+	u32 desc_count;
+	/** Both ends of the channel */
+	struct sbi_domain_channel_end end[2];
+};
+
+#ifdef CONFIG_SBI_DOMAIN_CHANNEL
+
+/**
+ * Register a channel between two domains
+ *
+ * Channels can only be registered before domains are finalized. The
+ * shared memory is checked against both domains when channels are
+ * initialized.
+ *
+ * @param chan pointer to the channel being registered
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_domain_channel_register(struct sbi_domain_channel *chan);
+
+/**
+ * Get information about a channel for the domain of current HART
+ *
+ * @param index logical index of the channel
+ * @param info output channel information
+ *
+ * @return 0 on success, SBI_EINVAL if the channel does not exist and
+ *	   SBI_EDENIED if the domain of current HART is not an end of it
+ */
+int sbi_domain_channel_get_info(u32 index,
+				struct sbi_domain_channel_info *info);
+
+/**
+ * Ring the doorbell of the peer of the domain of current HART
+ *
+ * @param index logical index of the channel
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_domain_channel_notify(u32 index);
+
+/**
+ * Select the HART which receives doorbells for the domain of current
+ * HART
+ *
+ * @param index logical index of the channel
+ * @param hartid HART id which must be a possible HART of the domain
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_domain_channel_set_doorbell(u32 index, u32 hartid);
+
+/** Get the number of registered channels */
+u32 sbi_domain_channel_count(void);
+
+/** Check and initialize the shared memory of all channels */
+int sbi_domain_channel_init(struct sbi_scratch *scratch);
+
+#else
+
+static inline int sbi_domain_channel_init(struct sbi_scratch *scratch)
+{
+	return 0;
+}
+
+#endif
+
+#endif
@@ -10,6 +10,7 @@
 #include <sbi/sbi_types.h>
 
 struct sbi_domain;
+struct sbi_scratch;
 
 /**
  * Enter a specific domain context synchronously
@@ -28,6 +29,20 @@ int sbi_domain_context_enter(struct sbi_domain *dom);
  */
 int sbi_domain_context_exit(void);
 
+/**
+ * Raise supervisor interrupts of a domain on the current HART
+ *
+ * The interrupts are raised right away when the domain runs on the
+ * current HART, otherwise they are raised in its saved context.
+ *
+ * @param dom pointer to domain
+ * @param mask MIP bits writable through the sip CSR
+ *
+ * @return 0 on success and SBI_ENOENT if the domain has no saved
+ *	   context on the current HART
+ */
+int sbi_domain_context_raise_sip(struct sbi_domain *dom, unsigned long mask);
+
 /**
  * Initialize domain context support
  *
@@ -38,4 +53,45 @@ int sbi_domain_context_init(void);
 /* Deinitialize domain context support */
 void sbi_domain_context_deinit(void);
 
+#ifdef CONFIG_SBI_DOMAIN_SCHED
+
+/**
+ * Start time slicing of domains on current HART
+ * @param scratch pointer to scratch space of current HART
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_domain_sched_start(struct sbi_scratch *scratch);
+
+/**
+ * Switch to the next domain if the time slice of the current domain
+ * is over. Called before returning to a lower privilege mode.
+ */
+void sbi_domain_sched_process(void);
+
+/**
+ * Get the time spent by a domain on all HARTs
+ * @param dom pointer to domain
+ *
+ * @return timer ticks spent running the domain, including the current
+ *	   time slice on HARTs where it is running
+ */
+u64 sbi_domain_sched_time(const struct sbi_domain *dom);
+
+#else
+
+static inline int sbi_domain_sched_start(struct sbi_scratch *scratch)
+{
+	return 0;
+}
+
+static inline void sbi_domain_sched_process(void) { }
+
+static inline u64 sbi_domain_sched_time(const struct sbi_domain *dom)
+{
+	return 0;
+}
+
+#endif
+
 #endif // __SBI_DOMAIN_CONTEXT_H__
@@ -0,0 +1,140 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#ifndef __SBI_DOMAIN_STATS_H__
+#define __SBI_DOMAIN_STATS_H__
+
+#include <sbi/sbi_types.h>
+
+struct sbi_domain;
+
+/** Number of SBI extensions accounted separately for each domain */
+#define SBI_DOMAIN_STATS_ECALL_SLOTS	16
+
+/** Per-domain counters (also the index in sbi_domain_stats.counters) */
+enum sbi_domain_stats_counter {
+	/** Timer ticks spent in M-mode handling traps from the domain */
+	SBI_DOMAIN_STATS_MMODE_TIME = 0,
+	/** Traps taken from the domain */
+	SBI_DOMAIN_STATS_TRAPS,
+	/** IPIs sent on behalf of the domain */
+	SBI_DOMAIN_STATS_IPI_SENT,
+	/** IPIs received while a HART runs the domain */
+	SBI_DOMAIN_STATS_IPI_RECVD,
+	/** Remote fence requests made by the domain */
+	SBI_DOMAIN_STATS_RFENCE,
+	/** Traps which may be emulated (illegal, misaligned, access fault) */
+	SBI_DOMAIN_STATS_EMUL_TRAPS,
+	/** Timer ticks spent running the domain (time-sliced scheduling) */
+	SBI_DOMAIN_STATS_SCHED_TIME,
+	SBI_DOMAIN_STATS_MAX,
+};
+
+/** Number of ecalls made to one SBI extension */
+struct sbi_domain_stats_ecall {
+	/** SBI extension ID */
+	u64 extid;
+	/** Number of ecalls */
+	u64 count;
+};
+
+/**
+ * Statistics of a domain summed over all HARTs
+ *
+ * This is also the layout of the buffer filled by the DOMAIN_STATS_READ
+ * function of the OpenSBI firmware specific extension.
+ */
+struct sbi_domain_stats {
+	/** Counters indexed by enum sbi_domain_stats_counter */
+	u64 counters[SBI_DOMAIN_STATS_MAX];
+	/** Number of ecalls not counted because all ecall slots were used */
+	u64 ecalls_dropped;
+	/** Number of valid entries in ecalls */
+	u32 nr_ecalls;
+	u32 reserved;
+	struct sbi_domain_stats_ecall ecalls[SBI_DOMAIN_STATS_ECALL_SLOTS];
+};
+
+/** Trap entry state passed to sbi_domain_stats_trap_end() */
+struct sbi_domain_stats_trap {
+	struct sbi_domain *dom;
+	u64 start;
+};
+
+#ifdef CONFIG_SBI_DOMAIN_STATS
+
+void __sbi_domain_stats_add(enum sbi_domain_stats_counter counter, u64 val);
+
+/** Increment a counter of the domain running on the current HART */
+#define sbi_domain_stats_inc(__counter)					\
+	__sbi_domain_stats_add(SBI_DOMAIN_STATS_##__counter, 1)
+
+/** Count an ecall of the domain running on the current HART */
+void sbi_domain_stats_ecall(unsigned long extid);
+
+/** Save the domain and timer value at trap entry */
+void sbi_domain_stats_trap_begin(struct sbi_domain_stats_trap *trap);
+
+/**
+ * Account a trap from a lower privilege mode to the domain which was
+ * running when the trap was taken
+ *
+ * @param trap state saved by sbi_domain_stats_trap_begin()
+ * @param mcause trap cause
+ */
+void sbi_domain_stats_trap_end(const struct sbi_domain_stats_trap *trap,
+			       unsigned long mcause);
+
+/**
+ * Sum the statistics of a domain over all HARTs
+ *
+ * @param dom pointer to domain
+ * @param out output statistics
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_domain_stats_read(const struct sbi_domain *dom,
+			  struct sbi_domain_stats *out);
+
+/** Print the statistics of a domain on the console */
+void sbi_domain_stats_dump(const struct sbi_domain *dom, const char *suffix);
+
+/** Heap space needed for the statistics of the given number of domains */
+unsigned long sbi_domain_stats_heap_size(u32 domain_count, u32 hart_count);
+
+int sbi_domain_stats_init(void);
+
+void sbi_domain_stats_deinit(void);
+
+#else
+
+#define sbi_domain_stats_inc(__counter)		do { } while (0)
+
+static inline void sbi_domain_stats_ecall(unsigned long extid) { }
+
+static inline void sbi_domain_stats_trap_begin(
+					struct sbi_domain_stats_trap *trap) { }
+
+static inline void sbi_domain_stats_trap_end(
+					const struct sbi_domain_stats_trap *trap,
+					unsigned long mcause) { }
+
+static inline void sbi_domain_stats_dump(const struct sbi_domain *dom,
+					 const char *suffix) { }
+
+static inline unsigned long sbi_domain_stats_heap_size(u32 domain_count,
+							u32 hart_count)
+{
+	return 0;
+}
+
+static inline int sbi_domain_stats_init(void) { return 0; }
+
+static inline void sbi_domain_stats_deinit(void) { }
+
+#endif
+
+#endif
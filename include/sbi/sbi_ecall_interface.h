@@ -236,6 +236,23 @@ enum sbi_pmu_fw_event_code_id {
 	 * Event codes 256 to 65534 are reserved for SBI implementation
 	 * specific custom firmware events.
 	 */
+	SBI_PMU_FW_OPENSBI_START	= 256,
+	/* Misaligned loads/stores emulated without taking a trap */
+	SBI_PMU_FW_MISALIGNED_LOAD_SAVED = SBI_PMU_FW_OPENSBI_START,
+	SBI_PMU_FW_MISALIGNED_STORE_SAVED,
+	/* AMOs emulated using LR/SC on HARTs without Zaamo */
+	SBI_PMU_FW_AMOADD_EMULATED,
+	SBI_PMU_FW_AMOSWAP_EMULATED,
+	SBI_PMU_FW_AMOXOR_EMULATED,
+	SBI_PMU_FW_AMOOR_EMULATED,
+	SBI_PMU_FW_AMOAND_EMULATED,
+	SBI_PMU_FW_AMOMIN_EMULATED,
+	SBI_PMU_FW_AMOMAX_EMULATED,
+	SBI_PMU_FW_AMOMINU_EMULATED,
+	SBI_PMU_FW_AMOMAXU_EMULATED,
+	/* Failed SCs retried while emulating AMOs */
+	SBI_PMU_FW_AMO_SC_RETRY,
+	SBI_PMU_FW_OPENSBI_MAX,
 	SBI_PMU_FW_RESERVED_MAX = 0xFFFE,
 	/*
 	 * Event code 0xFFFF is used for platform specific firmware
@@ -489,6 +506,22 @@ enum sbi_sse_state {
 #define SBI_EXT_FIRMWARE_START			0x0A000000
 #define SBI_EXT_FIRMWARE_END			0x0AFFFFFF
 
+/* SBI firmware specific extension of OpenSBI (i.e. SBI_OPENSBI_IMPID) */
+#define SBI_EXT_OPENSBI				(SBI_EXT_FIRMWARE_START + 0x1)
+
+/* SBI function IDs for OpenSBI firmware specific extension */
+#define SBI_EXT_OPENSBI_LOG_READ		0x0
+#define SBI_EXT_OPENSBI_TRACE_SET_SHMEM		0x1
+#define SBI_EXT_OPENSBI_TRACE_FLUSH		0x2
+#define SBI_EXT_OPENSBI_EMUPROF_READ		0x3
+#define SBI_EXT_OPENSBI_TRAPSTAT_READ		0x4
+#define SBI_EXT_OPENSBI_TRAPSTAT_DUMP		0x5
+#define SBI_EXT_OPENSBI_RESIDENCY_READ		0x6
+#define SBI_EXT_OPENSBI_CHANNEL_INFO		0x7
+#define SBI_EXT_OPENSBI_CHANNEL_NOTIFY		0x8
+#define SBI_EXT_OPENSBI_CHANNEL_SET_DOORBELL	0x9
+#define SBI_EXT_OPENSBI_DOMAIN_STATS_READ	0xa
+
 /* SBI return error codes */
 #define SBI_SUCCESS				0
 #define SBI_ERR_FAILED				-1
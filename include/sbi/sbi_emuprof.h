@@ -0,0 +1,72 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#ifndef __SBI_EMUPROF_H__
+#define __SBI_EMUPROF_H__
+
+#include <sbi/sbi_types.h>
+
+struct sbi_scratch;
+
+/** Reset the profile of the HART after reading it */
+#define SBI_EMUPROF_READ_RESET		(1UL << 0)
+
+/** Header at the start of the buffer filled by sbi_emuprof_read() */
+struct sbi_emuprof_header {
+	/** Number of emulations not counted because the table was full */
+	u64 dropped;
+	/** Number of entries following the header */
+	u32 nr_entries;
+	/** HART id which owns the profile */
+	u32 hartid;
+};
+
+/** Emulation count of one lower privilege mode instruction */
+struct sbi_emuprof_entry {
+	/** Address of the emulated instruction */
+	u64 pc;
+	/** Number of times the instruction was emulated */
+	u64 count;
+	/** Trap cause (mcause) which lead to the emulation */
+	u64 cause;
+	/** Instruction encoding */
+	u64 insn;
+};
+
+#ifdef CONFIG_SBI_EMUPROF
+
+/** Count one emulation of the instruction at pc on the current HART */
+void sbi_emuprof_record(ulong cause, ulong pc, ulong insn);
+
+/**
+ * Read the emulation profile of a HART
+ *
+ * @param hartindex HART index of the profile to read
+ * @param flags SBI_EMUPROF_READ_xyz flags
+ * @param out destination buffer (header followed by entries)
+ * @param size size of the destination buffer in bytes
+ *
+ * @return number of entries written after the header
+ */
+unsigned long sbi_emuprof_read(u32 hartindex, unsigned long flags,
+			       void *out, unsigned long size);
+
+/** Heap space needed by sbi_emuprof_init() for the emulation profiles of all HARTs */
+unsigned long sbi_emuprof_heap_size(u32 hart_count);
+
+int sbi_emuprof_init(struct sbi_scratch *scratch);
+
+#else
+
+static inline void sbi_emuprof_record(ulong cause, ulong pc, ulong insn) { }
+
+static inline unsigned long sbi_emuprof_heap_size(u32 hart_count) { return 0; }
+
+static inline int sbi_emuprof_init(struct sbi_scratch *scratch) { return 0; }
+
+#endif
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#ifndef __SBI_FWLOG_H__
+#define __SBI_FWLOG_H__
+
+#include <sbi/sbi_types.h>
+
+struct sbi_scratch;
+
+/** Maximum message length of a firmware log record */
+#define SBI_FWLOG_MSG_SIZE		104
+
+/**
+ * Firmware log record as seen by S-mode software
+ *
+ * A record is valid only when seq is non-zero. The seq starts from 1
+ * on each HART and increments by one for every new record so gaps in
+ * seq tell the reader how many records were overwritten.
+ */
+struct sbi_fwlog_record {
+	/** Per-HART sequence number of this record */
+	u64 seq;
+	/** Value of sbi_timer_value() when the record was written */
+	u64 timestamp;
+	/** HART id which wrote the record */
+	u32 hartid;
+	/** Number of valid bytes in msg */
+	u32 len;
+	/** Message bytes (not NUL terminated) */
+	char msg[SBI_FWLOG_MSG_SIZE];
+};
+
+#ifdef CONFIG_SBI_FWLOG
+
+/** Append a message to the firmware log of the current HART */
+void sbi_fwlog_write(const char *msg, unsigned long len);
+
+/**
+ * Read records from the firmware log of a HART
+ *
+ * @param hartindex HART index of the firmware log to read
+ * @param start_seq first sequence number to read
+ * @param out destination for the records
+ * @param max_records maximum number of records to read
+ *
+ * @return number of records written to out
+ */
+unsigned long sbi_fwlog_read(u32 hartindex, u64 start_seq,
+			     struct sbi_fwlog_record *out,
+			     unsigned long max_records);
+
+/** Heap space needed by sbi_fwlog_init() for the firmware logs of all HARTs */
+unsigned long sbi_fwlog_heap_size(u32 hart_count);
+
+int sbi_fwlog_init(struct sbi_scratch *scratch);
+
+#else
+
+static inline void sbi_fwlog_write(const char *msg, unsigned long len) { }
+
+static inline unsigned long sbi_fwlog_read(u32 hartindex, u64 start_seq,
+					   struct sbi_fwlog_record *out,
+					   unsigned long max_records)
+{
+	return 0;
+}
+
+static inline unsigned long sbi_fwlog_heap_size(u32 hart_count) { return 0; }
+
+static inline int sbi_fwlog_init(struct sbi_scratch *scratch) { return 0; }
+
+#endif
+
+#endif
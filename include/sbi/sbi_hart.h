@@ -95,6 +95,8 @@ enum sbi_hart_extensions {
 	SBI_HART_EXT_F,
 	/** Hart has D extension */
 	SBI_HART_EXT_D,
+	/** Hart has Zbb extension */
+	SBI_HART_EXT_ZBB,
 
 	/** Maximum index of Hart extension */
 	SBI_HART_EXT_MAX,
@@ -134,6 +136,7 @@ struct sbi_scratch;
 
 int sbi_hart_reinit(struct sbi_scratch *scratch);
 int sbi_hart_init(struct sbi_scratch *scratch, bool cold_boot);
+int sbi_hart_early_init(struct sbi_scratch *scratch);
 
 extern void (*sbi_hart_expected_trap)(void);
 
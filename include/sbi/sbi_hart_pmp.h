@@ -30,4 +30,34 @@ bool sbi_hart_smepmp_is_fw_region(unsigned int pmp_idx);
 void sbi_hart_pmp_fence(void);
 int sbi_hart_pmp_init(struct sbi_scratch *scratch);
 
+#ifdef CONFIG_SBIUNIT
+struct sbi_domain;
+struct hart_pmp_image;
+
+/**
+ * Build the PMP image of a domain for the given PMP parameters
+ *
+ * Only available to unit tests. The image must be freed with sbi_free().
+ *
+ * @return pointer to the image or NULL if it can't be built
+ */
+struct hart_pmp_image *sbi_hart_pmp_test_image(struct sbi_domain *dom,
+					       unsigned int pmp_count,
+					       unsigned int pmp_log2gran,
+					       unsigned int pmp_addr_bits,
+					       bool smepmp);
+
+/**
+ * Find the entry of a PMP image which matches an address first
+ *
+ * @param img PMP image built by sbi_hart_pmp_test_image()
+ * @param addr address to look up
+ * @param cfg pmpcfg value of the matching entry (zero if none)
+ *
+ * @return index of the matching entry or -1 if no entry matches
+ */
+int sbi_hart_pmp_test_match(const struct hart_pmp_image *img,
+			    unsigned long addr, unsigned long *cfg);
+#endif
+
 #endif
@@ -40,6 +40,21 @@ struct sbi_hart_protection {
 	/** Unconfigure protection for current HART (Optional) */
 	void (*unconfigure)(struct sbi_scratch *scratch, struct sbi_domain *dom);
 
+	/** Precompute protection state of a finalized domain (Optional) */
+	void (*prepare)(struct sbi_scratch *scratch, struct sbi_domain *dom);
+
+	/**
+	 * Switch protection of current HART between domains (Optional)
+	 *
+	 * Returns a positive value when address translation caches were
+	 * flushed, zero when nothing changed and negative error code on
+	 * failure. Without this callback, unconfigure and configure are
+	 * used.
+	 */
+	int (*reconfigure)(struct sbi_scratch *scratch,
+			   struct sbi_domain *current_dom,
+			   struct sbi_domain *next_dom);
+
 	/** Create temporary mapping to access address range on current HART (Optional) */
 	int (*map_range)(struct sbi_scratch *scratch,
 			 unsigned long base, unsigned long size);
@@ -47,6 +62,17 @@ struct sbi_hart_protection {
 	/** Destroy temporary mapping on current HART (Optional) */
 	int (*unmap_range)(struct sbi_scratch *scratch,
 			   unsigned long base, unsigned long size);
+
+	/** Keep mapping of registered shared memory on current HART (Optional) */
+	int (*keep_range)(struct sbi_scratch *scratch,
+			  unsigned long base, unsigned long size);
+
+	/** Stop keeping mapping of shared memory on current HART (Optional) */
+	void (*forget_range)(struct sbi_scratch *scratch,
+			     unsigned long base, unsigned long size);
+
+	/** Drop temporary mappings before current HART leaves M-mode (Optional) */
+	void (*release_ranges)(struct sbi_scratch *scratch);
 };
 
 /**
@@ -97,6 +123,17 @@ int sbi_hart_protection_configure(struct sbi_scratch *scratch,
 void sbi_hart_protection_unconfigure(struct sbi_scratch *scratch,
 				     struct sbi_domain *dom);
 
+/**
+ * Precompute protection state of a domain
+ *
+ * Called once for each domain when domains are finalized.
+ *
+ * @param scratch pointer to scratch space of current HART
+ * @param dom pointer to the finalized domain
+ */
+void sbi_hart_protection_prepare(struct sbi_scratch *scratch,
+				 struct sbi_domain *dom);
+
 /**
  * Re-configure protection for current HART
  *
@@ -105,6 +142,9 @@ void sbi_hart_protection_unconfigure(struct sbi_scratch *scratch,
  *        HART protection is being unconfigured
  * @param next_dom pointer to the next domain for which HART
  *        protection is being configured
+ *
+ * @return positive value if address translation caches were flushed,
+ *	   zero if they were not and negative error code on failure
  */
 int sbi_hart_protection_reconfigure(struct sbi_scratch *scratch,
 				    struct sbi_domain *current_dom,
@@ -130,4 +170,35 @@ int sbi_hart_protection_map_range(unsigned long base, unsigned long size);
  */
 int sbi_hart_protection_unmap_range(unsigned long base, unsigned long size);
 
+/**
+ * Keep mapping of shared memory registered by the current domain
+ *
+ * A kept mapping may stay in place while the current HART runs in
+ * a lower privilege mode so that later accesses don't need to create
+ * it again. Mappings which can't be kept exactly are still created
+ * and destroyed for each access.
+ *
+ * @param base base address of the shared memory
+ * @param size size of the shared memory
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_hart_protection_keep_range(unsigned long base, unsigned long size);
+
+/**
+ * Stop keeping mapping of shared memory on current HART
+ *
+ * @param base base address of the shared memory
+ * @param size size of the shared memory
+ */
+void sbi_hart_protection_forget_range(unsigned long base, unsigned long size);
+
+/**
+ * Drop temporary mappings before current HART leaves M-mode
+ *
+ * Called when returning to a lower privilege mode. Only the mapping
+ * of kept shared memory survives.
+ */
+void sbi_hart_protection_release_ranges(void);
+
 #endif /* __SBI_HART_PROTECTION_H__ */
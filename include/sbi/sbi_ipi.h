@@ -76,6 +76,8 @@ struct sbi_ipi_event_ops {
 
 int sbi_ipi_send_many(ulong hmask, ulong hbase, u32 event, void *data);
 
+int sbi_ipi_send_hartindex(u32 hartindex, u32 event, void *data);
+
 int sbi_ipi_event_create(const struct sbi_ipi_event_ops *ops);
 
 void sbi_ipi_event_destroy(u32 event);
@@ -0,0 +1,105 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#ifndef __SBI_RESIDENCY_H__
+#define __SBI_RESIDENCY_H__
+
+#include <sbi/sbi_types.h>
+
+struct sbi_scratch;
+struct sbi_trap_context;
+
+/** Maximum number of firmware return addresses in a residency record */
+#define SBI_RESIDENCY_FRAMES		8
+
+/** Snapshot of one M-mode stay longer than the threshold */
+struct sbi_residency_record {
+	/** Value of sbi_timer_value() when M-mode was entered */
+	u64 timestamp;
+	/** Time spent in M-mode (timer ticks) */
+	u64 duration;
+	/** Trap cause which lead to the stay */
+	u64 mcause;
+	/** Lower privilege mode PC of the trap */
+	u64 mepc;
+	/** SBI extension and function IDs (ecalls only) */
+	u64 extid;
+	u64 fid;
+	/** Number of valid entries in backtrace */
+	u64 nr_frames;
+	/** Firmware return addresses, innermost first */
+	u64 backtrace[SBI_RESIDENCY_FRAMES];
+};
+
+/** M-mode residency statistics of a HART */
+struct sbi_residency_info {
+	/** Threshold above which stays are recorded (timer ticks) */
+	u64 threshold;
+	/** Longest stay seen so far (timer ticks) */
+	u64 max_duration;
+	/** Number of stays longer than the threshold */
+	u64 nr_exceeded;
+	/** HART id which owns the statistics */
+	u64 hartid;
+	/** Longest stay over the threshold */
+	struct sbi_residency_record worst;
+	/** Most recent stay over the threshold */
+	struct sbi_residency_record last;
+};
+
+#ifdef CONFIG_SBI_RESIDENCY
+
+/** Note that the current HART entered M-mode from a lower mode */
+void sbi_residency_enter(const struct sbi_trap_context *tcntx);
+
+/** Note that the current HART is about to return to a lower mode */
+void sbi_residency_exit(const struct sbi_trap_context *tcntx);
+
+/**
+ * Capture a firmware backtrace if the current M-mode stay already
+ * exceeds the threshold. Called from places where M-mode can wait
+ * for a long time.
+ */
+void sbi_residency_check(void);
+
+/**
+ * Get the M-mode residency statistics of a HART
+ *
+ * @param hartindex HART index of the statistics to read
+ * @param out destination for the statistics
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_residency_get(u32 hartindex, struct sbi_residency_info *out);
+
+/**
+ * Overwrite the M-mode residency statistics of a HART
+ *
+ * Only available to unit tests which restore the statistics they
+ * changed so that S-mode never sees the records they injected.
+ *
+ * @param hartindex HART index of the statistics to write
+ * @param in new statistics
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_residency_set(u32 hartindex, const struct sbi_residency_info *in);
+
+int sbi_residency_init(struct sbi_scratch *scratch);
+
+#else
+
+static inline void sbi_residency_enter(const struct sbi_trap_context *tcntx) { }
+
+static inline void sbi_residency_exit(const struct sbi_trap_context *tcntx) { }
+
+static inline void sbi_residency_check(void) { }
+
+static inline int sbi_residency_init(struct sbi_scratch *scratch) { return 0; }
+
+#endif
+
+#endif
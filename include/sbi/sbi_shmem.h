@@ -0,0 +1,61 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#ifndef __SBI_SHMEM_H__
+#define __SBI_SHMEM_H__
+
+#include <sbi/sbi_types.h>
+
+/*
+ * Shared memory passed by the lower privilege mode
+ *
+ * SBI extensions validate shared memory with sbi_shmem_check() and
+ * access it between sbi_hart_protection_map_range() and
+ * sbi_hart_protection_unmap_range(). Shared memory which stays
+ * registered across SBI calls is also passed to sbi_shmem_register()
+ * so that the mapping can be kept instead of being created again for
+ * every access.
+ */
+
+/**
+ * Check shared memory passed by the lower privilege mode
+ *
+ * M-mode can only access the first XLEN bits of the physical address
+ * space so the upper part of the physical address must be zero.
+ *
+ * @param mode privilege mode which passed the shared memory
+ * @param addr_lo lower XLEN bits of the physical address
+ * @param addr_hi upper XLEN bits of the physical address
+ * @param size size of the shared memory in bytes
+ * @param align required alignment of the physical address (power of 2)
+ * @param access SBI_DOMAIN_READ and/or SBI_DOMAIN_WRITE
+ *
+ * @return 0 on success, SBI_EINVAL if the address is not aligned and
+ *	   SBI_EINVALID_ADDR if the memory is not accessible by the given
+ *	   mode in the domain of current HART
+ */
+int sbi_shmem_check(unsigned long mode, unsigned long addr_lo,
+		    unsigned long addr_hi, unsigned long size,
+		    unsigned long align, unsigned long access);
+
+/**
+ * Register shared memory of current HART which stays in use across
+ * SBI calls
+ *
+ * @param addr physical address of the shared memory (already checked)
+ * @param size size of the shared memory in bytes
+ */
+void sbi_shmem_register(unsigned long addr, unsigned long size);
+
+/**
+ * Unregister shared memory of current HART
+ *
+ * @param addr physical address of the shared memory
+ * @param size size of the shared memory in bytes
+ */
+void sbi_shmem_unregister(unsigned long addr, unsigned long size);
+
+#endif
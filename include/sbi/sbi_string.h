@@ -43,4 +43,7 @@ int sbi_memcmp(const void *s1, const void *s2, size_t count);
 
 void *sbi_memchr(const void *s, int c, size_t count);
 
+/* Select the Zbb based string functions (CONFIG_SBI_STRING_ZBB only) */
+void sbi_string_use_zbb(bool enable);
+
 #endif
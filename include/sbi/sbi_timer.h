@@ -76,6 +76,12 @@ struct sbi_timer_device {
 	/** Get free-running timer value */
 	u64 (*timer_value)(void);
 
+	/**
+	 * Get address of the free-running timer value of current HART
+	 * if it can be read with a single 64-bit load (optional)
+	 */
+	unsigned long (*timer_value_addr)(void);
+
 	/** Start timer event for current HART */
 	void (*timer_event_start)(u64 next_event);
 
@@ -88,6 +94,14 @@ struct sbi_timer_device {
 
 struct sbi_scratch;
 
+#ifdef CONFIG_SBI_FAST_COUNTER_EMUL
+/**
+ * Scratch offset of the timer value address of each HART used by
+ * the counter read fast path of the trap entry (zero if unused)
+ */
+extern unsigned long sbi_timer_fast_addr_offset;
+#endif
+
 /** Compute timer value delta based on arbitary units */
 u64 sbi_timer_compute_delta(ulong units, u64 unit_freq);
 
@@ -178,6 +192,15 @@ void sbi_timer_event_stop(struct sbi_timer_event *ev);
 /** Start supervisor timer event on current HART */
 void sbi_timer_smode_event_start(u64 next_event);
 
+/**
+ * Replace supervisor timer event of current HART
+ *
+ * @param next_event time stamp of the new event (-1ULL for none)
+ *
+ * @return time stamp of the replaced event (-1ULL if there was none)
+ */
+u64 sbi_timer_smode_event_switch(u64 next_event);
+
 /** Process timer event for current HART */
 void sbi_timer_process(void);
 
@@ -0,0 +1,119 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#ifndef __SBI_TRACE_H__
+#define __SBI_TRACE_H__
+
+#include <sbi/sbi_types.h>
+
+struct sbi_scratch;
+
+/** Trace event IDs (also the bit position in the event mask) */
+enum sbi_trace_event_id {
+	SBI_TRACE_EVENT_TRAP_ENTRY = 0,
+	SBI_TRACE_EVENT_TRAP_EXIT,
+	SBI_TRACE_EVENT_ECALL,
+	SBI_TRACE_EVENT_IPI_SEND,
+	SBI_TRACE_EVENT_IPI_RECV,
+	SBI_TRACE_EVENT_TLB_ENQUEUE,
+	SBI_TRACE_EVENT_TLB_PROCESS,
+	SBI_TRACE_EVENT_TIMER_FIRE,
+	SBI_TRACE_EVENT_HSM_STATE,
+	SBI_TRACE_EVENT_DOMAIN_SWITCH,
+	SBI_TRACE_EVENT_MAX,
+};
+
+/** Version of the trace shared memory layout */
+#define SBI_TRACE_SHMEM_VERSION		1
+
+/**
+ * Header at the start of the trace shared memory
+ *
+ * The header is followed by nr_records records of record_size bytes.
+ * M-mode writes record number N at index (N % nr_records) and then
+ * updates head to N + 1, so the valid records are the last
+ * min(head, nr_records) ones.
+ */
+struct sbi_trace_shmem_header {
+	/** Total number of records written to the shared memory */
+	u64 head;
+	/** Number of records dropped before reaching the shared memory */
+	u64 lost;
+	/** Layout version (SBI_TRACE_SHMEM_VERSION) */
+	u32 version;
+	/** Size of each record in bytes */
+	u32 record_size;
+	/** Number of records in the shared memory */
+	u32 nr_records;
+	/** HART id which owns the shared memory */
+	u32 hartid;
+	u64 reserved[4];
+};
+
+/** Binary trace record */
+struct sbi_trace_record {
+	/** Value of sbi_timer_value() when the event happened */
+	u64 timestamp;
+	/** Event ID (enum sbi_trace_event_id) */
+	u16 event;
+	u16 reserved;
+	/** HART id which recorded the event */
+	u32 hartid;
+	/** Event specific arguments */
+	u64 arg0;
+	u64 arg1;
+};
+
+#ifdef CONFIG_SBI_TRACE
+
+void __sbi_trace(u32 event, unsigned long arg0, unsigned long arg1);
+
+/** Record a trace event on the current HART */
+#define sbi_trace(__event, __arg0, __arg1)				\
+	__sbi_trace(SBI_TRACE_EVENT_##__event, (unsigned long)(__arg0),	\
+		    (unsigned long)(__arg1))
+
+/** Copy staged records of the current HART to its shared memory */
+void sbi_trace_flush(void);
+
+/** Flush staged records if enough of them are pending */
+void sbi_trace_process(void);
+
+/**
+ * Set the trace shared memory of the current HART
+ *
+ * @param addr physical address of the shared memory (validated by caller)
+ * @param size size of the shared memory in bytes
+ * @param event_mask bitmask of enabled events
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_trace_set_shmem(unsigned long addr, unsigned long size,
+			unsigned long event_mask);
+
+/** Disable tracing on the current HART and forget its shared memory */
+void sbi_trace_disable(void);
+
+/** Heap space needed by sbi_trace_init() for the trace state of all HARTs */
+unsigned long sbi_trace_heap_size(u32 hart_count);
+
+int sbi_trace_init(struct sbi_scratch *scratch);
+
+#else
+
+#define sbi_trace(__event, __arg0, __arg1)	do { } while (0)
+
+static inline void sbi_trace_flush(void) { }
+
+static inline void sbi_trace_process(void) { }
+
+static inline unsigned long sbi_trace_heap_size(u32 hart_count) { return 0; }
+
+static inline int sbi_trace_init(struct sbi_scratch *scratch) { return 0; }
+
+#endif
+
+#endif
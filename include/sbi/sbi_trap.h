@@ -350,6 +350,9 @@ struct sbi_trap_context *sbi_trap_handler(struct sbi_trap_context *tcntx);
 
 struct sbi_trap_context *sbi_trap_rnmi_handler(struct sbi_trap_context *tcntx);
 
+struct sbi_trap_context *sbi_trap_irq_handler(struct sbi_trap_context *tcntx,
+					      unsigned long irq);
+
 int sbi_trap_init(struct sbi_scratch *scratch, bool cold_boot);
 
 #endif
@@ -0,0 +1,119 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#ifndef __SBI_TRAPSTAT_H__
+#define __SBI_TRAPSTAT_H__
+
+#include <sbi/sbi_timer.h>
+#include <sbi/sbi_types.h>
+
+struct sbi_scratch;
+
+/** Number of latency histogram buckets */
+#define SBI_TRAPSTAT_BUCKETS		16
+
+/** Reset the statistics of the HART after reading them */
+#define SBI_TRAPSTAT_READ_RESET		(1UL << 0)
+
+/** Types of trap statistics entries */
+enum sbi_trapstat_type {
+	/** Exception (key is mcause) */
+	SBI_TRAPSTAT_TYPE_EXCEPTION = 0,
+	/** Interrupt (key is mcause without the interrupt bit) */
+	SBI_TRAPSTAT_TYPE_INTERRUPT,
+	/** Environment call (key is the SBI extension ID) */
+	SBI_TRAPSTAT_TYPE_ECALL,
+};
+
+/** Header at the start of the buffer filled by sbi_trapstat_read() */
+struct sbi_trapstat_header {
+	/** Number of ecalls not counted because all ecall slots were used */
+	u64 dropped;
+	/** Number of entries following the header */
+	u32 nr_entries;
+	/** HART id which owns the statistics */
+	u32 hartid;
+};
+
+/**
+ * M-mode time spent on one kind of trap
+ *
+ * Latencies are measured in timer ticks from entry to exit of
+ * sbi_trap_handler(). Bucket 0 of the histogram counts latencies
+ * below one tick and bucket N counts latencies in the range
+ * [2^(N-1), 2^N) with the last bucket also counting all longer
+ * latencies.
+ */
+struct sbi_trapstat_entry {
+	/** Cause or SBI extension ID depending on type */
+	u64 key;
+	/** Entry type (enum sbi_trapstat_type) */
+	u32 type;
+	u32 reserved;
+	/** Number of traps */
+	u64 count;
+	/** Sum of all latencies */
+	u64 total_ticks;
+	/** Worst latency */
+	u64 max_ticks;
+	/** Latency histogram */
+	u32 hist[SBI_TRAPSTAT_BUCKETS];
+};
+
+#ifdef CONFIG_SBI_TRAPSTAT
+
+/** Timer value at trap entry, passed to sbi_trapstat_record() */
+static inline u64 sbi_trapstat_begin(void)
+{
+	return sbi_timer_value();
+}
+
+/**
+ * Account a trap handled by the current HART
+ *
+ * @param mcause trap cause
+ * @param extid SBI extension ID when mcause is an ecall
+ * @param start value returned by sbi_trapstat_begin() at trap entry
+ */
+void sbi_trapstat_record(unsigned long mcause, unsigned long extid,
+			 u64 start);
+
+/**
+ * Read the trap statistics of a HART
+ *
+ * @param hartindex HART index of the statistics to read
+ * @param flags SBI_TRAPSTAT_READ_xyz flags
+ * @param out destination buffer (header followed by entries)
+ * @param size size of the destination buffer in bytes
+ *
+ * @return number of entries written after the header
+ */
+unsigned long sbi_trapstat_read(u32 hartindex, unsigned long flags,
+				void *out, unsigned long size);
+
+/** Print the trap statistics of a HART on the console */
+void sbi_trapstat_dump(u32 hartindex);
+
+/** Heap space needed by sbi_trapstat_init() for the trap statistics of all HARTs */
+unsigned long sbi_trapstat_heap_size(u32 hart_count);
+
+int sbi_trapstat_init(struct sbi_scratch *scratch);
+
+#else
+
+static inline u64 sbi_trapstat_begin(void) { return 0; }
+
+static inline void sbi_trapstat_record(unsigned long mcause,
+				       unsigned long extid,
+				       u64 start) { }
+
+static inline unsigned long sbi_trapstat_heap_size(u32 hart_count) { return 0; }
+
+static inline int sbi_trapstat_init(struct sbi_scratch *scratch) { return 0; }
+
+#endif
+
+#endif
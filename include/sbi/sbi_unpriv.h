@@ -36,11 +36,37 @@ DECLARE_UNPRIVILEGED_LOAD_FUNCTION(u64)
 DECLARE_UNPRIVILEGED_STORE_FUNCTION(u64)
 DECLARE_UNPRIVILEGED_LOAD_FUNCTION(ulong)
 
-void sbi_load_loop(u8 *buffer, ulong addr, ulong len,
-		   struct sbi_trap_info *trap);
+/**
+ * Copy a buffer from lower privilege mode memory
+ *
+ * @param dst M-mode destination buffer
+ * @param src lower privilege mode source address
+ * @param len number of bytes to copy
+ * @param trap details of the faulting access (cause is zero if none)
+ *
+ * @return number of bytes copied before the faulting access
+ */
+ulong sbi_copy_from_lower(void *dst, ulong src, ulong len,
+			  struct sbi_trap_info *trap);
+
+/**
+ * Copy a buffer to lower privilege mode memory
+ *
+ * @param dst lower privilege mode destination address
+ * @param src M-mode source buffer
+ * @param len number of bytes to copy
+ * @param trap details of the faulting access (cause is zero if none)
+ *
+ * @return number of bytes copied before the faulting access
+ */
+ulong sbi_copy_to_lower(ulong dst, const void *src, ulong len,
+			struct sbi_trap_info *trap);
+
+ulong sbi_load_ulong_pair(const ulong *addr, ulong *hi,
+			  struct sbi_trap_info *trap);
 
-void sbi_store_loop(u8 *buffer, ulong addr, ulong len,
-		    struct sbi_trap_info *trap);
+void sbi_store_ulong_bytes(u8 *addr, ulong val, ulong len,
+			   struct sbi_trap_info *trap);
 
 ulong sbi_get_insn(ulong mepc, struct sbi_trap_info *trap);
 
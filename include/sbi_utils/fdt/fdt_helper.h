@@ -38,6 +38,9 @@ int fdt_parse_phandle_with_args(const void *fdt, int nodeoff,
 				const char *prop, const char *cells_prop,
 				int index, struct fdt_phandle_args *out_args);
 
+int fdt_parse_interrupt(const void *fdt, int nodeoff, int index,
+			struct fdt_phandle_args *out_args);
+
 int fdt_get_node_addr_size(const void *fdt, int node, int index,
 			   uint64_t *addr, uint64_t *size);
 
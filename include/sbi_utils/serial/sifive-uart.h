@@ -14,4 +14,6 @@
 
 int sifive_uart_init(unsigned long base, u32 in_freq, u32 baudrate);
 
+void sifive_uart_set_tx_irq(u32 irqchip_id, u32 hwirq);
+
 #endif
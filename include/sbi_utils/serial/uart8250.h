@@ -13,6 +13,13 @@
 #include <sbi/sbi_types.h>
 
 #define UART_CAP_UUE	BIT(0)	/* Check UUE capability for XScale PXA UARTs */
+#define UART_CAP_DW_CPR	BIT(1)	/* Read FIFO depth from DesignWare CPR register */
+
+/* TX FIFO depth in bytes, no FIFO is assumed when zero */
+#define UART_CAP_FIFO_SIZE_SHIFT	16
+#define UART_CAP_FIFO_SIZE_MASK		(0xffffUL << UART_CAP_FIFO_SIZE_SHIFT)
+#define UART_CAP_FIFO_SIZE(__sz)	\
+	(((u32)(__sz) << UART_CAP_FIFO_SIZE_SHIFT) & UART_CAP_FIFO_SIZE_MASK)
 
 struct uart8250_device {
 	volatile char *base;
@@ -20,6 +27,7 @@ struct uart8250_device {
 	u32 baudrate;
 	u32 reg_width;
 	u32 reg_shift;
+	u32 fifo_size;
 };
 
 int uart8250_device_getc(struct uart8250_device *dev);
@@ -33,4 +41,6 @@ void uart8250_device_init(struct uart8250_device *dev, unsigned long base,
 int uart8250_init(unsigned long base, u32 in_freq, u32 baudrate, u32 reg_shift,
 		  u32 reg_width, u32 reg_offset, u32 caps);
 
+void uart8250_set_tx_irq(u32 irqchip_id, u32 hwirq);
+
 #endif
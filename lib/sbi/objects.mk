@@ -55,6 +55,9 @@ libsbi-objs-$(CONFIG_SBI_ECALL_LEGACY) += sbi_ecall_legacy.o
 carray-sbi_ecall_exts-$(CONFIG_SBI_ECALL_VENDOR) += ecall_vendor
 libsbi-objs-$(CONFIG_SBI_ECALL_VENDOR) += sbi_ecall_vendor.o
 
+carray-sbi_ecall_exts-$(CONFIG_SBI_ECALL_OPENSBI) += ecall_opensbi
+libsbi-objs-$(CONFIG_SBI_ECALL_OPENSBI) += sbi_ecall_opensbi.o
+
 carray-sbi_ecall_exts-$(CONFIG_SBI_ECALL_DBTR) += ecall_dbtr
 libsbi-objs-$(CONFIG_SBI_ECALL_DBTR) += sbi_ecall_dbtr.o
 
@@ -67,13 +70,20 @@ libsbi-objs-$(CONFIG_SBI_ECALL_MPXY) += sbi_ecall_mpxy.o
 libsbi-objs-y += sbi_bitmap.o
 libsbi-objs-y += sbi_bitops.o
 libsbi-objs-y += sbi_console.o
+libsbi-objs-$(CONFIG_SBI_DOMAIN_CHANNEL) += sbi_domain_channel.o
 libsbi-objs-y += sbi_domain_context.o
 libsbi-objs-y += sbi_domain_data.o
+libsbi-objs-$(CONFIG_SBI_DOMAIN_STATS) += sbi_domain_stats.o
 libsbi-objs-y += sbi_domain.o
 libsbi-objs-y += sbi_double_trap.o
 libsbi-objs-y += sbi_emulate_csr.o
 libsbi-objs-y += sbi_fifo.o
 libsbi-objs-y += sbi_fwft.o
+libsbi-objs-$(CONFIG_SBI_FWLOG) += sbi_fwlog.o
+libsbi-objs-$(CONFIG_SBI_TRACE) += sbi_trace.o
+libsbi-objs-$(CONFIG_SBI_EMUPROF) += sbi_emuprof.o
+libsbi-objs-$(CONFIG_SBI_TRAPSTAT) += sbi_trapstat.o
+libsbi-objs-$(CONFIG_SBI_RESIDENCY) += sbi_residency.o
 libsbi-objs-y += sbi_hart.o
 libsbi-objs-y += sbi_hart_pmp.o
 libsbi-objs-y += sbi_hart_protection.o
@@ -92,6 +102,7 @@ libsbi-objs-y += sbi_pmu.o
 libsbi-objs-y += sbi_dbtr.o
 libsbi-objs-y += sbi_mpxy.o
 libsbi-objs-y += sbi_scratch.o
+libsbi-objs-y += sbi_shmem.o
 libsbi-objs-y += sbi_sse.o
 libsbi-objs-y += sbi_string.o
 libsbi-objs-y += sbi_system.o
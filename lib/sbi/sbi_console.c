@@ -9,17 +9,19 @@
 
 #include <sbi/riscv_locks.h>
 #include <sbi/sbi_console.h>
+#include <sbi/sbi_error.h>
 #include <sbi/sbi_fifo.h>
+#include <sbi/sbi_fwlog.h>
 #include <sbi/sbi_hart.h>
+#include <sbi/sbi_heap.h>
 #include <sbi/sbi_platform.h>
+#include <sbi/sbi_residency.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_string.h>
 
 #define CONSOLE_TBUF_MAX 256
 
 static const struct sbi_console_device *console_dev = NULL;
-static char console_tbuf[CONSOLE_TBUF_MAX];
-static u32 console_tbuf_len;
 static spinlock_t console_out_lock	       = SPIN_LOCK_INITIALIZER;
 
 #ifdef CONFIG_CONSOLE_EARLY_BUFFER_SIZE
@@ -31,6 +33,31 @@ static char console_early_buffer[CONSOLE_EARLY_BUFFER_SIZE] = { 0 };
 static SBI_FIFO_DEFINE(console_early_fifo, console_early_buffer, \
 		       CONSOLE_EARLY_BUFFER_SIZE, sizeof(char));
 
+#ifdef CONFIG_CONSOLE_TX_BUFFER_SIZE
+#define CONSOLE_TX_BUFFER_SIZE		CONFIG_CONSOLE_TX_BUFFER_SIZE
+#else
+#define CONSOLE_TX_BUFFER_SIZE		0
+#endif
+
+/*
+ * Interrupt-driven transmit ring buffer. It is only used when the
+ * console device provides transmit interrupt support and the ring
+ * buffer is enabled at compile time. The ring buffer is protected
+ * by console_tx_lock because sbi_putc() is called without holding
+ * the console_out_lock.
+ */
+static const struct sbi_console_device *console_tx_dev = NULL;
+static char *console_tx_buf;
+static u32 console_tx_size;
+static u32 console_tx_head;
+static u32 console_tx_count;
+static spinlock_t console_tx_lock	       = SPIN_LOCK_INITIALIZER;
+/* Set by sbi_panic() to write synchronously without the ring buffer */
+static bool console_tx_bypass;
+
+/* Attempts of sbi_panic() to take console_tx_lock before giving up */
+#define CONSOLE_PANIC_TRYLOCK_LOOPS	100000
+
 bool sbi_isprintable(char c)
 {
 	if (((31 < c) && (c < 127)) || (c == '\f') || (c == '\r') ||
@@ -47,12 +74,81 @@ int sbi_getc(void)
 	return -1;
 }
 
+/* Note: Must be called with console_tx_lock held */
+static void console_tx_drain(void)
+{
+	unsigned long n;
+
+	while (console_tx_count) {
+		n = console_tx_size - console_tx_head;
+		if (console_tx_count < n)
+			n = console_tx_count;
+		n = console_tx_dev->console_tx_try_puts(
+					&console_tx_buf[console_tx_head], n);
+		if (!n)
+			break;
+		console_tx_head = (console_tx_head + n) % console_tx_size;
+		console_tx_count -= n;
+	}
+}
+
+/* Note: Must be called with console_tx_lock held */
+static void console_tx_putc(char ch)
+{
+	/* Ring buffer is full so wait for the device to make progress */
+	while (console_tx_count == console_tx_size)
+		console_tx_drain();
+
+	console_tx_buf[(console_tx_head + console_tx_count) %
+		       console_tx_size] = ch;
+	console_tx_count++;
+}
+
+static unsigned long nputs_buffered(const char *str, unsigned long len)
+{
+	unsigned long i;
+
+	spin_lock(&console_tx_lock);
+	for (i = 0; i < len; i++) {
+		if (str[i] == '\n')
+			console_tx_putc('\r');
+		console_tx_putc(str[i]);
+	}
+	console_tx_drain();
+	if (console_tx_count)
+		console_tx_dev->console_tx_irq_enable(true);
+	spin_unlock(&console_tx_lock);
+
+	return len;
+}
+
+/* Note: Must be called with console_tx_lock held */
+static void __console_tx_flush(void)
+{
+	if (!console_tx_dev)
+		return;
+
+	while (console_tx_count)
+		console_tx_drain();
+	console_tx_dev->console_tx_irq_enable(false);
+}
+
+static void console_tx_flush(void)
+{
+	spin_lock(&console_tx_lock);
+	__console_tx_flush();
+	spin_unlock(&console_tx_lock);
+}
+
 static unsigned long nputs(const char *str, unsigned long len)
 {
 	char ch;
 	unsigned long i;
 
-	if (console_dev) {
+	if (console_tx_dev && console_tx_dev == console_dev &&
+	    !console_tx_bypass) {
+		return nputs_buffered(str, len);
+	} else if (console_dev) {
 		if (console_dev->console_puts)
 			return console_dev->console_puts(str, len);
 		else if (console_dev->console_putc) {
@@ -91,6 +187,8 @@ void sbi_puts(const char *str)
 	spin_lock(&console_out_lock);
 	nputs_all(str, len);
 	spin_unlock(&console_out_lock);
+
+	sbi_residency_check();
 }
 
 unsigned long sbi_nputs(const char *str, unsigned long len)
@@ -101,6 +199,8 @@ unsigned long sbi_nputs(const char *str, unsigned long len)
 	ret = nputs(str, len);
 	spin_unlock(&console_out_lock);
 
+	sbi_residency_check();
+
 	return ret;
 }
 
@@ -136,15 +236,41 @@ unsigned long sbi_ngets(char *str, unsigned long len)
 #define PAD_ZERO 2
 #define PAD_ALTERNATE 4
 #define PAD_SIGN 8
-#define USE_TBUF 16
 #define PRINT_BUF_LEN 64
 
 #define va_start(v, l) __builtin_va_start((v), l)
 #define va_end __builtin_va_end
 #define va_arg __builtin_va_arg
+#define va_copy __builtin_va_copy
 typedef __builtin_va_list va_list;
 
-static void printc(char **out, u32 *out_len, char ch, int flags)
+/*
+ * Console output buffer of a single *printf call. It lives on the
+ * stack of the calling HART so formatting does not need any lock.
+ * Unlike a buffer in the scratch space, it also works for a printf
+ * nested in another one on the same HART (trap errors, sbi_panic())
+ * and before the scratch space allocator is ready.
+ */
+struct console_tbuf {
+	char buf[CONSOLE_TBUF_MAX];
+	u32 len;
+	bool locked;
+};
+
+static void console_tbuf_flush(struct console_tbuf *tbuf)
+{
+	/* Keep the lock till the end so that the output is not split */
+	if (!tbuf->locked) {
+		spin_lock(&console_out_lock);
+		tbuf->locked = true;
+	}
+
+	nputs_all(tbuf->buf, CONSOLE_TBUF_MAX - tbuf->len);
+	tbuf->len = CONSOLE_TBUF_MAX;
+}
+
+static void printc(char **out, u32 *out_len, struct console_tbuf *tbuf,
+		   char ch)
 {
 	if (!out) {
 		sbi_putc(ch);
@@ -160,42 +286,54 @@ static void printc(char **out, u32 *out_len, char ch, int flags)
 		**out = '\0';
 		if (out_len) {
 			--(*out_len);
-			if ((flags & USE_TBUF) && *out_len == 1) {
-				nputs_all(console_tbuf, CONSOLE_TBUF_MAX - *out_len);
-				*out = console_tbuf;
-				*out_len = CONSOLE_TBUF_MAX;
+			if (tbuf && *out_len == 1) {
+				console_tbuf_flush(tbuf);
+				*out = tbuf->buf;
 			}
 		}
 	}
 }
 
-static int prints(char **out, u32 *out_len, const char *string, int width,
-		  int flags)
+static int prints(char **out, u32 *out_len, struct console_tbuf *tbuf,
+		  const char *string, int width, int flags)
 {
 	int pc = 0;
 	width -= sbi_strlen(string);
 	if (!(flags & PAD_RIGHT)) {
 		for (; width > 0; --width) {
-			printc(out, out_len, flags & PAD_ZERO ? '0' : ' ', flags);
+			printc(out, out_len, tbuf,
+			       flags & PAD_ZERO ? '0' : ' ');
 			++pc;
 		}
 	}
 	for (; *string; ++string) {
-		printc(out, out_len, *string, flags);
+		printc(out, out_len, tbuf, *string);
 		++pc;
 	}
 	for (; width > 0; --width) {
-		printc(out, out_len, ' ', flags);
+		printc(out, out_len, tbuf, ' ');
 		++pc;
 	}
 
 	return pc;
 }
 
-static int printi(char **out, u32 *out_len, long long i,
-		  int width, int flags, int type)
+static const char digit_pairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static int printi(char **out, u32 *out_len, struct console_tbuf *tbuf,
+		  long long i, int width, int flags, int type)
 {
-	int pc = 0;
+	int pc = 0, shift;
 	char *s, sign = 0, letbase, print_buf[PRINT_BUF_LEN];
 	unsigned long long u, b, t;
 
@@ -223,32 +361,47 @@ static int printi(char **out, u32 *out_len, long long i,
 	s  = print_buf + PRINT_BUF_LEN - 1;
 	*s = '\0';
 
-	if (!u) {
-		*--s = '0';
+	if (b == 10) {
+		/* Emit two digits per division using the digit pair table */
+		while (u >= 100) {
+			t = (u % 100) * 2;
+			u = u / 100;
+			*--s = digit_pairs[t + 1];
+			*--s = digit_pairs[t];
+		}
+		if (u >= 10) {
+			t = u * 2;
+			*--s = digit_pairs[t + 1];
+			*--s = digit_pairs[t];
+		} else {
+			*--s = u + '0';
+		}
 	} else {
-		while (u) {
-			t = u % b;
-			u = u / b;
+		/* Octal and hexadecimal only need shifts and masks */
+		shift = (b == 16) ? 4 : 3;
+		do {
+			t = u & (b - 1);
+			u >>= shift;
 			if (t >= 10)
 				t += letbase - '0' - 10;
 			*--s = t + '0';
-		}
+		} while (u);
 	}
 
 	if (flags & PAD_ZERO) {
 		if (sign) {
-			printc(out, out_len, sign, flags);
+			printc(out, out_len, tbuf, sign);
 			++pc;
 			--width;
 		}
 		if (i && (flags & PAD_ALTERNATE)) {
 			if (b == 16 || b == 8) {
-				printc(out, out_len, '0', flags);
+				printc(out, out_len, tbuf, '0');
 				++pc;
 				--width;
 			}
 			if (b == 16) {
-				printc(out, out_len, 'x' - 'a' + letbase, flags);
+				printc(out, out_len, tbuf, 'x' - 'a' + letbase);
 				++pc;
 				--width;
 			}
@@ -264,27 +417,19 @@ static int printi(char **out, u32 *out_len, long long i,
 			*--s = sign;
 	}
 
-	return pc + prints(out, out_len, s, width, flags);
+	return pc + prints(out, out_len, tbuf, s, width, flags);
 }
 
-static int print(char **out, u32 *out_len, const char *format, va_list args)
+/*
+ * When tbuf is not NULL then out_len must point to its len member and
+ * the output is flushed to the console whenever tbuf is full.
+ */
+static int print(char **out, u32 *out_len, struct console_tbuf *tbuf,
+		 const char *format, va_list args)
 {
 	bool flags_done;
 	int width, flags, pc = 0;
-	char type, scr[2], *tout;
-	bool use_tbuf = (!out) ? true : false;
-
-	/*
-	 * The console_tbuf is protected by console_out_lock and
-	 * print() is always called with console_out_lock held
-	 * when out == NULL.
-	 */
-	if (use_tbuf) {
-		console_tbuf_len = CONSOLE_TBUF_MAX;
-		tout = console_tbuf;
-		out = &tout;
-		out_len = &console_tbuf_len;
-	}
+	char type, scr[2];
 
 	/* handle special case: *out_len == 1*/
 	if (out) {
@@ -294,8 +439,6 @@ static int print(char **out, u32 *out_len, const char *format, va_list args)
 
 	for (; *format != 0; ++format) {
 		width = flags = 0;
-		if (use_tbuf)
-			flags |= USE_TBUF;
 		if (*format == '%') {
 			++format;
 			if (*format == '\0')
@@ -338,23 +481,26 @@ static int print(char **out, u32 *out_len, const char *format, va_list args)
 			}
 			if (*format == 's') {
 				char *s = va_arg(args, char *);
-				pc += prints(out, out_len, s ? s : "(null)",
-					     width, flags);
+				pc += prints(out, out_len, tbuf,
+					     s ? s : "(null)", width, flags);
 				continue;
 			}
 			if ((*format == 'd') || (*format == 'i')) {
-				pc += printi(out, out_len, va_arg(args, int),
+				pc += printi(out, out_len, tbuf,
+					     va_arg(args, int),
 					     width, flags, *format);
 				continue;
 			}
 			if ((*format == 'u') || (*format == 'o')
 					 || (*format == 'x') || (*format == 'X')) {
-				pc += printi(out, out_len, va_arg(args, unsigned int),
+				pc += printi(out, out_len, tbuf,
+					     va_arg(args, unsigned int),
 					     width, flags, *format);
 				continue;
 			}
 			if ((*format == 'p') || (*format == 'P')) {
-				pc += printi(out, out_len, (uintptr_t)va_arg(args, void*),
+				pc += printi(out, out_len, tbuf,
+					     (uintptr_t)va_arg(args, void*),
 					     width, flags, *format);
 				continue;
 			}
@@ -368,7 +514,8 @@ static int print(char **out, u32 *out_len, const char *format, va_list args)
 						++format;
 						type = *format;
 					}
-					pc += printi(out, out_len, va_arg(args, long long),
+					pc += printi(out, out_len, tbuf,
+						va_arg(args, long long),
 						width, flags, type);
 					continue;
 				}
@@ -379,10 +526,12 @@ static int print(char **out, u32 *out_len, const char *format, va_list args)
 					type = *format;
 				}
 				if ((type == 'd') || (type == 'i'))
-					pc += printi(out, out_len, va_arg(args, long),
+					pc += printi(out, out_len, tbuf,
+					     va_arg(args, long),
 					     width, flags, type);
 				else
-					pc += printi(out, out_len, va_arg(args, unsigned long),
+					pc += printi(out, out_len, tbuf,
+					     va_arg(args, unsigned long),
 					     width, flags, type);
 				continue;
 			}
@@ -390,22 +539,43 @@ static int print(char **out, u32 *out_len, const char *format, va_list args)
 				/* char are converted to int then pushed on the stack */
 				scr[0] = va_arg(args, int);
 				scr[1] = '\0';
-				pc += prints(out, out_len, scr, width, flags);
+				pc += prints(out, out_len, tbuf, scr,
+					     width, flags);
 				continue;
 			}
 		} else {
 literal:
-			printc(out, out_len, *format, flags);
+			printc(out, out_len, tbuf, *format);
 			++pc;
 		}
 	}
 
-	if (use_tbuf && console_tbuf_len < CONSOLE_TBUF_MAX)
-		nputs_all(console_tbuf, CONSOLE_TBUF_MAX - console_tbuf_len);
-
 	return pc;
 }
 
+static int console_print(const char *format, va_list args)
+{
+	struct console_tbuf tbuf;
+	char *tout = tbuf.buf;
+	int retval;
+
+	tbuf.len = CONSOLE_TBUF_MAX;
+	tbuf.locked = false;
+
+	/* Format without holding the console_out_lock */
+	retval = print(&tout, &tbuf.len, &tbuf, format, args);
+
+	if (!tbuf.locked)
+		spin_lock(&console_out_lock);
+	if (tbuf.len < CONSOLE_TBUF_MAX)
+		nputs_all(tbuf.buf, CONSOLE_TBUF_MAX - tbuf.len);
+	spin_unlock(&console_out_lock);
+
+	sbi_residency_check();
+
+	return retval;
+}
+
 int sbi_sprintf(char *out, const char *format, ...)
 {
 	va_list args;
@@ -415,7 +585,7 @@ int sbi_sprintf(char *out, const char *format, ...)
 		sbi_panic("sbi_sprintf called with NULL output string\n");
 
 	va_start(args, format);
-	retval = print(&out, NULL, format, args);
+	retval = print(&out, NULL, NULL, format, args);
 	va_end(args);
 
 	return retval;
@@ -431,7 +601,7 @@ int sbi_snprintf(char *out, u32 out_sz, const char *format, ...)
 			  "output size is not zero\n");
 
 	va_start(args, format);
-	retval = print(&out, &out_sz, format, args);
+	retval = print(&out, &out_sz, NULL, format, args);
 	va_end(args);
 
 	return retval;
@@ -442,27 +612,54 @@ int sbi_printf(const char *format, ...)
 	va_list args;
 	int retval;
 
-	spin_lock(&console_out_lock);
 	va_start(args, format);
-	retval = print(NULL, NULL, format, args);
+	retval = console_print(format, args);
 	va_end(args);
-	spin_unlock(&console_out_lock);
 
 	return retval;
 }
 
+static int fwlog_print(const char *format, va_list args)
+{
+#ifdef CONFIG_SBI_FWLOG
+	char msg[SBI_FWLOG_MSG_SIZE + 1];
+	char *out = msg;
+	u32 out_len = sizeof(msg);
+	int retval;
+
+	retval = print(&out, &out_len, NULL, format, args);
+	sbi_fwlog_write(msg, sizeof(msg) - out_len);
+
+	return retval;
+#else
+	return 0;
+#endif
+}
+
 int sbi_dprintf(const char *format, ...)
 {
-	va_list args;
+	va_list args, log_args;
 	int retval = 0;
 	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
 
 	va_start(args, format);
-	if (scratch->options & SBI_SCRATCH_DEBUG_PRINTS) {
-		spin_lock(&console_out_lock);
-		retval = print(NULL, NULL, format, args);
-		spin_unlock(&console_out_lock);
-	}
+	va_copy(log_args, args);
+	fwlog_print(format, log_args);
+	va_end(log_args);
+	if (scratch->options & SBI_SCRATCH_DEBUG_PRINTS)
+		retval = console_print(format, args);
+	va_end(args);
+
+	return retval;
+}
+
+int sbi_lprintf(const char *format, ...)
+{
+	va_list args;
+	int retval;
+
+	va_start(args, format);
+	retval = fwlog_print(format, args);
 	va_end(args);
 
 	return retval;
@@ -471,12 +668,34 @@ int sbi_dprintf(const char *format, ...)
 void sbi_panic(const char *format, ...)
 {
 	va_list args;
+	bool out_locked, tx_locked = false;
+	u32 i;
+
+	/*
+	 * The panic might be raised with a console lock already held by
+	 * this HART so only try to take the locks and print anyway.
+	 */
+	out_locked = spin_trylock(&console_out_lock);
+	for (i = 0; !tx_locked && i < CONSOLE_PANIC_TRYLOCK_LOOPS; i++)
+		tx_locked = spin_trylock(&console_tx_lock);
+
+	/*
+	 * Interrupts won't be taken anymore so print synchronously. The
+	 * ring buffer is only flushed with console_tx_lock held because
+	 * another HART may be draining it.
+	 */
+	if (tx_locked) {
+		__console_tx_flush();
+		spin_unlock(&console_tx_lock);
+	}
+	console_tx_bypass = true;
 
-	spin_lock(&console_out_lock);
 	va_start(args, format);
-	print(NULL, NULL, format, args);
+	print(NULL, NULL, NULL, format, args);
 	va_end(args);
-	spin_unlock(&console_out_lock);
+
+	if (out_locked)
+		spin_unlock(&console_out_lock);
 
 	sbi_hart_hang();
 }
@@ -497,6 +716,9 @@ void sbi_console_set_device(const struct sbi_console_device *dev)
 	if (!console_dev)
 		flush_early_fifo = true;
 
+	if (console_dev == console_tx_dev)
+		console_tx_flush();
+
 	console_dev = dev;
 
 	if (flush_early_fifo) {
@@ -504,3 +726,50 @@ void sbi_console_set_device(const struct sbi_console_device *dev)
 			sbi_putc(ch);
 	}
 }
+
+void sbi_console_flush(void)
+{
+	console_tx_flush();
+}
+
+void sbi_console_tx_process(void)
+{
+	if (!console_tx_dev)
+		return;
+
+	spin_lock(&console_tx_lock);
+	console_tx_drain();
+	if (!console_tx_count)
+		console_tx_dev->console_tx_irq_enable(false);
+	spin_unlock(&console_tx_lock);
+}
+
+int sbi_console_tx_init(struct sbi_scratch *scratch)
+{
+	int rc;
+
+	if (!CONSOLE_TX_BUFFER_SIZE || !console_dev ||
+	    !console_dev->console_tx_try_puts ||
+	    !console_dev->console_tx_irq_enable ||
+	    !console_dev->console_tx_irq_init)
+		return 0;
+
+	console_tx_buf = sbi_malloc(CONSOLE_TX_BUFFER_SIZE);
+	if (!console_tx_buf)
+		return SBI_ENOMEM;
+
+	rc = console_dev->console_tx_irq_init();
+	if (rc) {
+		sbi_free(console_tx_buf);
+		console_tx_buf = NULL;
+		/* Devices without a usable interrupt stay synchronous */
+		return (rc == SBI_ENODEV) ? 0 : rc;
+	}
+
+	console_tx_size = CONSOLE_TX_BUFFER_SIZE;
+	console_tx_head = 0;
+	console_tx_count = 0;
+	console_tx_dev = console_dev;
+
+	return 0;
+}
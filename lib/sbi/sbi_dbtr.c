@@ -17,6 +17,7 @@
 #include <sbi/sbi_dbtr.h>
 #include <sbi/sbi_heap.h>
 #include <sbi/sbi_hart_protection.h>
+#include <sbi/sbi_shmem.h>
 #include <sbi/riscv_encoding.h>
 #include <sbi/riscv_asm.h>
 
@@ -264,6 +265,7 @@ int sbi_dbtr_setup_shmem(const struct sbi_domain *dom, unsigned long smode,
 			 unsigned long shmem_phys_hi)
 {
 	struct sbi_dbtr_hart_triggers_state *hart_state;
+	int rc;
 
 	if (dom && !sbi_domain_is_assigned_hart(dom, current_hartindex())) {
 		sbi_dprintf("%s: calling hart not assigned to this domain\n",
@@ -287,27 +289,12 @@ int sbi_dbtr_setup_shmem(const struct sbi_domain *dom, unsigned long smode,
 		return SBI_ERR_ALREADY_AVAILABLE;
 
 	/* lower physical address must be XLEN/8 bytes aligned */
-	if (shmem_phys_lo & SBI_DBTR_SHMEM_ALIGN_MASK)
-		return SBI_ERR_INVALID_PARAM;
-
-	/*
-	* On RV32, the M-mode can only access the first 4GB of
-	* the physical address space because M-mode does not have
-	* MMU to access full 34-bit physical address space.
-	* So fail if the upper 32 bits of the physical address
-	* is non-zero on RV32.
-	*
-	* On RV64, kernel sets upper 64bit address part to zero.
-	* So fail if the upper 64bit of the physical address
-	* is non-zero on RV64.
-	*/
-	if (shmem_phys_hi)
-		return SBI_EINVALID_ADDR;
-
-	if (dom && !sbi_domain_check_addr(dom,
-		  DBTR_SHMEM_MAKE_PHYS(shmem_phys_hi, shmem_phys_lo), smode,
-		  SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
-		return SBI_ERR_INVALID_ADDRESS;
+	rc = sbi_shmem_check(smode, shmem_phys_lo, shmem_phys_hi,
+			     sizeof(union sbi_dbtr_shmem_entry),
+			     SBI_DBTR_SHMEM_ALIGN_MASK + 1,
+			     SBI_DOMAIN_READ | SBI_DOMAIN_WRITE);
+	if (rc)
+		return rc;
 
 	hart_state->shmem.phys_lo = shmem_phys_lo;
 	hart_state->shmem.phys_hi = shmem_phys_hi;
@@ -745,6 +732,7 @@ int sbi_dbtr_update_trig(unsigned long smode,
 	void *shmem_base = NULL;
 	struct sbi_dbtr_hart_triggers_state *hs = NULL;
 	bool tdata2_impl, tdata3_impl;
+	int rc = SBI_SUCCESS;
 
 	hs = dbtr_thishart_state_ptr();
 	if (!hs)
@@ -767,34 +755,36 @@ int sbi_dbtr_update_trig(unsigned long smode,
 	tdata2_impl = tdata_implemented(CSR_TDATA2);
 	tdata3_impl = tdata_implemented(CSR_TDATA3);
 
+	sbi_hart_protection_map_range((unsigned long)shmem_base,
+				      trig_count * sizeof(*entry));
 	for_each_trig_entry(shmem_base, trig_count, typeof(*entry), entry) {
-		sbi_hart_protection_map_range((unsigned long)entry, sizeof(*entry));
 		trig_idx = entry->id.idx;
 
 		if (trig_idx >= hs->total_trigs) {
-			sbi_hart_protection_unmap_range((unsigned long)entry, sizeof(*entry));
-			return SBI_ERR_INVALID_PARAM;
+			rc = SBI_ERR_INVALID_PARAM;
+			break;
 		}
 
 		trig = INDEX_TO_TRIGGER(trig_idx);
 
 		if (!(trig->state & RV_DBTR_BIT_MASK(TS, MAPPED))) {
-			sbi_hart_protection_unmap_range((unsigned long)entry, sizeof(*entry));
-			return SBI_ERR_FAILED;
+			rc = SBI_ERR_FAILED;
+			break;
 		}
 
 		if ((entry->data.tdata2 && !tdata2_impl) ||
 		    (entry->data.tdata3 && !tdata3_impl)) {
-			sbi_hart_protection_unmap_range((unsigned long)entry, sizeof(*entry));
-			return SBI_ERR_NOT_SUPPORTED;
+			rc = SBI_ERR_NOT_SUPPORTED;
+			break;
 		}
 
 		dbtr_trigger_setup(trig, &entry->data);
-		sbi_hart_protection_unmap_range((unsigned long)entry, sizeof(*entry));
 		dbtr_trigger_enable(trig);
 	}
+	sbi_hart_protection_unmap_range((unsigned long)shmem_base,
+					trig_count * sizeof(*entry));
 
-	return SBI_SUCCESS;
+	return rc;
 }
 
 int sbi_dbtr_disable_trig(unsigned long trig_idx_base,
@@ -10,6 +10,9 @@
 #include <sbi/riscv_asm.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_domain.h>
+#include <sbi/sbi_domain_context.h>
+#include <sbi/sbi_domain_stats.h>
+#include <sbi/sbi_hart_protection.h>
 #include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_heap.h>
 #include <sbi/sbi_hsm.h>
@@ -36,6 +39,7 @@ struct sbi_domain root = {
 };
 
 static unsigned long domain_hart_ptr_offset;
+static unsigned long domain_memindex_hit_offset;
 
 struct sbi_domain *sbi_hartindex_to_domain(u32 hartindex)
 {
@@ -217,16 +221,28 @@ unsigned int sbi_domain_get_smepmp_flags(struct sbi_domain_memregion *reg)
 	return pmp_flags;
 }
 
-bool sbi_domain_check_addr(const struct sbi_domain *dom,
-			   unsigned long addr, unsigned long mode,
-			   unsigned long access_flags)
+static const struct sbi_domain_memregion *find_region(
+						const struct sbi_domain *dom,
+						unsigned long addr)
 {
-	bool rmmio, mmio = false;
+	unsigned long rstart, rend;
 	struct sbi_domain_memregion *reg;
-	unsigned long rstart, rend, rflags, rwx = 0, rrwx = 0;
 
-	if (!dom)
-		return false;
+	sbi_domain_for_each_memregion(dom, reg) {
+		rstart = reg->base;
+		rend = (reg->order < __riscv_xlen) ?
+			rstart + ((1UL << reg->order) - 1) : -1UL;
+		if (rstart <= addr && addr <= rend)
+			return reg;
+	}
+
+	return NULL;
+}
+
+static bool memregion_flags_allow(unsigned long rflags, unsigned long mode,
+				  unsigned long access_flags)
+{
+	unsigned long rwx = 0, rrwx;
 
 	/*
 	 * Use M_{R/W/X} bits because the SU-bits are at the
@@ -242,31 +258,77 @@ bool sbi_domain_check_addr(const struct sbi_domain *dom,
 	if (access_flags & SBI_DOMAIN_EXECUTE)
 		rwx |= SBI_DOMAIN_MEMREGION_M_EXECUTABLE;
 
-	if (access_flags & SBI_DOMAIN_MMIO)
-		mmio = true;
+	rrwx = (mode == PRV_M ?
+		(rflags & SBI_DOMAIN_MEMREGION_M_ACCESS_MASK) :
+		(rflags & SBI_DOMAIN_MEMREGION_SU_ACCESS_MASK)
+		>> SBI_DOMAIN_MEMREGION_SU_ACCESS_SHIFT);
 
-	sbi_domain_for_each_memregion(dom, reg) {
-		rflags = reg->flags;
-		rrwx = (mode == PRV_M ?
-			(rflags & SBI_DOMAIN_MEMREGION_M_ACCESS_MASK) :
-			(rflags & SBI_DOMAIN_MEMREGION_SU_ACCESS_MASK)
-			>> SBI_DOMAIN_MEMREGION_SU_ACCESS_SHIFT);
+	/*
+	 * MMIO devices may appear in regions without the flag set (such as the
+	 * default region), but MMIO device regions should not be used as memory.
+	 */
+	if (!(access_flags & SBI_DOMAIN_MMIO) &&
+	    (rflags & SBI_DOMAIN_MEMREGION_MMIO))
+		return false;
 
-		rstart = reg->base;
-		rend = (reg->order < __riscv_xlen) ?
-			rstart + ((1UL << reg->order) - 1) : -1UL;
-		if (rstart <= addr && addr <= rend) {
-			rmmio = (rflags & SBI_DOMAIN_MEMREGION_MMIO) ? true : false;
-			/*
-			 * MMIO devices may appear in regions without the flag set (such as the
-			 * default region), but MMIO device regions should not be used as memory.
-			 */
-			if (!mmio && rmmio)
-				return false;
-			return ((rrwx & rwx) == rwx) ? true : false;
+	return ((rrwx & rwx) == rwx) ? true : false;
+}
+
+static const struct sbi_domain_memindex *find_memindex(
+						const struct sbi_domain *dom,
+						unsigned long addr)
+{
+	u32 lo = 0, hi = dom->memindex_count, mid;
+	const struct sbi_domain_memindex *idx;
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+
+	/* Try the interval found by the previous lookup on this HART */
+	idx = sbi_scratch_read_type(scratch, const struct sbi_domain_memindex *,
+				    domain_memindex_hit_offset);
+	if (dom->memindex <= idx && idx < dom->memindex + hi &&
+	    idx->start <= addr && addr <= idx->end)
+		return idx;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		idx = &dom->memindex[mid];
+		if (addr < idx->start) {
+			hi = mid;
+		} else if (idx->end < addr) {
+			lo = mid + 1;
+		} else {
+			sbi_scratch_write_type(scratch,
+					const struct sbi_domain_memindex *,
+					domain_memindex_hit_offset, idx);
+			return idx;
 		}
 	}
 
+	return NULL;
+}
+
+bool sbi_domain_check_addr(const struct sbi_domain *dom,
+			   unsigned long addr, unsigned long mode,
+			   unsigned long access_flags)
+{
+	const struct sbi_domain_memregion *reg;
+	const struct sbi_domain_memindex *idx;
+
+	if (!dom)
+		return false;
+
+	if (dom->memindex) {
+		idx = find_memindex(dom, addr);
+		if (idx)
+			return memregion_flags_allow(idx->flags, mode,
+						     access_flags);
+	} else {
+		reg = find_region(dom, addr);
+		if (reg)
+			return memregion_flags_allow(reg->flags, mode,
+						     access_flags);
+	}
+
 	return (mode == PRV_M) ? true : false;
 }
 
@@ -323,24 +385,6 @@ static bool is_region_before(const struct sbi_domain_memregion *regA,
 	return false;
 }
 
-static const struct sbi_domain_memregion *find_region(
-						const struct sbi_domain *dom,
-						unsigned long addr)
-{
-	unsigned long rstart, rend;
-	struct sbi_domain_memregion *reg;
-
-	sbi_domain_for_each_memregion(dom, reg) {
-		rstart = reg->base;
-		rend = (reg->order < __riscv_xlen) ?
-			rstart + ((1UL << reg->order) - 1) : -1UL;
-		if (rstart <= addr && addr <= rend)
-			return reg;
-	}
-
-	return NULL;
-}
-
 static const struct sbi_domain_memregion *find_next_subset_region(
 				const struct sbi_domain *dom,
 				const struct sbi_domain_memregion *reg,
@@ -501,6 +545,7 @@ bool sbi_domain_check_addr_range(const struct sbi_domain *dom,
 {
 	unsigned long max = addr + size;
 	const struct sbi_domain_memregion *reg, *sreg;
+	const struct sbi_domain_memindex *idx;
 
 	if (!dom)
 		return false;
@@ -508,6 +553,22 @@ bool sbi_domain_check_addr_range(const struct sbi_domain *dom,
 	if (size && max <= addr)
 		return false;
 
+	if (dom->memindex && size) {
+		/* Walk the intervals as long as they are contiguous */
+		idx = find_memindex(dom, addr);
+		while (idx && idx->start <= addr) {
+			if (!memregion_flags_allow(idx->flags, mode,
+						   access_flags))
+				return false;
+			if (max - 1 <= idx->end)
+				return true;
+			addr = idx->end + 1;
+			if (++idx == dom->memindex + dom->memindex_count)
+				break;
+		}
+		return false;
+	}
+
 	while (addr < max) {
 		reg = find_region(dom, addr);
 		if (!reg)
@@ -613,6 +674,17 @@ void sbi_domain_dump(const struct sbi_domain *dom, const char *suffix)
 
 	sbi_printf("Domain%d SysSuspend  %s: %s\n",
 		   dom->index, suffix, (dom->system_suspend_allowed) ? "yes" : "no");
+
+#ifdef CONFIG_SBI_DOMAIN_SCHED
+	if (dom->sched_budget_us)
+		sbi_printf("Domain%d TimeSlice   %s: %u us (priority %u)\n",
+			   dom->index, suffix, dom->sched_budget_us,
+			   dom->sched_priority);
+	sbi_printf("Domain%d SchedTime   %s: %lu ticks\n",
+		   dom->index, suffix, (ulong)sbi_domain_sched_time(dom));
+#endif
+
+	sbi_domain_stats_dump(dom, suffix);
 }
 
 void sbi_domain_dump_all(const char *suffix)
@@ -842,9 +914,80 @@ int sbi_domain_startup(struct sbi_scratch *scratch, u32 cold_hartid)
 	return 0;
 }
 
+/*
+ * Flatten the memory regions of a domain into sorted, non-overlapping
+ * intervals. Region boundaries split the address space into pieces
+ * within which the first matching region (as found by a linear walk
+ * of the sorted regions) doesn't change, so each piece gets the flags
+ * of that region and neighbouring pieces with equal flags are merged.
+ */
+static int domain_build_memindex(struct sbi_domain *dom)
+{
+	u32 i, j, npoints = 0, count = 0;
+	unsigned long *points, start, end, tmp;
+	const struct sbi_domain_memregion *reg;
+	struct sbi_domain_memindex *index;
+	int nregs = sbi_domain_used_memregions(dom);
+
+	points = sbi_calloc(sizeof(*points), 2 * nregs);
+	if (!points)
+		return SBI_ENOMEM;
+
+	index = sbi_calloc(sizeof(*index), 2 * nregs);
+	if (!index) {
+		sbi_free(points);
+		return SBI_ENOMEM;
+	}
+
+	/* Collect and sort the region boundaries */
+	sbi_domain_for_each_memregion(dom, reg) {
+		points[npoints++] = reg->base;
+		if (reg->order < __riscv_xlen)
+			points[npoints++] = reg->base + BIT(reg->order);
+	}
+	for (i = 1; i < npoints; i++) {
+		tmp = points[i];
+		for (j = i; j && tmp < points[j - 1]; j--)
+			points[j] = points[j - 1];
+		points[j] = tmp;
+	}
+	for (i = 0, j = 0; i < npoints; i++) {
+		if (!j || points[j - 1] != points[i])
+			points[j++] = points[i];
+	}
+	npoints = j;
+
+	for (i = 0; i < npoints; i++) {
+		start = points[i];
+		end = (i + 1 < npoints) ? points[i + 1] - 1 : -1UL;
+
+		reg = find_region(dom, start);
+		if (!reg)
+			continue;
+
+		if (count && index[count - 1].flags == reg->flags &&
+		    index[count - 1].end + 1 == start) {
+			index[count - 1].end = end;
+			continue;
+		}
+
+		index[count].start = start;
+		index[count].end = end;
+		index[count].flags = reg->flags;
+		count++;
+	}
+
+	sbi_free(points);
+
+	dom->memindex = index;
+	dom->memindex_count = count;
+	return 0;
+}
+
 int sbi_domain_finalize(struct sbi_scratch *scratch)
 {
 	int rc;
+	struct sbi_domain *dom;
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
 
 	/* Sanity checks */
@@ -865,6 +1008,18 @@ int sbi_domain_finalize(struct sbi_scratch *scratch)
 	 */
 	domain_finalized = true;
 
+	/* Regions are final so address checks can use a flattened index */
+	sbi_domain_for_each(dom) {
+		rc = domain_build_memindex(dom);
+		if (rc) {
+			sbi_printf("%s: %s memory region index failed "
+				   "(error %d)\n", __func__, dom->name, rc);
+			return rc;
+		}
+
+		sbi_hart_protection_prepare(scratch, dom);
+	}
+
 	return 0;
 }
 
@@ -897,16 +1052,27 @@ int sbi_domain_init(struct sbi_scratch *scratch, u32 cold_hartid)
 	if (!domain_hart_ptr_offset)
 		return SBI_ENOMEM;
 
+	domain_memindex_hit_offset = sbi_scratch_alloc_type_offset(void *);
+	if (!domain_memindex_hit_offset) {
+		rc = SBI_ENOMEM;
+		goto fail_free_domain_hart_ptr_offset;
+	}
+
 	/* Initialize domain context support */
 	rc = sbi_domain_context_init();
 	if (rc)
-		goto fail_free_domain_hart_ptr_offset;
+		goto fail_free_memindex_hit_offset;
+
+	/* Initialize per-domain statistics */
+	rc = sbi_domain_stats_init();
+	if (rc)
+		goto fail_deinit_context;
 
 	root_memregs = sbi_calloc(sizeof(*root_memregs), ROOT_REGION_MAX + 1);
 	if (!root_memregs) {
 		sbi_printf("%s: no memory for root regions\n", __func__);
 		rc = SBI_ENOMEM;
-		goto fail_deinit_context;
+		goto fail_deinit_stats;
 	}
 	root.regions = root_memregs;
 
@@ -985,8 +1151,12 @@ fail_free_root_hmask:
 	sbi_free(root_hmask);
 fail_free_root_memregs:
 	sbi_free(root_memregs);
+fail_deinit_stats:
+	sbi_domain_stats_deinit();
 fail_deinit_context:
 	sbi_domain_context_deinit();
+fail_free_memindex_hit_offset:
+	sbi_scratch_free_offset(domain_memindex_hit_offset);
 fail_free_domain_hart_ptr_offset:
 	sbi_scratch_free_offset(domain_hart_ptr_offset);
 	return rc;
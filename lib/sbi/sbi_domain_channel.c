@@ -0,0 +1,286 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_atomic.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_domain_channel.h>
+#include <sbi/sbi_domain_context.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hart_protection.h>
+#include <sbi/sbi_hsm.h>
+#include <sbi/sbi_ipi.h>
+#include <sbi/sbi_list.h>
+#include <sbi/sbi_string.h>
+
+/*
+ * Inter-domain message channels
+ *
+ * M-mode only checks and initializes the shared memory of a channel
+ * and delivers doorbells. Messages are exchanged by the domains
+ * through the rings in shared memory without any SBI call, so the
+ * only SBI call on the fast path is the doorbell itself. A doorbell
+ * raises a supervisor software interrupt on the doorbell HART of the
+ * peer. When that HART runs another domain at the time, the interrupt
+ * is raised in the saved context of the peer instead.
+ */
+
+#define CHANNEL_MAX_DESCS	65536
+#define CHANNEL_ALIGN		64
+
+static SBI_LIST_HEAD(channel_list);
+static u32 channel_count;
+static bool channels_initialized;
+static u32 channel_doorbell_event = SBI_IPI_EVENT_MAX;
+
+static struct sbi_domain_channel *channel_find(u32 index)
+{
+	struct sbi_domain_channel *chan;
+
+	sbi_list_for_each_entry(chan, &channel_list, node) {
+		if (chan->index == index)
+			return chan;
+	}
+
+	return NULL;
+}
+
+static int channel_end(const struct sbi_domain_channel *chan,
+		       const struct sbi_domain *dom)
+{
+	if (chan->end[0].dom == dom)
+		return 0;
+	if (chan->end[1].dom == dom)
+		return 1;
+	return -1;
+}
+
+static unsigned long channel_desc_offset(const struct sbi_domain_channel *chan,
+					 int ring)
+{
+	return sizeof(struct sbi_domain_channel_header) +
+	       ring * chan->desc_count * sizeof(struct sbi_domain_channel_desc);
+}
+
+static unsigned long channel_data_offset(const struct sbi_domain_channel *chan)
+{
+	unsigned long off = channel_desc_offset(chan, 2);
+
+	return (off + CHANNEL_ALIGN - 1) & ~(CHANNEL_ALIGN - 1UL);
+}
+
+static void channel_doorbell_process(struct sbi_scratch *scratch)
+{
+	u32 hartindex = current_hartindex();
+	struct sbi_domain_channel_end *e;
+	struct sbi_domain_channel *chan;
+	int i;
+
+	sbi_list_for_each_entry(chan, &channel_list, node) {
+		for (i = 0; i < 2; i++) {
+			e = &chan->end[i];
+			if (e->doorbell_hartindex != hartindex ||
+			    !atomic_raw_xchg_ulong(&e->pending, 0))
+				continue;
+
+			/* Doorbells of a domain never started here are lost */
+			sbi_domain_context_raise_sip(e->dom, MIP_SSIP);
+		}
+	}
+}
+
+static struct sbi_ipi_event_ops channel_doorbell_ops = {
+	.name = "IPI_CHANNEL",
+	.process = channel_doorbell_process,
+};
+
+static int channel_ring_doorbell(struct sbi_domain_channel_end *e)
+{
+	u32 hartindex = e->doorbell_hartindex;
+	int hstate = __sbi_hsm_hart_get_state(hartindex);
+
+	/*
+	 * Messages stay in the rings so the peer finds them once its
+	 * HART is started again.
+	 */
+	if (hstate != SBI_HSM_STATE_STARTED &&
+	    hstate != SBI_HSM_STATE_SUSPENDED &&
+	    hstate != SBI_HSM_STATE_RESUME_PENDING) {
+		atomic_raw_xchg_ulong(&e->pending, 0);
+		return 0;
+	}
+
+	return sbi_ipi_send_hartindex(hartindex, channel_doorbell_event, NULL);
+}
+
+int sbi_domain_channel_get_info(u32 index,
+				struct sbi_domain_channel_info *info)
+{
+	struct sbi_domain_channel *chan = channel_find(index);
+	int end;
+
+	if (!chan || !info)
+		return SBI_EINVAL;
+
+	end = channel_end(chan, sbi_domain_thishart_ptr());
+	if (end < 0)
+		return SBI_EDENIED;
+
+	sbi_memset(info, 0, sizeof(*info));
+	info->shmem_addr = chan->shmem_addr;
+	info->shmem_size = chan->shmem_size;
+	info->end = end;
+	info->peer_domain = chan->end[!end].dom->index;
+	info->desc_count = chan->desc_count;
+
+	return 0;
+}
+
+int sbi_domain_channel_notify(u32 index)
+{
+	struct sbi_domain_channel *chan = channel_find(index);
+	struct sbi_domain_channel_end *peer;
+	int end;
+
+	if (!chan)
+		return SBI_EINVAL;
+
+	end = channel_end(chan, sbi_domain_thishart_ptr());
+	if (end < 0)
+		return SBI_EDENIED;
+	peer = &chan->end[!end];
+
+	/* Ring updates of the caller must be visible before the doorbell */
+	smp_wmb();
+
+	/* A doorbell already in flight also covers this one */
+	if (atomic_raw_xchg_ulong(&peer->pending, 1))
+		return 0;
+
+	return channel_ring_doorbell(peer);
+}
+
+int sbi_domain_channel_set_doorbell(u32 index, u32 hartid)
+{
+	struct sbi_domain_channel *chan = channel_find(index);
+	u32 hartindex = sbi_hartid_to_hartindex(hartid);
+	struct sbi_domain *dom = sbi_domain_thishart_ptr();
+	struct sbi_domain_channel_end *e;
+	int end;
+
+	if (!chan)
+		return SBI_EINVAL;
+
+	end = channel_end(chan, dom);
+	if (end < 0)
+		return SBI_EDENIED;
+	e = &chan->end[end];
+
+	if (!sbi_hartindex_valid(hartindex) ||
+	    !sbi_hartmask_test_hartindex(hartindex, dom->possible_harts))
+		return SBI_EINVAL;
+
+	e->doorbell_hartindex = hartindex;
+
+	/* Deliver a doorbell which was pending on the previous HART */
+	if (__atomic_load_n(&e->pending, __ATOMIC_RELAXED))
+		return channel_ring_doorbell(e);
+
+	return 0;
+}
+
+u32 sbi_domain_channel_count(void)
+{
+	return channel_count;
+}
+
+int sbi_domain_channel_register(struct sbi_domain_channel *chan)
+{
+	if (!chan || channels_initialized)
+		return SBI_EINVAL;
+
+	if (!chan->end[0].dom || !chan->end[1].dom ||
+	    chan->end[0].dom == chan->end[1].dom)
+		return SBI_EINVAL;
+
+	if (!chan->desc_count)
+		chan->desc_count = SBI_DOMAIN_CHANNEL_DEFAULT_DESCS;
+	if (CHANNEL_MAX_DESCS < chan->desc_count ||
+	    (chan->desc_count & (chan->desc_count - 1)))
+		return SBI_EINVAL;
+
+	chan->index = channel_count++;
+	SBI_INIT_LIST_HEAD(&chan->node);
+	sbi_list_add_tail(&chan->node, &channel_list);
+
+	return 0;
+}
+
+static int channel_setup(struct sbi_domain_channel *chan)
+{
+	struct sbi_domain_channel_header *hdr;
+	unsigned long data_offset = channel_data_offset(chan);
+	struct sbi_domain_channel_end *e;
+	int i;
+
+	if (chan->shmem_addr & (CHANNEL_ALIGN - 1) ||
+	    chan->shmem_size <= data_offset)
+		return SBI_EINVAL;
+
+	for (i = 0; i < 2; i++) {
+		e = &chan->end[i];
+		if (!sbi_domain_check_addr_range(e->dom, chan->shmem_addr,
+						 chan->shmem_size, PRV_S,
+						 SBI_DOMAIN_READ |
+						 SBI_DOMAIN_WRITE))
+			return SBI_EINVALID_ADDR;
+
+		e->doorbell_hartindex =
+			sbi_hartid_to_hartindex(e->dom->boot_hartid);
+		e->pending = 0;
+	}
+
+	sbi_hart_protection_map_range(chan->shmem_addr, sizeof(*hdr));
+	hdr = (struct sbi_domain_channel_header *)chan->shmem_addr;
+	sbi_memset(hdr, 0, sizeof(*hdr));
+	hdr->version = SBI_DOMAIN_CHANNEL_VERSION;
+	hdr->desc_count = chan->desc_count;
+	hdr->desc_offset[0] = channel_desc_offset(chan, 0);
+	hdr->desc_offset[1] = channel_desc_offset(chan, 1);
+	hdr->data_offset = data_offset;
+	hdr->data_size = chan->shmem_size - data_offset;
+	sbi_hart_protection_unmap_range(chan->shmem_addr, sizeof(*hdr));
+
+	return 0;
+}
+
+int sbi_domain_channel_init(struct sbi_scratch *scratch)
+{
+	struct sbi_domain_channel *chan;
+	int rc;
+
+	channels_initialized = true;
+	if (!channel_count)
+		return 0;
+
+	sbi_list_for_each_entry(chan, &channel_list, node) {
+		rc = channel_setup(chan);
+		if (rc) {
+			sbi_printf("%s: channel %s setup failed (error %d)\n",
+				   __func__, chan->name, rc);
+			return rc;
+		}
+	}
+
+	rc = sbi_ipi_event_create(&channel_doorbell_ops);
+	if (rc < 0)
+		return rc;
+	channel_doorbell_event = rc;
+
+	return 0;
+}
@@ -7,16 +7,22 @@
 #include <sbi/sbi_error.h>
 #include <sbi/riscv_locks.h>
 #include <sbi/riscv_asm.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/sbi_bitops.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_hsm.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_hart_protection.h>
 #include <sbi/sbi_heap.h>
+#include <sbi/sbi_hfence.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_string.h>
+#include <sbi/sbi_timer.h>
+#include <sbi/sbi_tlb.h>
 #include <sbi/sbi_domain.h>
 #include <sbi/sbi_domain_context.h>
 #include <sbi/sbi_platform.h>
+#include <sbi/sbi_trace.h>
 #include <sbi/sbi_trap.h>
 #include <sbi/sbi_vector.h>
 #include <sbi/sbi_fp.h>
@@ -50,6 +56,8 @@ struct hart_context {
 	unsigned long senvcfg;
 	/** Supervisor resource management configuration register */
 	unsigned long srmcfg;
+	/** Supervisor timer event (-1ULL if none) */
+	u64 stimer;
 
 	/** Float context state */
 	struct sbi_fp_context fp_ctx;
@@ -62,6 +70,15 @@ struct hart_context {
 	struct hart_context *prev_ctx;
 	/** Is context initialized and runnable */
 	bool initialized;
+
+#ifdef CONFIG_SBI_DOMAIN_SCHED
+	/** Time slice budget in timer ticks (zero if not time sliced) */
+	u64 sched_budget;
+	/** Budget left in the current scheduling period */
+	u64 sched_left;
+	/** Timer ticks spent running this context */
+	u64 sched_time;
+#endif
 };
 
 static struct sbi_domain_data dcpriv;
@@ -95,6 +112,193 @@ static void hart_context_set(struct sbi_domain *dom, u32 hartindex,
 	hart_context_get(sbi_domain_thishart_ptr(),			\
 			 current_hartindex())
 
+#ifdef CONFIG_SBI_DOMAIN_LAZY_FPV
+/** Contexts whose FP and vector state is loaded in the HART registers */
+struct hart_context_owner {
+	struct hart_context *fp;
+	struct hart_context *vec;
+};
+
+static unsigned long hart_context_owner_offset;
+
+/*
+ * The outgoing state must be saved unless it is Off. Clean only tells
+ * that the registers match some copy kept by the domain itself, which
+ * may have loaded them after the firmware did.
+ */
+static bool lazy_save_needed(unsigned long status)
+{
+	return status != MSTATUS_EXT_OFF;
+}
+
+/*
+ * The incoming state must be restored unless it is still loaded in the
+ * HART registers. This holds even when the domain runs with it Off since
+ * the domain can turn it on at any time. A domain which never used FP or
+ * vector gets its own zeroed state.
+ */
+static bool lazy_restore_needed(struct hart_context *owner,
+				struct hart_context *dom_ctx)
+{
+	return owner != dom_ctx;
+}
+
+static void switch_fp_vector_context(struct sbi_scratch *scratch,
+				     struct hart_context *ctx,
+				     struct hart_context *dom_ctx)
+{
+	struct hart_context_owner *owner =
+		sbi_scratch_offset_ptr(scratch, hart_context_owner_offset);
+	unsigned long out = ctx->trap_ctx.regs.mstatus;
+
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_F) ||
+	    sbi_hart_has_extension(scratch, SBI_HART_EXT_D)) {
+		if (lazy_save_needed(EXTRACT_FIELD(out, MSTATUS_FS))) {
+			sbi_fp_save(&ctx->fp_ctx);
+			owner->fp = ctx;
+		} else if (owner->fp != ctx) {
+			/* The domain may have changed registers it did not own */
+			owner->fp = NULL;
+		}
+		if (lazy_restore_needed(owner->fp, dom_ctx)) {
+			sbi_fp_restore(&dom_ctx->fp_ctx);
+			owner->fp = dom_ctx;
+		}
+	}
+
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_V)) {
+		if (lazy_save_needed(EXTRACT_FIELD(out, MSTATUS_VS))) {
+			sbi_vector_save(ctx->vec_ctx);
+			owner->vec = ctx;
+		} else if (owner->vec != ctx) {
+			/* The domain may have changed registers it did not own */
+			owner->vec = NULL;
+		}
+		if (lazy_restore_needed(owner->vec, dom_ctx)) {
+			sbi_vector_restore(dom_ctx->vec_ctx);
+			owner->vec = dom_ctx;
+		}
+	}
+}
+#else
+static void switch_fp_vector_context(struct sbi_scratch *scratch,
+				     struct hart_context *ctx,
+				     struct hart_context *dom_ctx)
+{
+	/* Eager context switch for float */
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_F) ||
+	    sbi_hart_has_extension(scratch, SBI_HART_EXT_D)) {
+		sbi_fp_save(&ctx->fp_ctx);
+		sbi_fp_restore(&dom_ctx->fp_ctx);
+	}
+
+	/* Eager context switch for vector */
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_V)) {
+		sbi_vector_save(ctx->vec_ctx);
+		sbi_vector_restore(dom_ctx->vec_ctx);
+	}
+}
+#endif
+
+#ifdef CONFIG_SBI_DOMAIN_SCHED
+/** Time slicing state of a HART */
+struct hart_sched {
+	/** Timer event ending the current time slice */
+	struct sbi_timer_event ev;
+	/** Time stamp when the current time slice started */
+	u64 slice_start;
+	/** Context running since slice_start */
+	struct hart_context *curr;
+	/** Odd while sched_time of curr or slice_start are updated */
+	unsigned long seq;
+	/** Set by the timer event when the current time slice is over */
+	bool resched;
+	/** Number of contexts in the run queue */
+	u32 count;
+	/** Run queue of contexts with a time slice budget */
+	struct hart_context *rq[];
+};
+
+static unsigned long hart_sched_offset;
+
+#define hart_sched_ptr(__scratch)					\
+	sbi_scratch_read_type((__scratch), struct hart_sched *,		\
+			      hart_sched_offset)
+
+static void hart_sched_event_callback(struct sbi_timer_event *ev,
+				      struct sbi_timer_event_restart *restart)
+{
+	struct hart_sched *hs = ev->priv;
+
+	/* Domains are switched when the trap returns to the lower mode */
+	hs->resched = true;
+}
+
+/*
+ * Other HARTs read sched_time and slice_start locklessly, so updates
+ * are wrapped in a sequence count to avoid torn 64-bit values on RV32.
+ */
+static void hart_sched_write_begin(struct hart_sched *hs)
+{
+	hs->seq++;
+	smp_wmb();
+}
+
+static void hart_sched_write_end(struct hart_sched *hs)
+{
+	smp_wmb();
+	hs->seq++;
+}
+
+static void hart_sched_account(struct hart_sched *hs,
+			       struct hart_context *ctx,
+			       struct hart_context *next, u64 now)
+{
+	u64 used = now - hs->slice_start;
+
+	hart_sched_write_begin(hs);
+	ctx->sched_time += used;
+	hs->slice_start = now;
+	hs->curr = next;
+	hart_sched_write_end(hs);
+
+	ctx->sched_left -= MIN(used, ctx->sched_left);
+}
+
+static void hart_sched_start_slice(struct hart_sched *hs,
+				   struct hart_context *ctx)
+{
+	hs->resched = false;
+	if (!ctx->sched_budget || hs->count < 2) {
+		sbi_timer_event_stop(&hs->ev);
+		return;
+	}
+
+	/* An exhausted context is preempted right away */
+	sbi_timer_event_start(&hs->ev, hs->slice_start + ctx->sched_left);
+}
+
+static void hart_sched_switch(struct sbi_scratch *scratch,
+			      struct hart_context *ctx,
+			      struct hart_context *dom_ctx)
+{
+	struct hart_sched *hs = hart_sched_ptr(scratch);
+
+	/* Time slicing is not started on this HART */
+	if (!hs)
+		return;
+
+	hart_sched_account(hs, ctx, dom_ctx, sbi_timer_value());
+	hart_sched_start_slice(hs, dom_ctx);
+}
+#else
+static void hart_sched_switch(struct sbi_scratch *scratch,
+			      struct hart_context *ctx,
+			      struct hart_context *dom_ctx)
+{
+}
+#endif
+
 /**
  * Switches the HART context from the current domain to the target domain.
  * This includes changing domain assignments and reconfiguring PMP, as well
@@ -110,6 +314,7 @@ static int switch_to_next_domain_context(struct hart_context *ctx,
 {
 	u32 hartindex = current_hartindex();
 	struct sbi_trap_context *trap_ctx;
+	int rc;
 	struct sbi_domain *current_dom, *target_dom;
 	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
 
@@ -118,6 +323,11 @@ static int switch_to_next_domain_context(struct hart_context *ctx,
 
 	current_dom = ctx->dom;
 	target_dom = dom_ctx->dom;
+
+	/* Trace shared memory is owned by the current domain */
+	sbi_trace(DOMAIN_SWITCH, current_dom->index, target_dom->index);
+	sbi_trace_flush();
+
 	/* Assign current hart to target domain */
 	spin_lock(&current_dom->assigned_harts_lock);
 	sbi_hartmask_clear_hartindex(hartindex, &current_dom->assigned_harts);
@@ -145,33 +355,38 @@ static int switch_to_next_domain_context(struct hart_context *ctx,
 		ctx->senvcfg	= csr_swap(CSR_SENVCFG, dom_ctx->senvcfg);
 	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SSQOSID))
 		ctx->srmcfg	= csr_swap(CSR_SRMCFG, dom_ctx->srmcfg);
+	ctx->stimer = sbi_timer_smode_event_switch(dom_ctx->stimer);
 
-	/* Eager context switch for float */
-	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_F) ||
-	    sbi_hart_has_extension(scratch, SBI_HART_EXT_D)) {
-		sbi_fp_save(&ctx->fp_ctx);
-		sbi_fp_restore(&dom_ctx->fp_ctx);
-	}
-
-	/* Eager context switch for vector */
-	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_V)) {
-		sbi_vector_save(ctx->vec_ctx);
-		sbi_vector_restore(dom_ctx->vec_ctx);
-	}
+	/* Account the time slice of current context */
+	hart_sched_switch(scratch, ctx, dom_ctx);
 
-	/* Save current trap state and restore target domain's trap state */
+	/* Save current trap state */
 	trap_ctx = sbi_trap_get_context(scratch);
 	sbi_memcpy(&ctx->trap_ctx, trap_ctx, sizeof(*trap_ctx));
+
+	/*
+	 * Switch FP and vector state, this may update the saved
+	 * mstatus of the current context.
+	 */
+	switch_fp_vector_context(scratch, ctx, dom_ctx);
+
+	/* Restore target domain's trap state */
 	sbi_memcpy(trap_ctx, &dom_ctx->trap_ctx, sizeof(*trap_ctx));
 
 	/*
 	 * Re-configure PMP settings for the new domain
 	 *
-	 * This will internally perform full SFENCE / HFENCE which
-	 * is also required for some of the above CSR updates (such
-	 * as satp CSR).
+	 * This only performs full SFENCE / HFENCE when PMP settings
+	 * changed. The above satp CSR update needs it too, so do it
+	 * here otherwise. Guest translations are not switched so
+	 * always flush them when the hypervisor extension is present.
 	 */
-	sbi_hart_protection_reconfigure(scratch, current_dom, target_dom);
+	rc = sbi_hart_protection_reconfigure(scratch, current_dom, target_dom);
+	if (rc <= 0 && (ctx->satp != dom_ctx->satp || misa_extension('H'))) {
+		__sbi_sfence_vma_all();
+		if (misa_extension('H'))
+			__sbi_hfence_gvma_all();
+	}
 
 	/* Mark current context structure initialized because context saved */
 	ctx->initialized = true;
@@ -218,6 +433,13 @@ static int hart_context_init(u32 hartindex)
 			}
 		}
 
+		ctx->stimer = -1ULL;
+#ifdef CONFIG_SBI_DOMAIN_SCHED
+		ctx->sched_budget = (u64)dom->sched_budget_us *
+				    sbi_timer_frequency() / 1000000;
+		ctx->sched_left = ctx->sched_budget;
+#endif
+
 		/* Bind context and domain */
 		ctx->dom = dom;
 		hart_context_set(dom, hartindex, ctx);
@@ -309,8 +531,205 @@ int sbi_domain_context_exit(void)
 	return switch_to_next_domain_context(ctx, dom_ctx);
 }
 
+int sbi_domain_context_raise_sip(struct sbi_domain *dom, unsigned long mask)
+{
+	struct hart_context *ctx;
+
+	if (dom == sbi_domain_thishart_ptr()) {
+		csr_set(CSR_MIP, mask);
+		return 0;
+	}
+
+	/* Pending bits are restored when the context is switched in */
+	ctx = hart_context_get(dom, current_hartindex());
+	if (!ctx || !ctx->initialized)
+		return SBI_ENOENT;
+
+	ctx->sip |= mask;
+	return 0;
+}
+
+#ifdef CONFIG_SBI_DOMAIN_SCHED
+static struct hart_sched *hart_sched_get(struct sbi_scratch *scratch)
+{
+	struct hart_sched *hs = hart_sched_ptr(scratch);
+	u32 hartindex = current_hartindex();
+	struct hart_context *ctx;
+	struct sbi_domain *dom;
+	u32 count = 0;
+
+	if (hs)
+		return hs;
+
+	if (!hart_context_thishart_get() && hart_context_init(hartindex))
+		return NULL;
+
+	sbi_domain_for_each(dom) {
+		ctx = hart_context_get(dom, hartindex);
+		if (ctx && ctx->sched_budget)
+			count++;
+	}
+
+	hs = sbi_zalloc(sizeof(*hs) + count * sizeof(*hs->rq));
+	if (!hs)
+		return NULL;
+
+	SBI_INIT_TIMER_EVENT(&hs->ev, hart_sched_event_callback, NULL, hs);
+	sbi_domain_for_each(dom) {
+		ctx = hart_context_get(dom, hartindex);
+		if (ctx && ctx->sched_budget)
+			hs->rq[hs->count++] = ctx;
+	}
+
+	/* Other HARTs may read the state as soon as it is published */
+	smp_wmb();
+	sbi_scratch_write_type(scratch, struct hart_sched *,
+			       hart_sched_offset, hs);
+	return hs;
+}
+
+static bool hart_sched_runnable(struct hart_context *ctx)
+{
+	/*
+	 * Contexts which never ran can only be started on the boot HART
+	 * of their domain. Other HARTs wait for the domain to start them.
+	 */
+	return ctx->initialized ||
+	       ctx->dom->boot_hartid == current_hartid();
+}
+
+/*
+ * Pick the runnable context with the highest priority among the ones
+ * with budget left, starting after the current context so that
+ * contexts of equal priority take turns. Once all budgets are used
+ * up, a new period starts with full budgets.
+ */
+static struct hart_context *hart_sched_pick(struct hart_sched *hs,
+					    struct hart_context *ctx)
+{
+	struct hart_context *c, *best;
+	u32 i, pass, start = 0;
+
+	for (i = 0; i < hs->count; i++) {
+		if (hs->rq[i] == ctx)
+			start = i + 1;
+	}
+
+	for (pass = 0; pass < 2; pass++) {
+		best = NULL;
+		for (i = 0; i < hs->count; i++) {
+			c = hs->rq[(start + i) % hs->count];
+			if (!c->sched_left ||
+			    (c != ctx && !hart_sched_runnable(c)))
+				continue;
+			if (!best ||
+			    best->dom->sched_priority < c->dom->sched_priority)
+				best = c;
+		}
+		if (best)
+			return best;
+
+		for (i = 0; i < hs->count; i++)
+			hs->rq[i]->sched_left = hs->rq[i]->sched_budget;
+	}
+
+	return ctx;
+}
+
+void sbi_domain_sched_process(void)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct hart_context *ctx, *next;
+	struct hart_sched *hs;
+
+	if (!hart_sched_offset)
+		return;
+
+	hs = hart_sched_ptr(scratch);
+	if (!hs || !hs->resched)
+		return;
+
+	ctx = hart_context_thishart_get();
+	if (!ctx)
+		return;
+
+	hart_sched_account(hs, ctx, ctx, sbi_timer_value());
+	next = hart_sched_pick(hs, ctx);
+	if (next == ctx ||
+	    switch_to_next_domain_context(ctx, next))
+		hart_sched_start_slice(hs, ctx);
+}
+
+int sbi_domain_sched_start(struct sbi_scratch *scratch)
+{
+	struct hart_context *ctx;
+	struct hart_sched *hs;
+
+	if (!hart_sched_offset)
+		return 0;
+
+	hs = hart_sched_get(scratch);
+	if (!hs)
+		return SBI_ENOMEM;
+
+	ctx = hart_context_thishart_get();
+	if (!ctx)
+		return SBI_EINVAL;
+
+	hart_sched_write_begin(hs);
+	hs->slice_start = sbi_timer_value();
+	hs->curr = ctx;
+	hart_sched_write_end(hs);
+
+	hart_sched_start_slice(hs, ctx);
+	return 0;
+}
+
+static u64 hart_sched_time(struct hart_sched *hs, struct hart_context *ctx)
+{
+	unsigned long seq;
+	u64 ret;
+
+	if (!hs)
+		return ctx->sched_time;
+
+	do {
+		seq = hs->seq;
+		smp_rmb();
+		ret = ctx->sched_time;
+		if (hs->curr == ctx)
+			ret += sbi_timer_value() - hs->slice_start;
+		smp_rmb();
+	} while ((seq & 1) || seq != hs->seq);
+
+	return ret;
+}
+
+u64 sbi_domain_sched_time(const struct sbi_domain *dom)
+{
+	struct hart_context *ctx;
+	u64 ret = 0;
+	u32 i;
+
+	if (!hart_sched_offset)
+		return 0;
+
+	sbi_hartmask_for_each_hartindex(i, dom->possible_harts) {
+		ctx = hart_context_get((struct sbi_domain *)dom, i);
+		if (ctx)
+			ret += hart_sched_time(
+				hart_sched_ptr(sbi_hartindex_to_scratch(i)),
+				ctx);
+	}
+
+	return ret;
+}
+#endif
+
 int sbi_domain_context_init(void)
 {
+	int rc;
+
 	/**
 	 * Allocate per-domain and per-hart context data.
 	 * The data type is "struct hart_context **" whose memory space will be
@@ -319,10 +738,49 @@ int sbi_domain_context_init(void)
 	 */
 	dcpriv.data_size = sizeof(struct hart_context *) * sbi_hart_count();
 
-	return sbi_domain_register_data(&dcpriv);
+#ifdef CONFIG_SBI_DOMAIN_LAZY_FPV
+	hart_context_owner_offset =
+		sbi_scratch_alloc_type_offset(struct hart_context_owner);
+	if (!hart_context_owner_offset)
+		return SBI_ENOMEM;
+#endif
+
+#ifdef CONFIG_SBI_DOMAIN_SCHED
+	hart_sched_offset = sbi_scratch_alloc_type_offset(struct hart_sched *);
+	if (!hart_sched_offset) {
+		rc = SBI_ENOMEM;
+		goto fail_free_owner;
+	}
+#endif
+
+	rc = sbi_domain_register_data(&dcpriv);
+	if (rc)
+		goto fail_free_sched;
+
+	return 0;
+
+fail_free_sched:
+#ifdef CONFIG_SBI_DOMAIN_SCHED
+	sbi_scratch_free_offset(hart_sched_offset);
+	hart_sched_offset = 0;
+fail_free_owner:
+#endif
+#ifdef CONFIG_SBI_DOMAIN_LAZY_FPV
+	sbi_scratch_free_offset(hart_context_owner_offset);
+	hart_context_owner_offset = 0;
+#endif
+	return rc;
 }
 
 void sbi_domain_context_deinit(void)
 {
 	sbi_domain_unregister_data(&dcpriv);
+#ifdef CONFIG_SBI_DOMAIN_SCHED
+	sbi_scratch_free_offset(hart_sched_offset);
+	hart_sched_offset = 0;
+#endif
+#ifdef CONFIG_SBI_DOMAIN_LAZY_FPV
+	sbi_scratch_free_offset(hart_context_owner_offset);
+	hart_context_owner_offset = 0;
+#endif
 }
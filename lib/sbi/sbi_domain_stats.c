@@ -0,0 +1,196 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_domain_context.h>
+#include <sbi/sbi_domain_stats.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_timer.h>
+
+/*
+ * Per-domain statistics
+ *
+ * Each domain has one struct sbi_domain_stats per HART in its domain
+ * data. A HART only updates its own instance of the domain it runs so
+ * updates need neither locks nor atomics, and readers sum all
+ * instances. Readers may see a counter being updated by another HART
+ * which is fine for statistics.
+ */
+
+static struct sbi_domain_data dstats_data;
+
+static inline struct sbi_domain_stats *dstats_ptr(const struct sbi_domain *dom,
+						  u32 hartindex)
+{
+	struct sbi_domain_stats *stats;
+
+	stats = sbi_domain_data_ptr((struct sbi_domain *)dom, &dstats_data);
+	return stats ? &stats[hartindex] : NULL;
+}
+
+static inline struct sbi_domain_stats *dstats_thishart_ptr(void)
+{
+	u32 hartindex = current_hartindex();
+
+	return dstats_ptr(sbi_hartindex_to_domain(hartindex), hartindex);
+}
+
+void __sbi_domain_stats_add(enum sbi_domain_stats_counter counter, u64 val)
+{
+	struct sbi_domain_stats *stats = dstats_thishart_ptr();
+
+	if (stats)
+		stats->counters[counter] += val;
+}
+
+static void dstats_add_ecall(struct sbi_domain_stats *stats,
+			     unsigned long extid, u64 count)
+{
+	struct sbi_domain_stats_ecall *ent = stats->ecalls;
+	u32 i;
+
+	for (i = 0; i < stats->nr_ecalls; i++) {
+		if (ent[i].extid == extid) {
+			ent[i].count += count;
+			return;
+		}
+	}
+
+	if (stats->nr_ecalls == SBI_DOMAIN_STATS_ECALL_SLOTS) {
+		stats->ecalls_dropped += count;
+		return;
+	}
+
+	ent = &ent[stats->nr_ecalls];
+	ent->extid = extid;
+	ent->count = count;
+	stats->nr_ecalls++;
+}
+
+void sbi_domain_stats_ecall(unsigned long extid)
+{
+	struct sbi_domain_stats *stats = dstats_thishart_ptr();
+
+	if (stats)
+		dstats_add_ecall(stats, extid, 1);
+}
+
+void sbi_domain_stats_trap_begin(struct sbi_domain_stats_trap *trap)
+{
+	trap->dom = sbi_domain_thishart_ptr();
+	trap->start = sbi_timer_value();
+}
+
+void sbi_domain_stats_trap_end(const struct sbi_domain_stats_trap *trap,
+			       unsigned long mcause)
+{
+	struct sbi_domain_stats *stats;
+
+	/* The domain may have been switched while handling the trap */
+	stats = dstats_ptr(trap->dom, current_hartindex());
+	if (!stats)
+		return;
+
+	stats->counters[SBI_DOMAIN_STATS_MMODE_TIME] +=
+				sbi_timer_value() - trap->start;
+	stats->counters[SBI_DOMAIN_STATS_TRAPS]++;
+
+	switch (mcause) {
+	case CAUSE_ILLEGAL_INSTRUCTION:
+	case CAUSE_MISALIGNED_LOAD:
+	case CAUSE_MISALIGNED_STORE:
+	case CAUSE_LOAD_ACCESS:
+	case CAUSE_STORE_ACCESS:
+		stats->counters[SBI_DOMAIN_STATS_EMUL_TRAPS]++;
+		break;
+	default:
+		break;
+	}
+}
+
+int sbi_domain_stats_read(const struct sbi_domain *dom,
+			  struct sbi_domain_stats *out)
+{
+	struct sbi_domain_stats *stats;
+	u32 i, j;
+
+	if (!dom || !out)
+		return SBI_EINVAL;
+
+	sbi_memset(out, 0, sizeof(*out));
+	sbi_hartmask_for_each_hartindex(i, dom->possible_harts) {
+		stats = dstats_ptr(dom, i);
+		if (!stats)
+			return SBI_ENOENT;
+
+		for (j = 0; j < SBI_DOMAIN_STATS_MAX; j++)
+			out->counters[j] += stats->counters[j];
+		for (j = 0; j < stats->nr_ecalls; j++)
+			dstats_add_ecall(out, stats->ecalls[j].extid,
+					 stats->ecalls[j].count);
+		out->ecalls_dropped += stats->ecalls_dropped;
+	}
+
+	/* Accounted by the domain scheduler instead of per HART */
+	out->counters[SBI_DOMAIN_STATS_SCHED_TIME] = sbi_domain_sched_time(dom);
+
+	return 0;
+}
+
+void sbi_domain_stats_dump(const struct sbi_domain *dom, const char *suffix)
+{
+	struct sbi_domain_stats stats;
+	u32 i;
+
+	if (sbi_domain_stats_read(dom, &stats))
+		return;
+
+	sbi_printf("Domain%d M-mode Time %s: %lu ticks in %lu traps\n",
+		   dom->index, suffix,
+		   (ulong)stats.counters[SBI_DOMAIN_STATS_MMODE_TIME],
+		   (ulong)stats.counters[SBI_DOMAIN_STATS_TRAPS]);
+
+	sbi_printf("Domain%d IPIs        %s: %lu sent, %lu received\n",
+		   dom->index, suffix,
+		   (ulong)stats.counters[SBI_DOMAIN_STATS_IPI_SENT],
+		   (ulong)stats.counters[SBI_DOMAIN_STATS_IPI_RECVD]);
+
+	sbi_printf("Domain%d RFENCEs     %s: %lu\n", dom->index, suffix,
+		   (ulong)stats.counters[SBI_DOMAIN_STATS_RFENCE]);
+
+	sbi_printf("Domain%d EmulTraps   %s: %lu\n", dom->index, suffix,
+		   (ulong)stats.counters[SBI_DOMAIN_STATS_EMUL_TRAPS]);
+
+	sbi_printf("Domain%d Ecalls      %s:", dom->index, suffix);
+	for (i = 0; i < stats.nr_ecalls; i++)
+		sbi_printf(" 0x%lx=%lu", (ulong)stats.ecalls[i].extid,
+			   (ulong)stats.ecalls[i].count);
+	if (stats.ecalls_dropped)
+		sbi_printf(" other=%lu", (ulong)stats.ecalls_dropped);
+	sbi_printf("\n");
+}
+
+unsigned long sbi_domain_stats_heap_size(u32 domain_count, u32 hart_count)
+{
+	return sizeof(struct sbi_domain_stats) * hart_count * domain_count;
+}
+
+int sbi_domain_stats_init(void)
+{
+	dstats_data.data_size = sizeof(struct sbi_domain_stats) *
+				sbi_hart_count();
+
+	return sbi_domain_register_data(&dstats_data);
+}
+
+void sbi_domain_stats_deinit(void)
+{
+	sbi_domain_unregister_data(&dstats_data);
+}
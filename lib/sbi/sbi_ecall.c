@@ -8,10 +8,12 @@
  */
 
 #include <sbi/sbi_console.h>
+#include <sbi/sbi_domain_stats.h>
 #include <sbi/sbi_ecall.h>
 #include <sbi/sbi_ecall_interface.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_string.h>
+#include <sbi/sbi_trace.h>
 #include <sbi/sbi_trap.h>
 
 extern struct sbi_ecall_extension *const sbi_ecall_exts[];
@@ -127,6 +129,9 @@ int sbi_ecall_handler(struct sbi_trap_context *tcntx)
 	struct sbi_ecall_return out = {0};
 	bool is_0_1_spec = 0;
 
+	sbi_trace(ECALL, extension_id, func_id);
+	sbi_domain_stats_ecall(extension_id);
+
 	ext = sbi_ecall_find_extension(extension_id);
 	if (ext && ext->handle) {
 		ret = ext->handle(extension_id, func_id, regs, &out);
@@ -15,6 +15,7 @@
 #include <sbi/sbi_trap.h>
 #include <sbi/riscv_asm.h>
 #include <sbi/sbi_hart_protection.h>
+#include <sbi/sbi_shmem.h>
 
 static int sbi_ecall_dbcn_handler(unsigned long extid, unsigned long funcid,
 				  struct sbi_trap_regs *regs,
@@ -42,9 +43,8 @@ static int sbi_ecall_dbcn_handler(unsigned long extid, unsigned long funcid,
 		if (regs->a2)
 			return SBI_ERR_FAILED;
 
-		if (!sbi_domain_check_addr_range(sbi_domain_thishart_ptr(),
-					regs->a1, regs->a0, smode,
-					SBI_DOMAIN_READ|SBI_DOMAIN_WRITE))
+		if (sbi_shmem_check(smode, regs->a1, regs->a2, regs->a0, 1,
+				    SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
 			return SBI_ERR_INVALID_PARAM;
 		sbi_hart_protection_map_range(regs->a1, regs->a0);
 		if (funcid == SBI_EXT_DBCN_CONSOLE_WRITE)
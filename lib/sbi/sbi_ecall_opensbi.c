@@ -0,0 +1,281 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_domain_channel.h>
+#include <sbi/sbi_domain_stats.h>
+#include <sbi/sbi_ecall.h>
+#include <sbi/sbi_ecall_interface.h>
+#include <sbi/sbi_emuprof.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_fwlog.h>
+#include <sbi/sbi_hart_protection.h>
+#include <sbi/sbi_residency.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_shmem.h>
+#include <sbi/sbi_trace.h>
+#include <sbi/sbi_trap.h>
+#include <sbi/sbi_trapstat.h>
+
+#if defined(CONFIG_SBI_FWLOG) || defined(CONFIG_SBI_TRACE) || \
+    defined(CONFIG_SBI_EMUPROF) || defined(CONFIG_SBI_TRAPSTAT) || \
+    defined(CONFIG_SBI_RESIDENCY) || defined(CONFIG_SBI_DOMAIN_CHANNEL) || \
+    defined(CONFIG_SBI_DOMAIN_STATS)
+/* Validate a buffer passed by the caller which M-mode will write to */
+static int opensbi_check_shmem(unsigned long size, unsigned long addr_lo,
+			       unsigned long addr_hi, unsigned long align)
+{
+	ulong smode = (csr_read(CSR_MSTATUS) & MSTATUS_MPP) >>
+			MSTATUS_MPP_SHIFT;
+
+	return sbi_shmem_check(smode, addr_lo, addr_hi, size, align,
+			       SBI_DOMAIN_READ | SBI_DOMAIN_WRITE);
+}
+#endif
+
+#if defined(CONFIG_SBI_FWLOG) || defined(CONFIG_SBI_EMUPROF) || \
+    defined(CONFIG_SBI_TRAPSTAT) || defined(CONFIG_SBI_RESIDENCY) || \
+    defined(CONFIG_SBI_DOMAIN_CHANNEL) || defined(CONFIG_SBI_DOMAIN_STATS)
+/**
+ * Function filling a buffer passed by the caller
+ *
+ * Returns the value passed back to the caller or a negative error code.
+ */
+typedef long (*opensbi_fill_t)(const struct sbi_trap_regs *regs,
+			       void *buf, unsigned long size);
+
+/* Validate and map a buffer passed by the caller and fill it */
+static int opensbi_fill_shmem(const struct sbi_trap_regs *regs,
+			      struct sbi_ecall_return *out, opensbi_fill_t fill,
+			      unsigned long size, unsigned long addr_lo,
+			      unsigned long addr_hi)
+{
+	long ret;
+
+	ret = opensbi_check_shmem(size, addr_lo, addr_hi, sizeof(u64));
+	if (ret)
+		return ret;
+
+	sbi_hart_protection_map_range(addr_lo, size);
+	ret = fill(regs, (void *)addr_lo, size);
+	sbi_hart_protection_unmap_range(addr_lo, size);
+	if (ret < 0)
+		return ret;
+
+	out->value = ret;
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_SBI_FWLOG) || defined(CONFIG_SBI_EMUPROF) || \
+    defined(CONFIG_SBI_TRAPSTAT) || defined(CONFIG_SBI_RESIDENCY)
+/* HART index of a HART of the calling domain or -1U */
+static u32 opensbi_hartindex(unsigned long hartid)
+{
+	u32 hartindex = sbi_hartid_to_hartindex(hartid);
+
+	if (!sbi_hartindex_valid(hartindex) ||
+	    !sbi_domain_is_assigned_hart(sbi_domain_thishart_ptr(), hartindex))
+		return -1U;
+
+	return hartindex;
+}
+#endif
+
+#ifdef CONFIG_SBI_FWLOG
+static long opensbi_log_fill(const struct sbi_trap_regs *regs,
+			     void *buf, unsigned long size)
+{
+	u32 hartindex = opensbi_hartindex(regs->a0);
+
+	if (hartindex == -1U || size < sizeof(struct sbi_fwlog_record))
+		return SBI_EINVAL;
+
+	return sbi_fwlog_read(hartindex, regs->a1, buf,
+			      size / sizeof(struct sbi_fwlog_record));
+}
+#endif
+
+#ifdef CONFIG_SBI_TRACE
+static int opensbi_trace_set_shmem(struct sbi_trap_regs *regs)
+{
+	unsigned long addr = regs->a0, size = regs->a2;
+	int rc;
+
+	if (addr == -1UL && regs->a1 == -1UL) {
+		sbi_trace_disable();
+		return 0;
+	}
+
+	rc = opensbi_check_shmem(size, addr, regs->a1, sizeof(u64));
+	if (rc)
+		return rc;
+
+	return sbi_trace_set_shmem(addr, size, regs->a3);
+}
+#endif
+
+#ifdef CONFIG_SBI_EMUPROF
+static long opensbi_emuprof_fill(const struct sbi_trap_regs *regs,
+				 void *buf, unsigned long size)
+{
+	u32 hartindex = opensbi_hartindex(regs->a0);
+
+	if (hartindex == -1U || (regs->a1 & ~SBI_EMUPROF_READ_RESET) ||
+	    size < sizeof(struct sbi_emuprof_header))
+		return SBI_EINVAL;
+
+	return sbi_emuprof_read(hartindex, regs->a1, buf, size);
+}
+#endif
+
+#ifdef CONFIG_SBI_TRAPSTAT
+static long opensbi_trapstat_fill(const struct sbi_trap_regs *regs,
+				  void *buf, unsigned long size)
+{
+	u32 hartindex = opensbi_hartindex(regs->a0);
+
+	if (hartindex == -1U || (regs->a1 & ~SBI_TRAPSTAT_READ_RESET) ||
+	    size < sizeof(struct sbi_trapstat_header))
+		return SBI_EINVAL;
+
+	return sbi_trapstat_read(hartindex, regs->a1, buf, size);
+}
+
+static int opensbi_trapstat_dump(struct sbi_trap_regs *regs)
+{
+	u32 hartindex = opensbi_hartindex(regs->a0);
+
+	if (hartindex == -1U)
+		return SBI_EINVAL;
+
+	sbi_trapstat_dump(hartindex);
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_SBI_RESIDENCY
+static long opensbi_residency_fill(const struct sbi_trap_regs *regs,
+				   void *buf, unsigned long size)
+{
+	u32 hartindex = opensbi_hartindex(regs->a0);
+
+	if (hartindex == -1U)
+		return SBI_EINVAL;
+
+	return sbi_residency_get(hartindex, buf);
+}
+#endif
+
+#ifdef CONFIG_SBI_DOMAIN_CHANNEL
+static long opensbi_channel_fill(const struct sbi_trap_regs *regs,
+				 void *buf, unsigned long size)
+{
+	int rc;
+
+	rc = sbi_domain_channel_get_info(regs->a0, buf);
+	if (rc)
+		return rc;
+
+	return sbi_domain_channel_count();
+}
+#endif
+
+#ifdef CONFIG_SBI_DOMAIN_STATS
+static long opensbi_domain_stats_fill(const struct sbi_trap_regs *regs,
+				      void *buf, unsigned long size)
+{
+	struct sbi_domain *cur = sbi_domain_thishart_ptr();
+	struct sbi_domain *dom;
+
+	sbi_domain_for_each(dom) {
+		if (dom->index == regs->a0)
+			break;
+	}
+	if (&dom->node == &domain_list)
+		return SBI_EINVAL;
+
+	/* Only the root domain can read the statistics of other domains */
+	if (cur != &root && cur != dom)
+		return SBI_EDENIED;
+
+	return sbi_domain_stats_read(dom, buf);
+}
+#endif
+
+static int sbi_ecall_opensbi_handler(unsigned long extid, unsigned long funcid,
+				     struct sbi_trap_regs *regs,
+				     struct sbi_ecall_return *out)
+{
+	switch (funcid) {
+#ifdef CONFIG_SBI_FWLOG
+	case SBI_EXT_OPENSBI_LOG_READ:
+		return opensbi_fill_shmem(regs, out, opensbi_log_fill,
+					  regs->a2, regs->a3, regs->a4);
+#endif
+#ifdef CONFIG_SBI_TRACE
+	case SBI_EXT_OPENSBI_TRACE_SET_SHMEM:
+		return opensbi_trace_set_shmem(regs);
+	case SBI_EXT_OPENSBI_TRACE_FLUSH:
+		sbi_trace_flush();
+		return 0;
+#endif
+#ifdef CONFIG_SBI_EMUPROF
+	case SBI_EXT_OPENSBI_EMUPROF_READ:
+		return opensbi_fill_shmem(regs, out, opensbi_emuprof_fill,
+					  regs->a2, regs->a3, regs->a4);
+#endif
+#ifdef CONFIG_SBI_TRAPSTAT
+	case SBI_EXT_OPENSBI_TRAPSTAT_READ:
+		return opensbi_fill_shmem(regs, out, opensbi_trapstat_fill,
+					  regs->a2, regs->a3, regs->a4);
+	case SBI_EXT_OPENSBI_TRAPSTAT_DUMP:
+		return opensbi_trapstat_dump(regs);
+#endif
+#ifdef CONFIG_SBI_RESIDENCY
+	case SBI_EXT_OPENSBI_RESIDENCY_READ:
+		return opensbi_fill_shmem(regs, out, opensbi_residency_fill,
+					  sizeof(struct sbi_residency_info),
+					  regs->a1, regs->a2);
+#endif
+#ifdef CONFIG_SBI_DOMAIN_CHANNEL
+	case SBI_EXT_OPENSBI_CHANNEL_INFO:
+		return opensbi_fill_shmem(regs, out, opensbi_channel_fill,
+					  sizeof(struct sbi_domain_channel_info),
+					  regs->a1, regs->a2);
+	case SBI_EXT_OPENSBI_CHANNEL_NOTIFY:
+		return sbi_domain_channel_notify(regs->a0);
+	case SBI_EXT_OPENSBI_CHANNEL_SET_DOORBELL:
+		return sbi_domain_channel_set_doorbell(regs->a0, regs->a1);
+#endif
+#ifdef CONFIG_SBI_DOMAIN_STATS
+	case SBI_EXT_OPENSBI_DOMAIN_STATS_READ:
+		return opensbi_fill_shmem(regs, out, opensbi_domain_stats_fill,
+					  sizeof(struct sbi_domain_stats),
+					  regs->a1, regs->a2);
+#endif
+	default:
+		break;
+	}
+
+	return SBI_ENOTSUPP;
+}
+
+struct sbi_ecall_extension ecall_opensbi;
+
+static int sbi_ecall_opensbi_register_extensions(void)
+{
+	return sbi_ecall_register_extension(&ecall_opensbi);
+}
+
+struct sbi_ecall_extension ecall_opensbi = {
+	.name			= "opensbi",
+	.extid_start		= SBI_EXT_OPENSBI,
+	.extid_end		= SBI_EXT_OPENSBI,
+	.register_extensions	= sbi_ecall_opensbi_register_extensions,
+	.handle			= sbi_ecall_opensbi_handler,
+};
@@ -0,0 +1,146 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/sbi_emuprof.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+
+#define EMUPROF_ENTRIES		CONFIG_SBI_EMUPROF_ENTRIES
+#define EMUPROF_MAX_PROBES	4
+
+/*
+ * Per-HART emulation profile
+ *
+ * A small open addressing hash table keyed by the PC of the emulated
+ * instruction. Only the owner HART updates its table so no lock is
+ * needed. A reader on another HART may see an entry which is being
+ * updated, which is acceptable for profiling purposes.
+ */
+struct sbi_emuprof {
+	u64 dropped;
+	struct sbi_emuprof_entry ents[EMUPROF_ENTRIES];
+};
+
+static unsigned long emuprof_ptr_offset;
+
+#define emuprof_get_hart_ptr(__scratch)					\
+	sbi_scratch_read_type((__scratch), struct sbi_emuprof *,	\
+			      emuprof_ptr_offset)
+
+#define emuprof_set_hart_ptr(__scratch, __prof)				\
+	sbi_scratch_write_type((__scratch), struct sbi_emuprof *,	\
+			       emuprof_ptr_offset, (__prof))
+
+static inline unsigned long emuprof_hash(ulong pc)
+{
+	/* Instructions are at least 2-byte aligned */
+	pc >>= 1;
+	return (pc ^ (pc >> 7) ^ (pc >> 17)) % EMUPROF_ENTRIES;
+}
+
+void sbi_emuprof_record(ulong cause, ulong pc, ulong insn)
+{
+	struct sbi_emuprof_entry *ent;
+	struct sbi_emuprof *prof;
+	unsigned long i, idx;
+
+	if (!emuprof_ptr_offset)
+		return;
+
+	prof = emuprof_get_hart_ptr(sbi_scratch_thishart_ptr());
+	if (!prof)
+		return;
+
+	idx = emuprof_hash(pc);
+	for (i = 0; i < EMUPROF_MAX_PROBES; i++) {
+		ent = &prof->ents[(idx + i) % EMUPROF_ENTRIES];
+		if (ent->count && ent->pc == pc && ent->cause == cause) {
+			ent->count++;
+			return;
+		}
+		if (!ent->count) {
+			ent->pc = pc;
+			ent->cause = cause;
+			ent->insn = insn;
+			ent->count = 1;
+			return;
+		}
+	}
+
+	prof->dropped++;
+}
+
+unsigned long sbi_emuprof_read(u32 hartindex, unsigned long flags,
+			       void *out, unsigned long size)
+{
+	struct sbi_emuprof_header *hdr = out;
+	struct sbi_emuprof_entry *dst;
+	struct sbi_scratch *scratch;
+	struct sbi_emuprof *prof;
+	unsigned long i, max, count = 0;
+
+	if (!emuprof_ptr_offset || size < sizeof(*hdr))
+		return 0;
+
+	scratch = sbi_hartindex_to_scratch(hartindex);
+	if (!scratch)
+		return 0;
+
+	prof = emuprof_get_hart_ptr(scratch);
+	if (!prof)
+		return 0;
+
+	dst = (struct sbi_emuprof_entry *)(hdr + 1);
+	max = (size - sizeof(*hdr)) / sizeof(*dst);
+	for (i = 0; i < EMUPROF_ENTRIES && count < max; i++) {
+		if (!prof->ents[i].count)
+			continue;
+		sbi_memcpy(&dst[count++], &prof->ents[i], sizeof(*dst));
+	}
+
+	hdr->dropped = prof->dropped;
+	hdr->nr_entries = count;
+	hdr->hartid = sbi_hartindex_to_hartid(hartindex);
+
+	if (flags & SBI_EMUPROF_READ_RESET) {
+		sbi_memset(prof->ents, 0, sizeof(prof->ents));
+		prof->dropped = 0;
+	}
+
+	return count;
+}
+
+unsigned long sbi_emuprof_heap_size(u32 hart_count)
+{
+	return sizeof(struct sbi_emuprof) * hart_count;
+}
+
+int sbi_emuprof_init(struct sbi_scratch *scratch)
+{
+	struct sbi_scratch *hscratch;
+	struct sbi_emuprof *prof;
+
+	emuprof_ptr_offset = sbi_scratch_alloc_type_offset(struct sbi_emuprof *);
+	if (!emuprof_ptr_offset)
+		return SBI_ENOMEM;
+
+	sbi_for_each_hartindex(i) {
+		hscratch = sbi_hartindex_to_scratch(i);
+		if (!hscratch)
+			continue;
+
+		prof = sbi_zalloc(sizeof(*prof));
+		if (!prof)
+			return SBI_ENOMEM;
+		emuprof_set_hart_ptr(hscratch, prof);
+	}
+
+	return 0;
+}
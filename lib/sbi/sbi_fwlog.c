@@ -0,0 +1,166 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_atomic.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_fwlog.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_timer.h>
+
+#define FWLOG_RECORDS		CONFIG_SBI_FWLOG_RECORDS
+
+/*
+ * Per-HART firmware log
+ *
+ * Only the owner HART writes to its log so no lock is needed. The
+ * sequence number is reserved with an atomic operation so that a
+ * nested trap which logs while a record is being written gets its
+ * own record. Readers on other HARTs use the seq of each record to
+ * detect records which are being written or were overwritten.
+ */
+struct sbi_fwlog {
+	atomic_t last_seq;
+	struct sbi_fwlog_record recs[FWLOG_RECORDS];
+};
+
+static unsigned long fwlog_ptr_offset;
+
+#define fwlog_get_hart_ptr(__scratch)					\
+	sbi_scratch_read_type((__scratch), struct sbi_fwlog *,		\
+			      fwlog_ptr_offset)
+
+#define fwlog_set_hart_ptr(__scratch, __log)				\
+	sbi_scratch_write_type((__scratch), struct sbi_fwlog *,	\
+			       fwlog_ptr_offset, (__log))
+
+/*
+ * The record seq is a u64 but never exceeds last_seq, so it is
+ * accessed as an unsigned long with a single load or store. On RV32
+ * this is the low half and the high half stays zero, so readers never
+ * see a torn seq.
+ */
+static inline unsigned long fwlog_rec_seq(struct sbi_fwlog_record *rec)
+{
+	return *(volatile unsigned long *)&rec->seq;
+}
+
+static inline void fwlog_rec_set_seq(struct sbi_fwlog_record *rec,
+				     unsigned long seq)
+{
+	*(volatile unsigned long *)&rec->seq = seq;
+}
+
+void sbi_fwlog_write(const char *msg, unsigned long len)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct sbi_fwlog_record *rec;
+	struct sbi_fwlog *log;
+	unsigned long seq;
+
+	if (!fwlog_ptr_offset)
+		return;
+
+	log = fwlog_get_hart_ptr(scratch);
+	if (!log)
+		return;
+
+	if (SBI_FWLOG_MSG_SIZE < len)
+		len = SBI_FWLOG_MSG_SIZE;
+
+	seq = atomic_add_return(&log->last_seq, 1);
+	rec = &log->recs[(seq - 1) % FWLOG_RECORDS];
+
+	fwlog_rec_set_seq(rec, 0);
+	smp_wmb();
+	rec->timestamp = sbi_timer_value();
+	rec->hartid = current_hartid();
+	rec->len = len;
+	sbi_memcpy(rec->msg, msg, len);
+	smp_wmb();
+	fwlog_rec_set_seq(rec, seq);
+}
+
+unsigned long sbi_fwlog_read(u32 hartindex, u64 start_seq,
+			     struct sbi_fwlog_record *out,
+			     unsigned long max_records)
+{
+	struct sbi_fwlog_record tmp, *rec;
+	struct sbi_scratch *scratch;
+	struct sbi_fwlog *log;
+	unsigned long count = 0;
+	unsigned long seq, last_seq;
+
+	if (!fwlog_ptr_offset)
+		return 0;
+
+	scratch = sbi_hartindex_to_scratch(hartindex);
+	if (!scratch)
+		return 0;
+
+	log = fwlog_get_hart_ptr(scratch);
+	if (!log)
+		return 0;
+
+	last_seq = (unsigned long)atomic_read(&log->last_seq);
+	smp_rmb();
+
+	/* Nothing newer than last_seq, which fits in unsigned long */
+	if (last_seq < start_seq)
+		return 0;
+
+	/* Skip records which are already overwritten */
+	if (FWLOG_RECORDS < last_seq && start_seq <= last_seq - FWLOG_RECORDS)
+		start_seq = last_seq - FWLOG_RECORDS + 1;
+	if (!start_seq)
+		start_seq = 1;
+
+	for (seq = start_seq; seq <= last_seq && count < max_records; seq++) {
+		rec = &log->recs[(seq - 1) % FWLOG_RECORDS];
+		if (fwlog_rec_seq(rec) != seq)
+			continue;
+		smp_rmb();
+		sbi_memcpy(&tmp, rec, sizeof(tmp));
+		smp_rmb();
+		if (fwlog_rec_seq(rec) != seq)
+			continue;
+		sbi_memcpy(&out[count++], &tmp, sizeof(tmp));
+	}
+
+	return count;
+}
+
+unsigned long sbi_fwlog_heap_size(u32 hart_count)
+{
+	return sizeof(struct sbi_fwlog) * hart_count;
+}
+
+int sbi_fwlog_init(struct sbi_scratch *scratch)
+{
+	struct sbi_scratch *hscratch;
+	struct sbi_fwlog *log;
+
+	fwlog_ptr_offset = sbi_scratch_alloc_type_offset(struct sbi_fwlog *);
+	if (!fwlog_ptr_offset)
+		return SBI_ENOMEM;
+
+	sbi_for_each_hartindex(i) {
+		hscratch = sbi_hartindex_to_scratch(i);
+		if (!hscratch)
+			continue;
+
+		log = sbi_zalloc(sizeof(*log));
+		if (!log)
+			return SBI_ENOMEM;
+		fwlog_set_hart_ptr(hscratch, log);
+	}
+
+	return 0;
+}
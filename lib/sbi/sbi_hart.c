@@ -17,6 +17,7 @@
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_hart_pmp.h>
+#include <sbi/sbi_hart_protection.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_pmu.h>
 #include <sbi/sbi_string.h>
@@ -360,6 +361,7 @@ const struct sbi_hart_ext_data sbi_hart_ext[] = {
 	__SBI_HART_EXT_DATA(v, SBI_HART_EXT_V),
 	__SBI_HART_EXT_DATA(f, SBI_HART_EXT_F),
 	__SBI_HART_EXT_DATA(d, SBI_HART_EXT_D),
+	__SBI_HART_EXT_DATA(zbb, SBI_HART_EXT_ZBB),
 };
 
 _Static_assert(SBI_HART_EXT_MAX == array_size(sbi_hart_ext),
@@ -726,6 +728,9 @@ int sbi_hart_init(struct sbi_scratch *scratch, bool cold_boot)
 		return rc;
 
 	if (cold_boot) {
+		sbi_string_use_zbb(sbi_hart_has_extension(scratch,
+							  SBI_HART_EXT_ZBB));
+
 		rc = sbi_hart_pmp_init(scratch);
 		if (rc)
 			return rc;
@@ -734,6 +739,12 @@ int sbi_hart_init(struct sbi_scratch *scratch, bool cold_boot)
 	return sbi_hart_reinit(scratch);
 }
 
+int sbi_hart_early_init(struct sbi_scratch *scratch)
+{
+	/* Features detected here are not detected again by sbi_hart_init() */
+	return hart_detect_features(scratch, false);
+}
+
 void __attribute__((noreturn)) sbi_hart_hang(void)
 {
 	while (1)
@@ -783,6 +794,8 @@ sbi_hart_switch_mode(unsigned long arg0, unsigned long arg1,
 	csr_write(CSR_MSTATUS, val);
 	csr_write(CSR_MEPC, next_addr);
 
+	sbi_hart_protection_release_ranges();
+
 	if (next_mode == PRV_S) {
 		if (next_virt) {
 			csr_write(CSR_VSTVEC, next_addr);
@@ -9,10 +9,13 @@
 #include <sbi/sbi_domain.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_hart_protection.h>
+#include <sbi/sbi_heap.h>
 #include <sbi/sbi_hfence.h>
 #include <sbi/sbi_math.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_pmp.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
 #include <sbi/sbi_tlb.h>
 #include <sbi/riscv_asm.h>
 
@@ -143,6 +146,54 @@ int sbi_hart_pmp_get(unsigned int n, unsigned long *prot_out, unsigned long *add
 static DECLARE_BITMAP(fw_smepmp_ids, PMP_COUNT);
 static bool fw_smepmp_ids_inited;
 
+/** Number of PMP entries in each pmpcfg CSR */
+#define PMP_CFG_PER_CSR			(__riscv_xlen / 8)
+
+#if __riscv_xlen == 32
+#define PMP_CFG_CSR(__c)		(CSR_PMPCFG0 + (__c))
+#else
+#define PMP_CFG_CSR(__c)		(CSR_PMPCFG0 + ((__c) << 1))
+#endif
+
+/*
+ * Precomputed pmpcfg/pmpaddr CSR image of a domain
+ *
+ * Images are built once when domains are finalized, for the PMP
+ * parameters of the boot HART. Domain switches on HARTs with the same
+ * PMP parameters only write the CSRs which differ between the loaded
+ * and the next image. Other HARTs (and domains whose regions can't
+ * be mapped completely) go through unconfigure and configure.
+ */
+struct hart_pmp_image {
+	/** PMP parameters the image was built for (zero if not built) */
+	unsigned int pmp_count;
+	unsigned int pmp_log2gran;
+	unsigned int pmp_addr_bits;
+	/** Packed pmpcfg CSR values */
+	unsigned long cfg[PMP_COUNT / PMP_CFG_PER_CSR];
+	/** pmpaddr CSR values */
+	unsigned long addr[PMP_COUNT];
+	/** Memory region of each enabled entry (for platform hooks) */
+	const struct sbi_domain_memregion *reg[PMP_COUNT];
+	/** Smepmp firmware entries */
+	DECLARE_BITMAP(fw, PMP_COUNT);
+};
+
+static struct sbi_domain_data hart_pmp_image_data = {
+	.data_size = sizeof(struct hart_pmp_image),
+};
+
+/* Image loaded in the PMP CSRs of each HART (NULL if not known) */
+static unsigned long hart_pmp_loaded_offset;
+
+#define hart_pmp_loaded_get(__scratch)					\
+	sbi_scratch_read_type((__scratch), struct hart_pmp_image *,	\
+			      hart_pmp_loaded_offset)
+
+#define hart_pmp_loaded_set(__scratch, __img)				\
+	sbi_scratch_write_type((__scratch), struct hart_pmp_image *,	\
+			       hart_pmp_loaded_offset, (__img))
+
 unsigned int sbi_hart_pmp_count(struct sbi_scratch *scratch)
 {
 	struct sbi_hart_features *hfeatures = sbi_hart_features_ptr(scratch);
@@ -196,29 +247,6 @@ void sbi_hart_pmp_fence(void)
 	}
 }
 
-static void sbi_hart_smepmp_set(struct sbi_scratch *scratch,
-				struct sbi_domain *dom,
-				struct sbi_domain_memregion *reg,
-				unsigned int pmp_idx,
-				unsigned int pmp_flags,
-				unsigned int pmp_log2gran,
-				unsigned long pmp_addr_max)
-{
-	unsigned long pmp_addr = reg->base >> PMP_SHIFT;
-
-	if (pmp_log2gran <= reg->order && pmp_addr < pmp_addr_max) {
-		sbi_platform_pmp_set(sbi_platform_ptr(scratch),
-				     pmp_idx, reg->flags, pmp_flags,
-				     reg->base, reg->order);
-		sbi_hart_pmp_set(pmp_idx, pmp_flags, reg->base, reg->order);
-	} else {
-		sbi_printf("Can not configure pmp for domain %s because"
-			   " memory region address 0x%lx or size 0x%lx "
-			   "is not in range.\n", dom->name, reg->base,
-			   reg->order);
-	}
-}
-
 static bool is_valid_pmp_idx(unsigned int pmp_count, unsigned int pmp_idx)
 {
 	if (pmp_count > pmp_idx)
@@ -228,114 +256,88 @@ static bool is_valid_pmp_idx(unsigned int pmp_count, unsigned int pmp_idx)
 	return false;
 }
 
-static int sbi_hart_smepmp_configure(struct sbi_scratch *scratch,
-				     struct sbi_domain *dom)
-{
-	struct sbi_domain_memregion *reg;
-	unsigned int pmp_log2gran, pmp_bits;
-	unsigned int pmp_idx, pmp_count;
-	unsigned long pmp_addr_max;
-	unsigned int pmp_flags;
-
-	pmp_count = sbi_hart_pmp_count(scratch);
-	pmp_log2gran = sbi_hart_pmp_log2gran(scratch);
-	pmp_bits = sbi_hart_pmp_addrbits(scratch) - 1;
-	pmp_addr_max = (1UL << pmp_bits) | ((1UL << pmp_bits) - 1);
-
-	/*
-	 * Set the RLB so that, we can write to PMP entries without
-	 * enforcement even if some entries are locked.
-	 */
-	csr_set(CSR_MSECCFG, MSECCFG_RLB);
-
-	/* Disable the reserved entry */
-	sbi_hart_pmp_disable(SBI_SMEPMP_RESV_ENTRY);
-
-	/* Program M-only regions when MML is not set. */
-	pmp_idx = 0;
-	sbi_domain_for_each_memregion(dom, reg) {
-		/* Skip reserved entry */
-		if (pmp_idx == SBI_SMEPMP_RESV_ENTRY)
-			pmp_idx++;
-		if (!is_valid_pmp_idx(pmp_count, pmp_idx))
-			return SBI_EFAIL;
-
-		/* Skip shared and SU-only regions */
-		if (!SBI_DOMAIN_MEMREGION_M_ONLY_ACCESS(reg->flags)) {
-			pmp_idx++;
-			continue;
-		}
-
-		/*
-		 * Track firmware PMP entries to preserve them during
-		 * domain switches. Under SmePMP, M-mode requires
-		 * explicit PMP entries to access firmware code/data.
-		 * These entries must remain enabled across domain
-		 * context switches to prevent M-mode access faults.
-		 */
-		if (SBI_DOMAIN_MEMREGION_IS_FIRMWARE(reg->flags)) {
-			if (fw_smepmp_ids_inited) {
-				/* Check inconsistent firmware region */
-				if (!sbi_hart_smepmp_is_fw_region(pmp_idx))
-					return SBI_EINVAL;
-			} else {
-				bitmap_set(fw_smepmp_ids, pmp_idx, 1);
-			}
-		}
+/*
+ * Window programmed in the reserved Smepmp entry of each HART
+ *
+ * Temporary mappings are not removed by unmap_range. The window stays
+ * programmed until the HART leaves M-mode, so repeated and nested
+ * accesses to the same shared memory don't reprogram the entry.
+ *
+ * The window is never left programmed while the lower privilege mode
+ * runs unless it exactly matches shared memory registered with
+ * keep_range by the current domain. A NAPOT window rounded up around
+ * a smaller range would give S/U-mode access to memory outside of it
+ * and, since the reserved entry has the highest priority, it would
+ * also override the execute permission of the covered memory.
+ */
+struct hart_smepmp_window {
+	/* Programmed window (order is zero when the entry is disabled) */
+	unsigned long base;
+	unsigned long order;
+	/* Number of mappings using the window */
+	unsigned int users;
+	/* Registered shared memory (order is zero if none) */
+	unsigned long keep_base;
+	unsigned long keep_order;
+	const struct sbi_domain *keep_dom;
+};
 
-		pmp_flags = sbi_domain_get_smepmp_flags(reg);
+static unsigned long hart_smepmp_window_offset;
 
-		sbi_hart_smepmp_set(scratch, dom, reg, pmp_idx++, pmp_flags,
-				    pmp_log2gran, pmp_addr_max);
-	}
+#define hart_smepmp_window_ptr(__scratch)				\
+	((struct hart_smepmp_window *)					\
+	 sbi_scratch_offset_ptr((__scratch), hart_smepmp_window_offset))
 
-	fw_smepmp_ids_inited = true;
+static bool hart_smepmp_window_covers(const struct hart_smepmp_window *win,
+				      unsigned long addr, unsigned long size)
+{
+	unsigned long last = win->base + ((1UL << win->order) - 1UL);
 
-	/* Set the MML to enforce new encoding */
-	csr_set(CSR_MSECCFG, MSECCFG_MML);
+	return win->order && win->base <= addr && addr <= last &&
+	       size - 1UL <= last - addr;
+}
 
-	/* Program shared and SU-only regions */
-	pmp_idx = 0;
-	sbi_domain_for_each_memregion(dom, reg) {
-		/* Skip reserved entry */
-		if (pmp_idx == SBI_SMEPMP_RESV_ENTRY)
-			pmp_idx++;
-		if (!is_valid_pmp_idx(pmp_count, pmp_idx))
-			return SBI_EFAIL;
+/* Forget the window after the reserved entry was reprogrammed */
+static void hart_smepmp_window_reset(struct sbi_scratch *scratch)
+{
+	struct hart_smepmp_window *win;
 
-		/* Skip M-only regions */
-		if (SBI_DOMAIN_MEMREGION_M_ONLY_ACCESS(reg->flags)) {
-			pmp_idx++;
-			continue;
-		}
+	if (!hart_smepmp_window_offset)
+		return;
 
-		pmp_flags = sbi_domain_get_smepmp_flags(reg);
+	win = hart_smepmp_window_ptr(scratch);
+	win->order = 0;
+	win->users = 0;
+}
 
-		sbi_hart_smepmp_set(scratch, dom, reg, pmp_idx++, pmp_flags,
-				    pmp_log2gran, pmp_addr_max);
-	}
-	/* Disable remaining PMP entries */
-	for(; pmp_idx < pmp_count; pmp_idx++)
-		sbi_hart_pmp_disable(pmp_idx);
+static void hart_smepmp_window_disable(struct sbi_scratch *scratch)
+{
+	struct hart_smepmp_window *win = hart_smepmp_window_ptr(scratch);
 
-	/*
-	 * All entries are programmed.
-	 * Keep the RLB bit so that dynamic mappings can be done.
-	 */
+	if (!win->order)
+		return;
 
-	sbi_hart_pmp_fence();
-	return 0;
+	sbi_platform_pmp_disable(sbi_platform_ptr(scratch), SBI_SMEPMP_RESV_ENTRY);
+	sbi_hart_pmp_disable(SBI_SMEPMP_RESV_ENTRY);
+	hart_smepmp_window_reset(scratch);
 }
 
 static int sbi_hart_smepmp_map_range(struct sbi_scratch *scratch,
 				     unsigned long addr, unsigned long size)
 {
+	struct hart_smepmp_window *win = hart_smepmp_window_ptr(scratch);
 	/* shared R/W access for M and S/U mode */
 	unsigned int pmp_flags = (PMP_W | PMP_X);
 	unsigned long order, base = 0;
 
-	if (sbi_hart_is_pmp_enabled(SBI_SMEPMP_RESV_ENTRY))
-		return SBI_ENOSPC;
+	if (win->order) {
+		if (hart_smepmp_window_covers(win, addr, size)) {
+			win->users++;
+			return SBI_OK;
+		}
+		if (win->users)
+			return SBI_ENOSPC;
+	}
 
 	for (order = MAX(sbi_hart_pmp_log2gran(scratch), log2roundup(size));
 	     order <= __riscv_xlen; order++) {
@@ -351,75 +353,708 @@ static int sbi_hart_smepmp_map_range(struct sbi_scratch *scratch,
 		}
 	}
 
+	hart_smepmp_window_disable(scratch);
 	sbi_platform_pmp_set(sbi_platform_ptr(scratch), SBI_SMEPMP_RESV_ENTRY,
 			     SBI_DOMAIN_MEMREGION_SHARED_SURW_MRW,
 			     pmp_flags, base, order);
 	sbi_hart_pmp_set(SBI_SMEPMP_RESV_ENTRY, pmp_flags, base, order);
 
+	win->base = base;
+	win->order = order;
+	win->users = 1;
+
 	return SBI_OK;
 }
 
 static int sbi_hart_smepmp_unmap_range(struct sbi_scratch *scratch,
 				       unsigned long addr, unsigned long size)
 {
-	sbi_platform_pmp_disable(sbi_platform_ptr(scratch), SBI_SMEPMP_RESV_ENTRY);
-	return sbi_hart_pmp_disable(SBI_SMEPMP_RESV_ENTRY);
+	struct hart_smepmp_window *win = hart_smepmp_window_ptr(scratch);
+
+	if (!hart_smepmp_window_covers(win, addr, size))
+		return SBI_EINVAL;
+
+	if (win->users)
+		win->users--;
+
+	return SBI_OK;
 }
 
-static int sbi_hart_oldpmp_configure(struct sbi_scratch *scratch,
+static int sbi_hart_smepmp_keep_range(struct sbi_scratch *scratch,
+				      unsigned long addr, unsigned long size)
+{
+	struct hart_smepmp_window *win = hart_smepmp_window_ptr(scratch);
+	unsigned long order = log2roundup(size);
+
+	/* Only keep windows which match the shared memory exactly */
+	if (!size || order >= __riscv_xlen || size != (1UL << order) ||
+	    (addr & (size - 1UL)) || order < sbi_hart_pmp_log2gran(scratch))
+		return SBI_EINVAL;
+
+	win->keep_base = addr;
+	win->keep_order = order;
+	win->keep_dom = sbi_domain_thishart_ptr();
+
+	return SBI_OK;
+}
+
+static void sbi_hart_smepmp_forget_range(struct sbi_scratch *scratch,
+					 unsigned long addr, unsigned long size)
+{
+	struct hart_smepmp_window *win = hart_smepmp_window_ptr(scratch);
+
+	if (win->keep_order && win->keep_base == addr &&
+	    size == (1UL << win->keep_order))
+		win->keep_order = 0;
+}
+
+static void sbi_hart_smepmp_release_ranges(struct sbi_scratch *scratch)
+{
+	struct hart_smepmp_window *win = hart_smepmp_window_ptr(scratch);
+
+	if (!win->order)
+		return;
+
+	if (win->keep_order && win->base == win->keep_base &&
+	    win->order == win->keep_order &&
+	    win->keep_dom == sbi_domain_thishart_ptr()) {
+		win->users = 0;
+		return;
+	}
+
+	hart_smepmp_window_disable(scratch);
+}
+
+static void sbi_hart_pmp_unconfigure(struct sbi_scratch *scratch,
 				     struct sbi_domain *dom)
 {
+	int i, pmp_count = sbi_hart_pmp_count(scratch);
+
+	hart_pmp_loaded_set(scratch, NULL);
+	hart_smepmp_window_reset(scratch);
+
+	for (i = 0; i < pmp_count; i++) {
+		/* Don't revoke firmware access permissions */
+		if (sbi_hart_smepmp_is_fw_region(i))
+			continue;
+
+		sbi_platform_pmp_disable(sbi_platform_ptr(scratch), i);
+		sbi_hart_pmp_disable(i);
+	}
+}
+
+/* Address range of a memory region or of merged memory regions */
+struct hart_pmp_range {
+	unsigned long start;
+	/* Last address (inclusive) so that the top of address space fits */
+	unsigned long last;
 	struct sbi_domain_memregion *reg;
-	unsigned long pmp_addr, pmp_addr_max;
-	unsigned int pmp_log2gran, pmp_bits;
-	unsigned int pmp_idx, pmp_count;
-	unsigned int pmp_flags;
-
-	pmp_count = sbi_hart_pmp_count(scratch);
-	pmp_log2gran = sbi_hart_pmp_log2gran(scratch);
-	pmp_bits = sbi_hart_pmp_addrbits(scratch) - 1;
-	pmp_addr_max = (1UL << pmp_bits) | ((1UL << pmp_bits) - 1);
+};
 
-	pmp_idx = 0;
-	sbi_domain_for_each_memregion(dom, reg) {
-		if (!is_valid_pmp_idx(pmp_count, pmp_idx))
+static bool hart_pmp_range_is_napot(const struct hart_pmp_range *r)
+{
+	unsigned long mask = r->last - r->start;
+
+	/* Size is a power of two and start is aligned to it */
+	return !(mask & (mask + 1)) && !(r->start & mask);
+}
+
+static bool hart_pmp_range_fits(const struct hart_pmp_range *r,
+				unsigned long pmp_addr_max)
+{
+	if (hart_pmp_range_is_napot(r))
+		return true;
+
+	/* TOR needs the end address in pmpaddr */
+	return r->last != -1UL && ((r->last + 1) >> PMP_SHIFT) <= pmp_addr_max;
+}
+
+static bool hart_pmp_range_overlap(const struct hart_pmp_range *a,
+				   const struct hart_pmp_range *b)
+{
+	return a->start <= b->last && b->start <= a->last;
+}
+
+static bool hart_pmp_range_touch(const struct hart_pmp_range *a,
+				 const struct hart_pmp_range *b)
+{
+	return (a->last == -1UL || b->start <= a->last + 1) &&
+	       (b->last == -1UL || a->start <= b->last + 1);
+}
+
+/*
+ * Merge ranges with identical region flags whose union is contiguous.
+ * PMP entries match in priority order, so a later range can only be
+ * folded into an earlier one when no range between them overlaps it.
+ */
+static unsigned int hart_pmp_merge_ranges(struct hart_pmp_range *r,
+					  unsigned int nr,
+					  unsigned long pmp_addr_max)
+{
+	struct hart_pmp_range m;
+	unsigned int i, j, k;
+
+	for (i = 0; i < nr; i++) {
+		for (j = i + 1; j < nr; j++) {
+			if (r[i].reg->flags != r[j].reg->flags ||
+			    !hart_pmp_range_touch(&r[i], &r[j]))
+				continue;
+
+			m.start = MIN(r[i].start, r[j].start);
+			m.last = MAX(r[i].last, r[j].last);
+			m.reg = r[i].reg;
+			if (!hart_pmp_range_fits(&m, pmp_addr_max))
+				continue;
+
+			for (k = i + 1; k < j; k++) {
+				if (hart_pmp_range_overlap(&r[k], &r[j]))
+					break;
+			}
+			if (k < j)
+				continue;
+
+			r[i] = m;
+			sbi_memmove(&r[j], &r[j + 1], (nr - j - 1) * sizeof(*r));
+			nr--;
+
+			/* The grown range may now touch skipped ranges */
+			j = i;
+		}
+	}
+
+	return nr;
+}
+
+static unsigned long hart_pmp_image_cfg(const struct hart_pmp_image *img,
+					unsigned int n)
+{
+	return (img->cfg[n / PMP_CFG_PER_CSR] >>
+		((n % PMP_CFG_PER_CSR) * 8)) & 0xff;
+}
+
+static void hart_pmp_image_set(struct hart_pmp_image *img, unsigned int n,
+			       unsigned long cfg, unsigned long addr,
+			       const struct sbi_domain_memregion *reg,
+			       bool smepmp)
+{
+	img->cfg[n / PMP_CFG_PER_CSR] |= cfg << ((n % PMP_CFG_PER_CSR) * 8);
+	img->addr[n] = addr;
+	img->reg[n] = reg;
+
+	/*
+	 * Track firmware PMP entries to preserve them during
+	 * domain switches. Under SmePMP, M-mode requires
+	 * explicit PMP entries to access firmware code/data.
+	 * These entries must remain enabled across domain
+	 * context switches to prevent M-mode access faults.
+	 */
+	if (smepmp && reg && SBI_DOMAIN_MEMREGION_M_ONLY_ACCESS(reg->flags) &&
+	    SBI_DOMAIN_MEMREGION_IS_FIRMWARE(reg->flags))
+		bitmap_set(img->fw, n, 1);
+}
+
+/* Check whether pmpaddr of the entry before n can be the bottom of a TOR */
+static bool hart_pmp_image_tor_bottom(const struct hart_pmp_image *img,
+				      unsigned int n, unsigned long start,
+				      bool smepmp)
+{
+	unsigned long a;
+
+	if (!n)
+		return !start;
+	if (smepmp && n - 1 == SBI_SMEPMP_RESV_ENTRY)
+		return false;
+
+	a = hart_pmp_image_cfg(img, n - 1) & PMP_A;
+	return (!a || a == PMP_A_TOR) && img->addr[n - 1] == start >> PMP_SHIFT;
+}
+
+static int hart_pmp_image_encode(struct hart_pmp_image *img,
+				 const struct hart_pmp_range *r,
+				 unsigned int nr, unsigned int pmp_count,
+				 bool smepmp)
+{
+	unsigned int i, n = smepmp ? SBI_SMEPMP_RESV_ENTRY + 1 : 0;
+	unsigned long prot, size;
+	pmp_t pmp;
+
+	for (i = 0; i < nr; i++) {
+		prot = smepmp ? sbi_domain_get_smepmp_flags(r[i].reg) :
+				sbi_domain_get_oldpmp_flags(r[i].reg);
+
+		if (hart_pmp_range_is_napot(&r[i])) {
+			if (!is_valid_pmp_idx(pmp_count, n))
+				return SBI_EFAIL;
+
+			size = r[i].last - r[i].start + 1;
+			sbi_pmp_encode(&pmp, prot, r[i].start,
+				       size ? sbi_ffs(size) : __riscv_xlen);
+			hart_pmp_image_set(img, n++, pmp.cfg, pmp.addr,
+					   r[i].reg, smepmp);
+			continue;
+		}
+
+		/*
+		 * TOR matches from the address in the previous pmpaddr,
+		 * which can be shared with a preceding TOR or disabled
+		 * entry ending there. Otherwise a disabled entry holding
+		 * the start address goes first.
+		 */
+		if (!hart_pmp_image_tor_bottom(img, n, r[i].start, smepmp)) {
+			if (!is_valid_pmp_idx(pmp_count, n))
+				return SBI_EFAIL;
+			hart_pmp_image_set(img, n++, 0, r[i].start >> PMP_SHIFT,
+					   NULL, smepmp);
+		}
+
+		if (!is_valid_pmp_idx(pmp_count, n))
 			return SBI_EFAIL;
+		hart_pmp_image_set(img, n++, (prot & ~PMP_A) | PMP_A_TOR,
+				   (r[i].last + 1) >> PMP_SHIFT, r[i].reg, smepmp);
+	}
 
-		pmp_flags = sbi_domain_get_oldpmp_flags(reg);
-		pmp_addr = reg->base >> PMP_SHIFT;
-		if (pmp_log2gran <= reg->order && pmp_addr < pmp_addr_max) {
-			sbi_platform_pmp_set(sbi_platform_ptr(scratch),
-					     pmp_idx, reg->flags, pmp_flags,
-					     reg->base, reg->order);
-			sbi_hart_pmp_set(pmp_idx++, pmp_flags, reg->base, reg->order);
-		} else {
+	return 0;
+}
+
+static int __hart_pmp_image_build(struct sbi_domain *dom,
+				  struct hart_pmp_image *img,
+				  unsigned int pmp_count,
+				  unsigned int pmp_log2gran,
+				  unsigned int pmp_addr_bits, bool smepmp)
+{
+	struct sbi_domain_memregion *reg;
+	struct hart_pmp_range *ranges;
+	unsigned long pmp_addr_max;
+	unsigned int pmp_bits = pmp_addr_bits - 1, nr = 0;
+	int rc;
+
+	pmp_addr_max = (1UL << pmp_bits) | ((1UL << pmp_bits) - 1);
+
+	sbi_domain_for_each_memregion(dom, reg)
+		nr++;
+
+	ranges = sbi_calloc(sizeof(*ranges), nr + 1);
+	if (!ranges)
+		return SBI_ENOMEM;
+
+	nr = 0;
+	sbi_domain_for_each_memregion(dom, reg) {
+		if (reg->order < pmp_log2gran ||
+		    pmp_addr_max <= (reg->base >> PMP_SHIFT)) {
 			sbi_printf("Can not configure pmp for domain %s because"
 				   " memory region address 0x%lx or size 0x%lx "
 				   "is not in range.\n", dom->name, reg->base,
 				   reg->order);
+			continue;
+		}
+
+		ranges[nr].start = reg->base;
+		ranges[nr].last = reg->base + ((reg->order < __riscv_xlen) ?
+					       BIT(reg->order) - 1 : -1UL);
+		ranges[nr++].reg = reg;
+	}
+
+	/*
+	 * Use one NAPOT entry per region when they fit, otherwise
+	 * merge regions so that fewer (possibly TOR) entries are needed.
+	 */
+	sbi_memset(img, 0, sizeof(*img));
+	if (pmp_count < nr + (smepmp ? 1 : 0))
+		nr = hart_pmp_merge_ranges(ranges, nr, pmp_addr_max);
+	rc = hart_pmp_image_encode(img, ranges, nr, pmp_count, smepmp);
+	sbi_free(ranges);
+	if (rc)
+		return rc;
+
+	img->pmp_count = pmp_count;
+	img->pmp_log2gran = pmp_log2gran;
+	img->pmp_addr_bits = pmp_addr_bits;
+	return 0;
+}
+
+static int hart_pmp_image_build(struct sbi_scratch *scratch,
+				struct sbi_domain *dom,
+				struct hart_pmp_image *img, bool smepmp)
+{
+	return __hart_pmp_image_build(dom, img, sbi_hart_pmp_count(scratch),
+				      sbi_hart_pmp_log2gran(scratch),
+				      sbi_hart_pmp_addrbits(scratch), smepmp);
+}
+
+#ifdef CONFIG_SBIUNIT
+struct hart_pmp_image *sbi_hart_pmp_test_image(struct sbi_domain *dom,
+					       unsigned int pmp_count,
+					       unsigned int pmp_log2gran,
+					       unsigned int pmp_addr_bits,
+					       bool smepmp)
+{
+	struct hart_pmp_image *img = sbi_malloc(sizeof(*img));
+
+	if (!img)
+		return NULL;
+
+	if (__hart_pmp_image_build(dom, img, pmp_count, pmp_log2gran,
+				   pmp_addr_bits, smepmp)) {
+		sbi_free(img);
+		return NULL;
+	}
+
+	return img;
+}
+
+int sbi_hart_pmp_test_match(const struct hart_pmp_image *img,
+			    unsigned long addr, unsigned long *cfg)
+{
+	unsigned long a = addr >> PMP_SHIFT, mask;
+	unsigned int n;
+
+	for (n = 0; n < img->pmp_count; n++) {
+		*cfg = hart_pmp_image_cfg(img, n);
+
+		switch (*cfg & PMP_A) {
+		case PMP_A_TOR:
+			if ((!n || img->addr[n - 1] <= a) && a < img->addr[n])
+				return n;
+			break;
+		case PMP_A_NA4:
+			if (a == img->addr[n])
+				return n;
+			break;
+		case PMP_A_NAPOT:
+			/* Trailing ones select the size, ignore those bits */
+			mask = img->addr[n] ^ (img->addr[n] + 1);
+			if ((a & ~mask) == (img->addr[n] & ~mask))
+				return n;
+			break;
+		default:
+			break;
 		}
 	}
-	/* Disable remaining PMP entries */
-	for(; pmp_idx < pmp_count; pmp_idx++)
-		sbi_hart_pmp_disable(pmp_idx);
+
+	*cfg = 0;
+	return -1;
+}
+#endif
+
+static void sbi_hart_pmp_prepare(struct sbi_scratch *scratch,
+				 struct sbi_domain *dom)
+{
+	struct hart_pmp_image *img = sbi_domain_data_ptr(dom,
+							&hart_pmp_image_data);
+
+	if (!img)
+		return;
+
+	if (hart_pmp_image_build(scratch, dom, img,
+			sbi_hart_has_extension(scratch, SBI_HART_EXT_SMEPMP)))
+		sbi_memset(img, 0, sizeof(*img));
+}
+
+static struct hart_pmp_image *hart_pmp_image_get(struct sbi_scratch *scratch,
+						 struct sbi_domain *dom)
+{
+	struct hart_pmp_image *img = sbi_domain_data_ptr(dom,
+							&hart_pmp_image_data);
+
+	if (!img || !img->pmp_count ||
+	    img->pmp_count != sbi_hart_pmp_count(scratch) ||
+	    img->pmp_log2gran != sbi_hart_pmp_log2gran(scratch) ||
+	    img->pmp_addr_bits != sbi_hart_pmp_addrbits(scratch))
+		return NULL;
+
+	return img;
+}
+
+static void hart_pmp_image_platform_set(const struct sbi_platform *plat,
+					const struct hart_pmp_image *img,
+					unsigned int n)
+{
+	const struct sbi_domain_memregion *reg = img->reg[n];
+	unsigned long cfg = hart_pmp_image_cfg(img, n);
+	unsigned long prot, base, log2len;
+	pmp_t pmp;
+
+	if (!reg) {
+		sbi_platform_pmp_disable(plat, n);
+		return;
+	}
+
+	if ((cfg & PMP_A) == PMP_A_TOR) {
+		base = n ? img->addr[n - 1] << PMP_SHIFT : 0;
+		log2len = log2roundup((img->addr[n] << PMP_SHIFT) - base);
+	} else {
+		pmp.cfg = cfg;
+		pmp.addr = img->addr[n];
+		sbi_pmp_decode(&pmp, &prot, &base, &log2len);
+	}
+
+	sbi_platform_pmp_set(plat, n, reg->flags, cfg & ~PMP_A, base, log2len);
+}
+
+static bool hart_pmp_image_entry_same(const struct hart_pmp_image *cur,
+				      const struct hart_pmp_image *next,
+				      unsigned int n)
+{
+	unsigned long cfg = hart_pmp_image_cfg(next, n);
+
+	if (cur->addr[n] != next->addr[n] ||
+	    hart_pmp_image_cfg(cur, n) != cfg ||
+	    (cur->reg[n] ? cur->reg[n]->flags : 0) !=
+	    (next->reg[n] ? next->reg[n]->flags : 0))
+		return false;
+
+	/* TOR also depends on the previous pmpaddr */
+	return (cfg & PMP_A) != PMP_A_TOR || !n ||
+	       cur->addr[n - 1] == next->addr[n - 1];
+}
+
+/*
+ * Write the entries of the next image which differ from the loaded
+ * one (all entries if the loaded image is not known) and return
+ * whether anything was written.
+ */
+static bool hart_pmp_image_write(struct sbi_scratch *scratch,
+				 const struct hart_pmp_image *cur,
+				 const struct hart_pmp_image *next)
+{
+	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
+	unsigned long live[PMP_COUNT / PMP_CFG_PER_CSR];
+	unsigned int c, n;
+	bool changed = false;
+
+	/*
+	 * Disable the changed entries before writing any pmpaddr so that
+	 * no intermediate rule (such as a TOR made of the new bottom and
+	 * the old top) denies M-mode accesses under Smepmp MML. Firmware
+	 * entries stay enabled.
+	 */
+	for (c = 0; c * PMP_CFG_PER_CSR < next->pmp_count; c++) {
+		if (!cur) {
+			live[c] = 0;
+			csr_write_num(PMP_CFG_CSR(c), 0);
+			changed = true;
+			continue;
+		}
+
+		live[c] = cur->cfg[c];
+		for (n = c * PMP_CFG_PER_CSR;
+		     n < (c + 1) * PMP_CFG_PER_CSR && n < next->pmp_count;
+		     n++) {
+			if (sbi_hart_smepmp_is_fw_region(n) ||
+			    hart_pmp_image_entry_same(cur, next, n))
+				continue;
+			live[c] &= ~(0xffUL << ((n % PMP_CFG_PER_CSR) * 8));
+		}
+
+		if (live[c] != cur->cfg[c]) {
+			csr_write_num(PMP_CFG_CSR(c), live[c]);
+			changed = true;
+		}
+	}
+
+	for (c = 0; c * PMP_CFG_PER_CSR < next->pmp_count; c++) {
+		for (n = c * PMP_CFG_PER_CSR;
+		     n < (c + 1) * PMP_CFG_PER_CSR && n < next->pmp_count;
+		     n++) {
+			if (cur && hart_pmp_image_entry_same(cur, next, n))
+				continue;
+
+			hart_pmp_image_platform_set(plat, next, n);
+			if (!cur || cur->addr[n] != next->addr[n])
+				csr_write_num(CSR_PMPADDR0 + n, next->addr[n]);
+			changed = true;
+		}
+
+		/* All entries of a pmpcfg CSR are written at once */
+		if (live[c] != next->cfg[c]) {
+			csr_write_num(PMP_CFG_CSR(c), next->cfg[c]);
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+/*
+ * Get the image of a domain for the current HART. If the precomputed
+ * image can't be used, a temporary one is built and returned in tmp
+ * which the caller must free.
+ */
+static struct hart_pmp_image *hart_pmp_image_acquire(struct sbi_scratch *scratch,
+						     struct sbi_domain *dom,
+						     bool smepmp,
+						     struct hart_pmp_image **tmp,
+						     int *rc)
+{
+	struct hart_pmp_image *img = hart_pmp_image_get(scratch, dom);
+
+	*tmp = NULL;
+	*rc = 0;
+	if (img)
+		return img;
+
+	img = sbi_zalloc(sizeof(*img));
+	if (!img) {
+		*rc = SBI_ENOMEM;
+		return NULL;
+	}
+
+	*rc = hart_pmp_image_build(scratch, dom, img, smepmp);
+	if (*rc) {
+		sbi_free(img);
+		return NULL;
+	}
+
+	*tmp = img;
+	return img;
+}
+
+static int sbi_hart_smepmp_configure(struct sbi_scratch *scratch,
+				     struct sbi_domain *dom)
+{
+	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
+	struct hart_pmp_image *img, *tmp;
+	const struct sbi_domain_memregion *reg;
+	unsigned long cfg;
+	unsigned int c, n;
+	int rc;
+
+	hart_pmp_loaded_set(scratch, NULL);
+	hart_smepmp_window_reset(scratch);
+
+	img = hart_pmp_image_acquire(scratch, dom, true, &tmp, &rc);
+	if (!img)
+		return rc;
+
+	if (fw_smepmp_ids_inited) {
+		/* Check inconsistent firmware region */
+		for (n = 0; n < img->pmp_count; n++) {
+			if (bitmap_test(img->fw, n) &&
+			    !sbi_hart_smepmp_is_fw_region(n)) {
+				sbi_free(tmp);
+				return SBI_EINVAL;
+			}
+		}
+	} else {
+		bitmap_copy(fw_smepmp_ids, img->fw, PMP_COUNT);
+		fw_smepmp_ids_inited = true;
+	}
+
+	/*
+	 * Set the RLB so that, we can write to PMP entries without
+	 * enforcement even if some entries are locked.
+	 */
+	csr_set(CSR_MSECCFG, MSECCFG_RLB);
+
+	/*
+	 * Program M-only regions when MML is not set. This also
+	 * disables the reserved entry.
+	 */
+	for (c = 0; c * PMP_CFG_PER_CSR < img->pmp_count; c++) {
+		cfg = 0;
+		for (n = c * PMP_CFG_PER_CSR;
+		     n < (c + 1) * PMP_CFG_PER_CSR && n < img->pmp_count;
+		     n++) {
+			csr_write_num(CSR_PMPADDR0 + n, img->addr[n]);
+
+			reg = img->reg[n];
+			if (!reg || !SBI_DOMAIN_MEMREGION_M_ONLY_ACCESS(reg->flags))
+				continue;
+
+			hart_pmp_image_platform_set(plat, img, n);
+			cfg |= hart_pmp_image_cfg(img, n) <<
+			       ((n % PMP_CFG_PER_CSR) * 8);
+		}
+		csr_write_num(PMP_CFG_CSR(c), cfg);
+	}
+
+	/* Set the MML to enforce new encoding */
+	csr_set(CSR_MSECCFG, MSECCFG_MML);
+
+	/* Program shared and SU-only regions, disable remaining entries */
+	for (n = 0; n < img->pmp_count; n++) {
+		reg = img->reg[n];
+		if (!reg || !SBI_DOMAIN_MEMREGION_M_ONLY_ACCESS(reg->flags))
+			hart_pmp_image_platform_set(plat, img, n);
+	}
+	for (c = 0; c * PMP_CFG_PER_CSR < img->pmp_count; c++)
+		csr_write_num(PMP_CFG_CSR(c), img->cfg[c]);
+
+	/*
+	 * All entries are programmed.
+	 * Keep the RLB bit so that dynamic mappings can be done.
+	 */
+
+	if (!tmp)
+		hart_pmp_loaded_set(scratch, img);
+	sbi_free(tmp);
 
 	sbi_hart_pmp_fence();
 	return 0;
 }
 
-static void sbi_hart_pmp_unconfigure(struct sbi_scratch *scratch,
+static int sbi_hart_oldpmp_configure(struct sbi_scratch *scratch,
 				     struct sbi_domain *dom)
 {
-	int i, pmp_count = sbi_hart_pmp_count(scratch);
+	struct hart_pmp_image *img, *tmp;
+	int rc;
 
-	for (i = 0; i < pmp_count; i++) {
-		/* Don't revoke firmware access permissions */
-		if (sbi_hart_smepmp_is_fw_region(i))
-			continue;
+	hart_pmp_loaded_set(scratch, NULL);
 
-		sbi_platform_pmp_disable(sbi_platform_ptr(scratch), i);
-		sbi_hart_pmp_disable(i);
+	img = hart_pmp_image_acquire(scratch, dom, false, &tmp, &rc);
+	if (!img)
+		return rc;
+
+	hart_pmp_image_write(scratch, NULL, img);
+
+	if (!tmp)
+		hart_pmp_loaded_set(scratch, img);
+	sbi_free(tmp);
+
+	sbi_hart_pmp_fence();
+	return 0;
+}
+
+static int sbi_hart_pmp_reconfigure(struct sbi_scratch *scratch,
+				    struct sbi_domain *current_dom,
+				    struct sbi_domain *next_dom)
+{
+	struct hart_pmp_image *next = hart_pmp_image_get(scratch, next_dom);
+	bool smepmp = sbi_hart_has_extension(scratch, SBI_HART_EXT_SMEPMP);
+	bool changed;
+	int rc;
+
+	/* Firmware entries must match the ones configured at boot */
+	if (next && smepmp &&
+	    (!fw_smepmp_ids_inited ||
+	     sbi_memcmp(next->fw, fw_smepmp_ids, sizeof(fw_smepmp_ids))))
+		next = NULL;
+
+	if (!next) {
+		sbi_hart_pmp_unconfigure(scratch, current_dom);
+		rc = smepmp ? sbi_hart_smepmp_configure(scratch, next_dom) :
+			      sbi_hart_oldpmp_configure(scratch, next_dom);
+		return rc ? rc : 1;
 	}
+
+	/*
+	 * Keep entries writable even if some of them are locked and
+	 * drop the window of the current domain since the images don't
+	 * track the reserved entry.
+	 */
+	if (smepmp) {
+		csr_set(CSR_MSECCFG, MSECCFG_RLB);
+		hart_smepmp_window_disable(scratch);
+	}
+
+	changed = hart_pmp_image_write(scratch, hart_pmp_loaded_get(scratch),
+				       next);
+	hart_pmp_loaded_set(scratch, next);
+	if (!changed)
+		return 0;
+
+	sbi_hart_pmp_fence();
+	return 1;
 }
 
 static struct sbi_hart_protection pmp_protection = {
@@ -428,6 +1063,8 @@ static struct sbi_hart_protection pmp_protection = {
 	.type = SBI_HART_PROTECTION_TYPE_MEMORY,
 	.configure = sbi_hart_oldpmp_configure,
 	.unconfigure = sbi_hart_pmp_unconfigure,
+	.prepare = sbi_hart_pmp_prepare,
+	.reconfigure = sbi_hart_pmp_reconfigure,
 };
 
 static struct sbi_hart_protection epmp_protection = {
@@ -436,8 +1073,13 @@ static struct sbi_hart_protection epmp_protection = {
 	.type = SBI_HART_PROTECTION_TYPE_MEMORY,
 	.configure = sbi_hart_smepmp_configure,
 	.unconfigure = sbi_hart_pmp_unconfigure,
+	.prepare = sbi_hart_pmp_prepare,
+	.reconfigure = sbi_hart_pmp_reconfigure,
 	.map_range = sbi_hart_smepmp_map_range,
 	.unmap_range = sbi_hart_smepmp_unmap_range,
+	.keep_range = sbi_hart_smepmp_keep_range,
+	.forget_range = sbi_hart_smepmp_forget_range,
+	.release_ranges = sbi_hart_smepmp_release_ranges,
 };
 
 int sbi_hart_pmp_init(struct sbi_scratch *scratch)
@@ -445,7 +1087,21 @@ int sbi_hart_pmp_init(struct sbi_scratch *scratch)
 	int rc;
 
 	if (sbi_hart_pmp_count(scratch)) {
+		hart_pmp_loaded_offset =
+			sbi_scratch_alloc_type_offset(struct hart_pmp_image *);
+		if (!hart_pmp_loaded_offset)
+			return SBI_ENOMEM;
+
+		rc = sbi_domain_register_data(&hart_pmp_image_data);
+		if (rc)
+			return rc;
+
 		if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SMEPMP)) {
+			hart_smepmp_window_offset =
+				sbi_scratch_alloc_type_offset(struct hart_smepmp_window);
+			if (!hart_smepmp_window_offset)
+				return SBI_ENOMEM;
+
 			rc = sbi_hart_protection_register(&epmp_protection);
 			if (rc)
 				return rc;
@@ -163,11 +163,37 @@ void sbi_hart_protection_unconfigure(struct sbi_scratch *scratch,
 	}
 }
 
+void sbi_hart_protection_prepare(struct sbi_scratch *scratch,
+				 struct sbi_domain *dom)
+{
+	bool do_prepare, memory_protect_done = false;
+	struct sbi_hart_protection *hprot;
+
+	sbi_list_for_each_entry(hprot, &hart_protection_list, head) {
+		do_prepare = false;
+		switch (hprot->type) {
+		case SBI_HART_PROTECTION_TYPE_MEMORY:
+			do_prepare = !memory_protect_done;
+			memory_protect_done = true;
+			break;
+		case SBI_HART_PROTECTION_TYPE_ID:
+			do_prepare = true;
+			break;
+		default:
+			break;
+		}
+		if (!do_prepare || !hprot->prepare)
+			continue;
+
+		hprot->prepare(scratch, dom);
+	}
+}
+
 int sbi_hart_protection_reconfigure(struct sbi_scratch *scratch,
 				    struct sbi_domain *current_dom,
 				    struct sbi_domain *next_dom)
 {
-	bool do_reconfigure, memory_protect_done = false;
+	bool do_reconfigure, memory_protect_done = false, flushed = false;
 	struct sbi_hart_protection *hprot;
 	int ret;
 
@@ -187,13 +213,26 @@ int sbi_hart_protection_reconfigure(struct sbi_scratch *scratch,
 		if (!do_reconfigure)
 			continue;
 
+		if (hprot->reconfigure) {
+			ret = hprot->reconfigure(scratch, current_dom, next_dom);
+			if (ret < 0)
+				return ret;
+			if (ret)
+				flushed = true;
+			continue;
+		}
+
 		__hart_protection_unconfigure(scratch, hprot, current_dom);
 		ret = __hart_protection_configure(scratch, hprot, next_dom);
 		if (ret)
 			return ret;
+
+		/* Memory protection configure always flushes */
+		if (hprot->type == SBI_HART_PROTECTION_TYPE_MEMORY)
+			flushed = true;
 	}
 
-	return 0;
+	return flushed ? 1 : 0;
 }
 
 int sbi_hart_protection_map_range(unsigned long base, unsigned long size)
@@ -215,3 +254,29 @@ int sbi_hart_protection_unmap_range(unsigned long base, unsigned long size)
 
 	return hprot->unmap_range(sbi_scratch_thishart_ptr(), base, size);
 }
+
+int sbi_hart_protection_keep_range(unsigned long base, unsigned long size)
+{
+	struct sbi_hart_protection *hprot = __hart_memory_protection_best();
+
+	if (!hprot || !hprot->keep_range)
+		return 0;
+
+	return hprot->keep_range(sbi_scratch_thishart_ptr(), base, size);
+}
+
+void sbi_hart_protection_forget_range(unsigned long base, unsigned long size)
+{
+	struct sbi_hart_protection *hprot = __hart_memory_protection_best();
+
+	if (hprot && hprot->forget_range)
+		hprot->forget_range(sbi_scratch_thishart_ptr(), base, size);
+}
+
+void sbi_hart_protection_release_ranges(void)
+{
+	struct sbi_hart_protection *hprot = __hart_memory_protection_best();
+
+	if (hprot && hprot->release_ranges)
+		hprot->release_ranges(sbi_scratch_thishart_ptr());
+}
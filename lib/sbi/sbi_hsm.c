@@ -24,6 +24,7 @@
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_system.h>
 #include <sbi/sbi_timer.h>
+#include <sbi/sbi_trace.h>
 #include <sbi/sbi_console.h>
 
 #define __sbi_hsm_hart_change_state(hdata, oldstate, newstate)		\
@@ -32,6 +33,8 @@
 	if (state != (oldstate))					\
 		sbi_printf("%s: ERR: The hart is in invalid state [%lu]\n", \
 			   __func__, state);				\
+	else								\
+		sbi_trace(HSM_STATE, oldstate, newstate);		\
 	state == (oldstate);						\
 })
 
@@ -359,6 +362,8 @@ int sbi_hsm_hart_start(struct sbi_scratch *scratch,
 		rc = SBI_EINVAL;
 		goto err;
 	}
+	sbi_trace(HSM_STATE, SBI_HSM_STATE_STOPPED,
+		  SBI_HSM_STATE_START_PENDING);
 
 	if ((hsm_device_has_hart_hotplug() && (entry_count == init_count)) ||
 	   (hsm_device_has_hart_secondary_boot() && !init_count)) {
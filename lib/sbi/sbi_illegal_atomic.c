@@ -6,7 +6,10 @@
  */
 
 #include <sbi/riscv_asm.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/sbi_ecall_interface.h>
 #include <sbi/sbi_hart.h>
+#include <sbi/sbi_pmu.h>
 #include <sbi/sbi_trap.h>
 #include <sbi/sbi_illegal_atomic.h>
 #include <sbi/sbi_illegal_insn.h>
@@ -24,6 +27,25 @@ int sbi_illegal_atomic(ulong insn, struct sbi_trap_regs *regs)
 
 #elif defined(__riscv_zalrsc)
 
+#define AMO_BACKOFF_MAX		1024
+
+/*
+ * Back off exponentially after a failed SC so that HARTs hammering the
+ * same location stop stealing each other's reservation. The low bits
+ * of mcycle add some jitter so that contending HARTs don't retry in
+ * lockstep.
+ */
+static void atomic_backoff(ulong *delay)
+{
+	ulong i, spins = *delay + (csr_read(CSR_MCYCLE) & (*delay - 1));
+
+	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_AMO_SC_RETRY);
+	for (i = 0; i < spins; i++)
+		cpu_relax();
+	if (*delay < AMO_BACKOFF_MAX)
+		*delay <<= 1;
+}
+
 #define DEFINE_UNPRIVILEGED_LR_FUNCTION(type, aqrl, insn)			\
 	static type lr_##type##aqrl(const type *addr,				\
 				struct sbi_trap_info *trap)			\
@@ -105,6 +127,7 @@ DEFINE_UNPRIVILEGED_SC_FUNCTION(s64, _aqrl, sc.d.aqrl);
 		ulong val = GET_RS2(insn, regs);				\
 		ulong rd_val = 0;						\
 		ulong fail = 1;							\
+		ulong delay = 1;						\
 		while (fail) {							\
 			rd_val = lr_##type((void *)addr, &uptrap);		\
 			if (uptrap.cause) {					\
@@ -114,32 +137,91 @@ DEFINE_UNPRIVILEGED_SC_FUNCTION(s64, _aqrl, sc.d.aqrl);
 			if (uptrap.cause) {					\
 				return sbi_trap_redirect(regs, &uptrap);	\
 			}							\
+			if (fail)						\
+				atomic_backoff(&delay);				\
+		}								\
+		SET_RD(insn, regs, rd_val);					\
+		regs->mepc += 4;						\
+		return 0;							\
+	}
+
+/*
+ * AMOs which map to a single ALU instruction are emulated with one LR/SC
+ * sequence inside a single MPRV window. Keeping CSR accesses, function
+ * calls and M-mode memory accesses out of the sequence between LR and SC
+ * makes it a constrained LR/SC sequence and also halves the number of
+ * mtvec/mstatus swaps compared to separate lr_*() and sc_*() calls.
+ */
+#define DEFINE_LRSC_ATOMIC_FUNCTION(name, lr, sc, op)				\
+	static int atomic_##name(ulong insn, struct sbi_trap_regs *regs)	\
+	{									\
+		struct sbi_trap_info uptrap;					\
+		ulong addr = GET_RS1(insn, regs);				\
+		ulong val = GET_RS2(insn, regs);				\
+		ulong mstatus, mtvec, tmp, rd_val = 0, fail, delay = 1;	\
+		while (1) {							\
+			register ulong tinfo asm("a3") = (ulong)&uptrap;	\
+			register ulong ttmp asm("a4") = 0;			\
+			mtvec = (ulong)sbi_hart_expected_trap;			\
+			fail = 1;						\
+			uptrap.cause = 0;					\
+			asm volatile(						\
+				"csrrw %[mtvec], " STR(CSR_MTVEC) ", %[mtvec]\n"\
+				"csrrs %[mstatus], " STR(CSR_MSTATUS) ", %[mprv]\n"\
+				".option push\n"				\
+				".option norvc\n"				\
+				#lr " %[rd], (%[addr])\n"			\
+				"bnez %[ttmp], 1f\n"				\
+				op "\n"					\
+				#sc " %[fail], %[tmp], (%[addr])\n"		\
+				"1:\n"						\
+				".option pop\n"				\
+				"csrw " STR(CSR_MSTATUS) ", %[mstatus]\n"	\
+				"csrw " STR(CSR_MTVEC) ", %[mtvec]"		\
+			    : [mstatus] "=&r"(mstatus), [mtvec] "+&r"(mtvec),	\
+			      [tinfo] "+&r"(tinfo), [ttmp] "+&r"(ttmp),		\
+			      [rd] "+&r"(rd_val), [tmp] "=&r"(tmp),		\
+			      [fail] "+&r"(fail)				\
+			    : [addr] "r"(addr), [val] "r"(val),			\
+			      [mprv] "r"(MSTATUS_MPRV)				\
+			    : "memory");					\
+			if (uptrap.cause)					\
+				return sbi_trap_redirect(regs, &uptrap);	\
+			if (!fail)						\
+				break;						\
+			atomic_backoff(&delay);					\
 		}								\
 		SET_RD(insn, regs, rd_val);					\
 		regs->mepc += 4;						\
 		return 0;							\
 	}
 
-DEFINE_ATOMIC_FUNCTION(add_w, s32, rd_val + val);
-DEFINE_ATOMIC_FUNCTION(add_w_aq, s32_aq, rd_val + val);
-DEFINE_ATOMIC_FUNCTION(add_w_rl, s32_rl, rd_val + val);
-DEFINE_ATOMIC_FUNCTION(add_w_aqrl, s32_aqrl, rd_val + val);
-DEFINE_ATOMIC_FUNCTION(and_w, s32, rd_val & val);
-DEFINE_ATOMIC_FUNCTION(and_w_aq, s32_aq, rd_val & val);
-DEFINE_ATOMIC_FUNCTION(and_w_rl, s32_rl, rd_val & val);
-DEFINE_ATOMIC_FUNCTION(and_w_aqrl, s32_aqrl, rd_val & val);
-DEFINE_ATOMIC_FUNCTION(or_w, s32, rd_val | val);
-DEFINE_ATOMIC_FUNCTION(or_w_aq, s32_aq, rd_val | val);
-DEFINE_ATOMIC_FUNCTION(or_w_rl, s32_rl, rd_val | val);
-DEFINE_ATOMIC_FUNCTION(or_w_aqrl, s32_aqrl, rd_val | val);
-DEFINE_ATOMIC_FUNCTION(xor_w, s32, rd_val ^ val);
-DEFINE_ATOMIC_FUNCTION(xor_w_aq, s32_aq, rd_val ^ val);
-DEFINE_ATOMIC_FUNCTION(xor_w_rl, s32_rl, rd_val ^ val);
-DEFINE_ATOMIC_FUNCTION(xor_w_aqrl, s32_aqrl, rd_val ^ val);
-DEFINE_ATOMIC_FUNCTION(swap_w, s32, val);
-DEFINE_ATOMIC_FUNCTION(swap_w_aq, s32_aq, val);
-DEFINE_ATOMIC_FUNCTION(swap_w_rl, s32_rl, val);
-DEFINE_ATOMIC_FUNCTION(swap_w_aqrl, s32_aqrl, val);
+#define LRSC_OP_ADD	"add %[tmp], %[rd], %[val]"
+#define LRSC_OP_SWAP	"mv %[tmp], %[val]"
+#define LRSC_OP_XOR	"xor %[tmp], %[rd], %[val]"
+#define LRSC_OP_AND	"and %[tmp], %[rd], %[val]"
+#define LRSC_OP_OR	"or %[tmp], %[rd], %[val]"
+
+DEFINE_LRSC_ATOMIC_FUNCTION(add_w, lr.w, sc.w, LRSC_OP_ADD);
+DEFINE_LRSC_ATOMIC_FUNCTION(add_w_aq, lr.w.aq, sc.w.aq, LRSC_OP_ADD);
+DEFINE_LRSC_ATOMIC_FUNCTION(add_w_rl, lr.w.rl, sc.w.rl, LRSC_OP_ADD);
+DEFINE_LRSC_ATOMIC_FUNCTION(add_w_aqrl, lr.w.aqrl, sc.w.aqrl, LRSC_OP_ADD);
+DEFINE_LRSC_ATOMIC_FUNCTION(and_w, lr.w, sc.w, LRSC_OP_AND);
+DEFINE_LRSC_ATOMIC_FUNCTION(and_w_aq, lr.w.aq, sc.w.aq, LRSC_OP_AND);
+DEFINE_LRSC_ATOMIC_FUNCTION(and_w_rl, lr.w.rl, sc.w.rl, LRSC_OP_AND);
+DEFINE_LRSC_ATOMIC_FUNCTION(and_w_aqrl, lr.w.aqrl, sc.w.aqrl, LRSC_OP_AND);
+DEFINE_LRSC_ATOMIC_FUNCTION(or_w, lr.w, sc.w, LRSC_OP_OR);
+DEFINE_LRSC_ATOMIC_FUNCTION(or_w_aq, lr.w.aq, sc.w.aq, LRSC_OP_OR);
+DEFINE_LRSC_ATOMIC_FUNCTION(or_w_rl, lr.w.rl, sc.w.rl, LRSC_OP_OR);
+DEFINE_LRSC_ATOMIC_FUNCTION(or_w_aqrl, lr.w.aqrl, sc.w.aqrl, LRSC_OP_OR);
+DEFINE_LRSC_ATOMIC_FUNCTION(xor_w, lr.w, sc.w, LRSC_OP_XOR);
+DEFINE_LRSC_ATOMIC_FUNCTION(xor_w_aq, lr.w.aq, sc.w.aq, LRSC_OP_XOR);
+DEFINE_LRSC_ATOMIC_FUNCTION(xor_w_rl, lr.w.rl, sc.w.rl, LRSC_OP_XOR);
+DEFINE_LRSC_ATOMIC_FUNCTION(xor_w_aqrl, lr.w.aqrl, sc.w.aqrl, LRSC_OP_XOR);
+DEFINE_LRSC_ATOMIC_FUNCTION(swap_w, lr.w, sc.w, LRSC_OP_SWAP);
+DEFINE_LRSC_ATOMIC_FUNCTION(swap_w_aq, lr.w.aq, sc.w.aq, LRSC_OP_SWAP);
+DEFINE_LRSC_ATOMIC_FUNCTION(swap_w_rl, lr.w.rl, sc.w.rl, LRSC_OP_SWAP);
+DEFINE_LRSC_ATOMIC_FUNCTION(swap_w_aqrl, lr.w.aqrl, sc.w.aqrl, LRSC_OP_SWAP);
 DEFINE_ATOMIC_FUNCTION(max_w, s32, (s32)rd_val > (s32)val ? rd_val : val);
 DEFINE_ATOMIC_FUNCTION(max_w_aq, s32_aq, (s32)rd_val > (s32)val ? rd_val : val);
 DEFINE_ATOMIC_FUNCTION(max_w_rl, s32_rl, (s32)rd_val > (s32)val ? rd_val : val);
@@ -158,26 +240,26 @@ DEFINE_ATOMIC_FUNCTION(minu_w_rl, s32_rl, (u32)rd_val < (u32)val ? rd_val : val)
 DEFINE_ATOMIC_FUNCTION(minu_w_aqrl, s32_aqrl, (u32)rd_val < (u32)val ? rd_val : val);
 
 #if __riscv_xlen == 64
-DEFINE_ATOMIC_FUNCTION(add_d, s64, rd_val + val);
-DEFINE_ATOMIC_FUNCTION(add_d_aq, s64_aq, rd_val + val);
-DEFINE_ATOMIC_FUNCTION(add_d_rl, s64_rl, rd_val + val);
-DEFINE_ATOMIC_FUNCTION(add_d_aqrl, s64_aqrl, rd_val + val);
-DEFINE_ATOMIC_FUNCTION(and_d, s64, rd_val & val);
-DEFINE_ATOMIC_FUNCTION(and_d_aq, s64_aq, rd_val & val);
-DEFINE_ATOMIC_FUNCTION(and_d_rl, s64_rl, rd_val & val);
-DEFINE_ATOMIC_FUNCTION(and_d_aqrl, s64_aqrl, rd_val & val);
-DEFINE_ATOMIC_FUNCTION(or_d, s64, rd_val | val);
-DEFINE_ATOMIC_FUNCTION(or_d_aq, s64_aq, rd_val | val);
-DEFINE_ATOMIC_FUNCTION(or_d_rl, s64_rl, rd_val | val);
-DEFINE_ATOMIC_FUNCTION(or_d_aqrl, s64_aqrl, rd_val | val);
-DEFINE_ATOMIC_FUNCTION(xor_d, s64, rd_val ^ val);
-DEFINE_ATOMIC_FUNCTION(xor_d_aq, s64_aq, rd_val ^ val);
-DEFINE_ATOMIC_FUNCTION(xor_d_rl, s64_rl, rd_val ^ val);
-DEFINE_ATOMIC_FUNCTION(xor_d_aqrl, s64_aqrl, rd_val ^ val);
-DEFINE_ATOMIC_FUNCTION(swap_d, s64, val);
-DEFINE_ATOMIC_FUNCTION(swap_d_aq, s64_aq, val);
-DEFINE_ATOMIC_FUNCTION(swap_d_rl, s64_rl, val);
-DEFINE_ATOMIC_FUNCTION(swap_d_aqrl, s64_aqrl, val);
+DEFINE_LRSC_ATOMIC_FUNCTION(add_d, lr.d, sc.d, LRSC_OP_ADD);
+DEFINE_LRSC_ATOMIC_FUNCTION(add_d_aq, lr.d.aq, sc.d.aq, LRSC_OP_ADD);
+DEFINE_LRSC_ATOMIC_FUNCTION(add_d_rl, lr.d.rl, sc.d.rl, LRSC_OP_ADD);
+DEFINE_LRSC_ATOMIC_FUNCTION(add_d_aqrl, lr.d.aqrl, sc.d.aqrl, LRSC_OP_ADD);
+DEFINE_LRSC_ATOMIC_FUNCTION(and_d, lr.d, sc.d, LRSC_OP_AND);
+DEFINE_LRSC_ATOMIC_FUNCTION(and_d_aq, lr.d.aq, sc.d.aq, LRSC_OP_AND);
+DEFINE_LRSC_ATOMIC_FUNCTION(and_d_rl, lr.d.rl, sc.d.rl, LRSC_OP_AND);
+DEFINE_LRSC_ATOMIC_FUNCTION(and_d_aqrl, lr.d.aqrl, sc.d.aqrl, LRSC_OP_AND);
+DEFINE_LRSC_ATOMIC_FUNCTION(or_d, lr.d, sc.d, LRSC_OP_OR);
+DEFINE_LRSC_ATOMIC_FUNCTION(or_d_aq, lr.d.aq, sc.d.aq, LRSC_OP_OR);
+DEFINE_LRSC_ATOMIC_FUNCTION(or_d_rl, lr.d.rl, sc.d.rl, LRSC_OP_OR);
+DEFINE_LRSC_ATOMIC_FUNCTION(or_d_aqrl, lr.d.aqrl, sc.d.aqrl, LRSC_OP_OR);
+DEFINE_LRSC_ATOMIC_FUNCTION(xor_d, lr.d, sc.d, LRSC_OP_XOR);
+DEFINE_LRSC_ATOMIC_FUNCTION(xor_d_aq, lr.d.aq, sc.d.aq, LRSC_OP_XOR);
+DEFINE_LRSC_ATOMIC_FUNCTION(xor_d_rl, lr.d.rl, sc.d.rl, LRSC_OP_XOR);
+DEFINE_LRSC_ATOMIC_FUNCTION(xor_d_aqrl, lr.d.aqrl, sc.d.aqrl, LRSC_OP_XOR);
+DEFINE_LRSC_ATOMIC_FUNCTION(swap_d, lr.d, sc.d, LRSC_OP_SWAP);
+DEFINE_LRSC_ATOMIC_FUNCTION(swap_d_aq, lr.d.aq, sc.d.aq, LRSC_OP_SWAP);
+DEFINE_LRSC_ATOMIC_FUNCTION(swap_d_rl, lr.d.rl, sc.d.rl, LRSC_OP_SWAP);
+DEFINE_LRSC_ATOMIC_FUNCTION(swap_d_aqrl, lr.d.aqrl, sc.d.aqrl, LRSC_OP_SWAP);
 DEFINE_ATOMIC_FUNCTION(max_d, s64, (s64)rd_val > (s64)val ? rd_val : val);
 DEFINE_ATOMIC_FUNCTION(max_d_aq, s64_aq, (s64)rd_val > (s64)val ? rd_val : val);
 DEFINE_ATOMIC_FUNCTION(max_d_rl, s64_rl, (s64)rd_val > (s64)val ? rd_val : val);
@@ -576,46 +658,55 @@ static const illegal_insn_func amomaxu_table[32] = {
 
 static int amoadd_insn(ulong insn, struct sbi_trap_regs *regs)
 {
+	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_AMOADD_EMULATED);
 	return amoadd_table[(GET_FUNC3(insn) << 2) + GET_AQRL(insn)](insn, regs);
 }
 
 static int amoswap_insn(ulong insn, struct sbi_trap_regs *regs)
 {
+	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_AMOSWAP_EMULATED);
 	return amoswap_table[(GET_FUNC3(insn) << 2) + GET_AQRL(insn)](insn, regs);
 }
 
 static int amoxor_insn(ulong insn, struct sbi_trap_regs *regs)
 {
+	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_AMOXOR_EMULATED);
 	return amoxor_table[(GET_FUNC3(insn) << 2) + GET_AQRL(insn)](insn, regs);
 }
 
 static int amoor_insn(ulong insn, struct sbi_trap_regs *regs)
 {
+	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_AMOOR_EMULATED);
 	return amoor_table[(GET_FUNC3(insn) << 2) + GET_AQRL(insn)](insn, regs);
 }
 
 static int amoand_insn(ulong insn, struct sbi_trap_regs *regs)
 {
+	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_AMOAND_EMULATED);
 	return amoand_table[(GET_FUNC3(insn) << 2) + GET_AQRL(insn)](insn, regs);
 }
 
 static int amomin_insn(ulong insn, struct sbi_trap_regs *regs)
 {
+	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_AMOMIN_EMULATED);
 	return amomin_table[(GET_FUNC3(insn) << 2) + GET_AQRL(insn)](insn, regs);
 }
 
 static int amomax_insn(ulong insn, struct sbi_trap_regs *regs)
 {
+	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_AMOMAX_EMULATED);
 	return amomax_table[(GET_FUNC3(insn) << 2) + GET_AQRL(insn)](insn, regs);
 }
 
 static int amominu_insn(ulong insn, struct sbi_trap_regs *regs)
 {
+	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_AMOMINU_EMULATED);
 	return amominu_table[(GET_FUNC3(insn) << 2) + GET_AQRL(insn)](insn, regs);
 }
 
 static int amomaxu_insn(ulong insn, struct sbi_trap_regs *regs)
 {
+	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_AMOMAXU_EMULATED);
 	return amomaxu_table[(GET_FUNC3(insn) << 2) + GET_AQRL(insn)](insn, regs);
 }
 
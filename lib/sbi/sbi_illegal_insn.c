@@ -12,6 +12,7 @@
 #include <sbi/riscv_encoding.h>
 #include <sbi/sbi_bitops.h>
 #include <sbi/sbi_emulate_csr.h>
+#include <sbi/sbi_emuprof.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_illegal_atomic.h>
 #include <sbi/sbi_illegal_insn.h>
@@ -150,6 +151,7 @@ int sbi_illegal_insn_handler(struct sbi_trap_context *tcntx)
 	struct sbi_trap_regs *regs = &tcntx->regs;
 	ulong insn = tcntx->trap.tval;
 	struct sbi_trap_info uptrap;
+	illegal_insn_func fn;
 
 	/*
 	 * We only deal with 32-bit (or longer) illegal instructions. If we
@@ -171,5 +173,9 @@ int sbi_illegal_insn_handler(struct sbi_trap_context *tcntx)
 			return truly_illegal_insn(insn, regs);
 	}
 
-	return illegal_insn_table[(insn & 0x7c) >> 2](insn, regs);
+	fn = illegal_insn_table[(insn & 0x7c) >> 2];
+	if (fn != truly_illegal_insn)
+		sbi_emuprof_record(CAUSE_ILLEGAL_INSTRUCTION, regs->mepc, insn);
+
+	return fn(insn, regs);
 }
@@ -13,9 +13,13 @@
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_cppc.h>
 #include <sbi/sbi_domain.h>
+#include <sbi/sbi_domain_channel.h>
+#include <sbi/sbi_domain_context.h>
 #include <sbi/sbi_double_trap.h>
 #include <sbi/sbi_ecall.h>
+#include <sbi/sbi_emuprof.h>
 #include <sbi/sbi_fwft.h>
+#include <sbi/sbi_fwlog.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_hart_pmp.h>
@@ -26,6 +30,7 @@
 #include <sbi/sbi_irqchip.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_pmu.h>
+#include <sbi/sbi_residency.h>
 #include <sbi/sbi_dbtr.h>
 #include <sbi/sbi_mpxy.h>
 #include <sbi/sbi_sse.h>
@@ -33,6 +38,8 @@
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_timer.h>
 #include <sbi/sbi_tlb.h>
+#include <sbi/sbi_trace.h>
+#include <sbi/sbi_trapstat.h>
 #include <sbi/sbi_version.h>
 #include <sbi/sbi_unit_test.h>
 
@@ -46,6 +53,33 @@
 	"        | |\n"                                     \
 	"        |_|\n\n"
 
+/* Phases of the coldboot sequence which are timestamped */
+enum coldboot_phase {
+	COLDBOOT_PHASE_CORE = 0,
+	COLDBOOT_PHASE_HART,
+	COLDBOOT_PHASE_DEVICES,
+	COLDBOOT_PHASE_DOMAINS,
+	COLDBOOT_PHASE_ECALL,
+	COLDBOOT_PHASE_MAX,
+};
+
+static const char *const coldboot_phase_names[COLDBOOT_PHASE_MAX] = {
+	[COLDBOOT_PHASE_CORE]		= "core",
+	[COLDBOOT_PHASE_HART]		= "hart",
+	[COLDBOOT_PHASE_DEVICES]	= "devices",
+	[COLDBOOT_PHASE_DOMAINS]	= "domains",
+	[COLDBOOT_PHASE_ECALL]		= "ecall",
+};
+
+/* mcycle value at coldboot entry and at the end of each phase */
+static unsigned long coldboot_start;
+static unsigned long coldboot_stamps[COLDBOOT_PHASE_MAX];
+
+static void coldboot_phase_done(enum coldboot_phase phase)
+{
+	coldboot_stamps[phase] = csr_read(CSR_MCYCLE);
+}
+
 static void sbi_boot_print_banner(struct sbi_scratch *scratch)
 {
 	if (scratch->options & SBI_SCRATCH_NO_BOOT_PRINTS)
@@ -201,6 +235,23 @@ static void sbi_boot_print_hart(struct sbi_scratch *scratch, u32 hartid)
 	sbi_hart_delegation_dump(scratch, "Boot HART ", "           ");
 }
 
+static void sbi_boot_print_phases(struct sbi_scratch *scratch)
+{
+	unsigned long prev = coldboot_start;
+	int i;
+
+	if (scratch->options & SBI_SCRATCH_NO_BOOT_PRINTS)
+		return;
+
+	sbi_printf("Boot HART Init Cycles       :");
+	for (i = 0; i < COLDBOOT_PHASE_MAX; i++) {
+		sbi_printf(" %s=%lu", coldboot_phase_names[i],
+			   coldboot_stamps[i] - prev);
+		prev = coldboot_stamps[i];
+	}
+	sbi_printf("\n");
+}
+
 static unsigned long coldboot_done;
 
 static void wait_for_coldboot(struct sbi_scratch *scratch)
@@ -227,6 +278,8 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 	unsigned long *count;
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
 
+	coldboot_start = csr_read(CSR_MCYCLE);
+
 	/* Note: This has to be first thing in coldboot init sequence */
 	rc = sbi_scratch_init(scratch);
 	if (rc)
@@ -242,6 +295,22 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 	if (rc)
 		sbi_hart_hang();
 
+	rc = sbi_fwlog_init(scratch);
+	if (rc)
+		sbi_hart_hang();
+
+	rc = sbi_trace_init(scratch);
+	if (rc)
+		sbi_hart_hang();
+
+	rc = sbi_emuprof_init(scratch);
+	if (rc)
+		sbi_hart_hang();
+
+	rc = sbi_trapstat_init(scratch);
+	if (rc)
+		sbi_hart_hang();
+
 	entry_count_offset = sbi_scratch_alloc_offset(__SIZEOF_POINTER__);
 	if (!entry_count_offset)
 		sbi_hart_hang();
@@ -257,18 +326,25 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 	if (rc)
 		sbi_hart_hang();
 
-	/*
-	 * All non-coldboot HARTs do HSM initialization (i.e. enter HSM state
-	 * machine) at the start of the warmboot path so it is wasteful to
-	 * have these HARTs busy spin in wait_for_coldboot() until coldboot
-	 * path is completed.
-	 */
-	wake_coldboot_harts(scratch);
+	coldboot_phase_done(COLDBOOT_PHASE_CORE);
 
 	rc = sbi_hart_init(scratch, true);
 	if (rc)
 		sbi_hart_hang();
 
+	/*
+	 * All non-coldboot HARTs detect their features and then enter the
+	 * HSM state machine at the start of the warmboot path so it is
+	 * wasteful to have these HARTs busy spin in wait_for_coldboot()
+	 * until coldboot path is completed. Wake them up once the features
+	 * offset and the expected trap handler are set up so that feature
+	 * detection runs on all HARTs in parallel with the rest of the
+	 * coldboot path.
+	 */
+	wake_coldboot_harts(scratch);
+
+	coldboot_phase_done(COLDBOOT_PHASE_HART);
+
 	/*
 	 * Initialize stack guard via Zkr entropy source if Zkr is
 	 * implemented according to device tree. Writing new seed value
@@ -315,6 +391,10 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 	if (rc)
 		sbi_hart_hang();
 
+	rc = sbi_residency_init(scratch);
+	if (rc)
+		sbi_hart_hang();
+
 	rc = sbi_platform_early_init(plat, true);
 	if (rc)
 		sbi_hart_hang();
@@ -341,6 +421,13 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 		sbi_hart_hang();
 	}
 
+	rc = sbi_console_tx_init(scratch);
+	if (rc) {
+		sbi_printf("%s: console tx init failed (error %d)\n",
+			   __func__, rc);
+		sbi_hart_hang();
+	}
+
 	rc = sbi_ipi_init(scratch, true);
 	if (rc) {
 		sbi_printf("%s: ipi init failed (error %d)\n", __func__, rc);
@@ -365,6 +452,8 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 		sbi_hart_hang();
 	}
 
+	coldboot_phase_done(COLDBOOT_PHASE_DEVICES);
+
 	/*
 	 * Note: Finalize domains after HSM initialization
 	 * Note: Finalize domains before HART PMP configuration so
@@ -377,6 +466,14 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 		sbi_hart_hang();
 	}
 
+	/* Note: Channel checks need the final memory regions of domains */
+	rc = sbi_domain_channel_init(scratch);
+	if (rc) {
+		sbi_printf("%s: domain channel init failed (error %d)\n",
+			   __func__, rc);
+		sbi_hart_hang();
+	}
+
 	/*
 	 * Note: Platform final initialization should be after finalizing
 	 * domains so that it sees correct domain assignment and PMP
@@ -389,6 +486,8 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 		sbi_hart_hang();
 	}
 
+	coldboot_phase_done(COLDBOOT_PHASE_DOMAINS);
+
 	/*
 	 * Note: SSE events callbacks can be registered by other drivers so
 	 * sbi_sse_init() needs to be called after all drivers have been probed.
@@ -410,12 +509,16 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 		sbi_hart_hang();
 	}
 
+	coldboot_phase_done(COLDBOOT_PHASE_ECALL);
+
 	sbi_boot_print_general(scratch);
 
 	sbi_boot_print_domains(scratch);
 
 	sbi_boot_print_hart(scratch, hartid);
 
+	sbi_boot_print_phases(scratch);
+
 	run_all_tests();
 
 	/*
@@ -440,6 +543,13 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 		sbi_hart_hang();
 	}
 
+	rc = sbi_domain_sched_start(scratch);
+	if (rc) {
+		sbi_printf("%s: domain sched start failed (error %d)\n",
+			   __func__, rc);
+		sbi_hart_hang();
+	}
+
 	count = sbi_scratch_offset_ptr(scratch, init_count_offset);
 	(*count)++;
 
@@ -459,7 +569,16 @@ static void __noreturn init_warm_startup(struct sbi_scratch *scratch,
 	count = sbi_scratch_offset_ptr(scratch, entry_count_offset);
 	(*count)++;
 
-	/* Note: This has to be first thing in warmboot init sequence */
+	/*
+	 * Note: Feature detection only touches this HART so do it before
+	 * waiting in HSM. The coldboot HART is still busy with the rest of
+	 * the coldboot path at this point.
+	 */
+	rc = sbi_hart_early_init(scratch);
+	if (rc)
+		sbi_hart_hang();
+
+	/* Note: This waits until the HART is started */
 	rc = sbi_hsm_init(scratch, false);
 	if (rc)
 		sbi_hart_hang();
@@ -520,6 +639,10 @@ static void __noreturn init_warm_startup(struct sbi_scratch *scratch,
 	if (rc)
 		sbi_hart_hang();
 
+	rc = sbi_domain_sched_start(scratch);
+	if (rc)
+		sbi_hart_hang();
+
 	count = sbi_scratch_offset_ptr(scratch, init_count_offset);
 	(*count)++;
 
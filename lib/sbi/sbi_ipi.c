@@ -13,6 +13,7 @@
 #include <sbi/riscv_barrier.h>
 #include <sbi/sbi_bitops.h>
 #include <sbi/sbi_domain.h>
+#include <sbi/sbi_domain_stats.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_heap.h>
@@ -24,6 +25,7 @@
 #include <sbi/sbi_pmu.h>
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_tlb.h>
+#include <sbi/sbi_trace.h>
 
 struct sbi_ipi_data {
 	unsigned long ipi_type;
@@ -91,6 +93,8 @@ static int sbi_ipi_send(struct sbi_scratch *scratch, u32 remote_hartindex,
 		ret = sbi_ipi_raw_send(remote_hartindex, false);
 
 	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_IPI_SENT);
+	sbi_domain_stats_inc(IPI_SENT);
+	sbi_trace(IPI_SEND, remote_hartindex, event);
 
 	return ret;
 }
@@ -178,6 +182,25 @@ done:
 	return rc;
 }
 
+/**
+ * Unlike sbi_ipi_send_many(), the target HART does not have to be
+ * assigned to the domain of the current HART. This is meant for
+ * firmware services which notify other domains.
+ */
+int sbi_ipi_send_hartindex(u32 hartindex, u32 event, void *data)
+{
+	int rc;
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+
+	do {
+		rc = sbi_ipi_send(scratch, hartindex, event, data);
+	} while (rc == SBI_IPI_UPDATE_RETRY);
+
+	sbi_ipi_sync(scratch, event);
+
+	return rc < 0 ? rc : 0;
+}
+
 int sbi_ipi_event_create(const struct sbi_ipi_event_ops *ops)
 {
 	int i, ret = SBI_ENOSPC;
@@ -263,9 +286,11 @@ void sbi_ipi_process(void)
 			sbi_scratch_offset_ptr(scratch, ipi_data_off);
 
 	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_IPI_RECVD);
+	sbi_domain_stats_inc(IPI_RECVD);
 	sbi_ipi_raw_clear(false);
 
 	ipi_type = atomic_raw_xchg_ulong(&ipi_data->ipi_type, 0);
+	sbi_trace(IPI_RECV, ipi_type, 0);
 	ipi_event = 0;
 	while (ipi_type) {
 		if (ipi_type & 1UL) {
@@ -17,6 +17,7 @@
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_mpxy.h>
 #include <sbi/sbi_scratch.h>
+#include <sbi/sbi_shmem.h>
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_bitops.h>
 #include <sbi/sbi_console.h>
@@ -362,10 +363,14 @@ int sbi_mpxy_set_shmem(unsigned long shmem_phys_lo,
 {
 	struct mpxy_state *ms = sbi_domain_mpxy_state_thishart_ptr();
 	unsigned long *ret_buf;
+	int ret;
 
 	/** Disable shared memory if both hi and lo have all bit 1s */
 	if (shmem_phys_lo == INVALID_ADDR &&
 	    shmem_phys_hi == INVALID_ADDR) {
+		if (mpxy_shmem_enabled(ms))
+			sbi_shmem_unregister((unsigned long)hart_shmem_base(ms),
+					     mpxy_shmem_size);
 		sbi_mpxy_shmem_disable(ms);
 		return SBI_SUCCESS;
 	}
@@ -373,29 +378,12 @@ int sbi_mpxy_set_shmem(unsigned long shmem_phys_lo,
 	if (flags >= SBI_EXT_MPXY_SHMEM_FLAG_MAX_IDX)
 		return SBI_ERR_INVALID_PARAM;
 
-	/** Check shared memory size and address aligned to 4K Page */
-	if (shmem_phys_lo & ~PAGE_MASK)
-		return SBI_ERR_INVALID_PARAM;
-
-	/*
-	* On RV32, the M-mode can only access the first 4GB of
-	* the physical address space because M-mode does not have
-	* MMU to access full 34-bit physical address space.
-	* So fail if the upper 32 bits of the physical address
-	* is non-zero on RV32.
-	*
-	* On RV64, kernel sets upper 64bit address part to zero.
-	* So fail if the upper 64bit of the physical address
-	* is non-zero on RV64.
-	*/
-	if (shmem_phys_hi)
-		return SBI_ERR_INVALID_ADDRESS;
-
-	if (!sbi_domain_check_addr_range(sbi_domain_thishart_ptr(),
-				SHMEM_PHYS_ADDR(shmem_phys_hi, shmem_phys_lo),
-				mpxy_shmem_size, PRV_S,
-				SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
-		return SBI_ERR_INVALID_ADDRESS;
+	/** Check shared memory address aligned to 4K Page */
+	ret = sbi_shmem_check(PRV_S, shmem_phys_lo, shmem_phys_hi,
+			      mpxy_shmem_size, PAGE_SIZE,
+			      SBI_DOMAIN_READ | SBI_DOMAIN_WRITE);
+	if (ret)
+		return ret;
 
 	/** Save the current shmem details in new shmem region */
 	if (flags == SBI_EXT_MPXY_SHMEM_FLAG_OVERWRITE_RETURN) {
@@ -408,8 +396,12 @@ int sbi_mpxy_set_shmem(unsigned long shmem_phys_lo,
 	}
 
 	/** Setup the new shared memory */
+	if (mpxy_shmem_enabled(ms))
+		sbi_shmem_unregister((unsigned long)hart_shmem_base(ms),
+				     mpxy_shmem_size);
 	ms->shmem.shmem_addr_lo = shmem_phys_lo;
 	ms->shmem.shmem_addr_hi = shmem_phys_hi;
+	sbi_shmem_register((unsigned long)hart_shmem_base(ms), mpxy_shmem_size);
 
 	return SBI_SUCCESS;
 }
@@ -18,6 +18,7 @@
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_pmu.h>
 #include <sbi/sbi_scratch.h>
+#include <sbi/sbi_shmem.h>
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_sse.h>
 
@@ -146,6 +147,15 @@ static bool pmu_event_select_overlap(struct sbi_pmu_hw_event *evt,
 	return false;
 }
 
+/* Firmware events defined by the SBI spec, OpenSBI or the platform */
+static bool pmu_fw_event_code_valid(uint32_t event_code)
+{
+	return event_code < SBI_PMU_FW_MAX ||
+	       (SBI_PMU_FW_OPENSBI_START <= event_code &&
+		event_code < SBI_PMU_FW_OPENSBI_MAX) ||
+	       event_code == SBI_PMU_FW_PLATFORM;
+}
+
 static int pmu_event_validate(struct sbi_pmu_hart_state *phs,
 			      unsigned long event_idx, uint64_t edata)
 {
@@ -159,18 +169,16 @@ static int pmu_event_validate(struct sbi_pmu_hart_state *phs,
 		event_idx_code_max = SBI_PMU_HW_GENERAL_MAX;
 		break;
 	case SBI_PMU_EVENT_TYPE_FW:
-		if ((event_idx_code >= SBI_PMU_FW_MAX &&
-		    event_idx_code <= SBI_PMU_FW_RESERVED_MAX) ||
-		    event_idx_code > SBI_PMU_FW_PLATFORM)
+		if (!pmu_fw_event_code_valid(event_idx_code))
 			return SBI_EINVAL;
 
-		if (SBI_PMU_FW_PLATFORM == event_idx_code &&
-		    pmu_dev && pmu_dev->fw_event_validate_encoding)
-			return pmu_dev->fw_event_validate_encoding(phs->hartid,
-							           edata);
-		else
-			event_idx_code_max = SBI_PMU_FW_MAX;
-		break;
+		if (SBI_PMU_FW_PLATFORM == event_idx_code) {
+			if (pmu_dev && pmu_dev->fw_event_validate_encoding)
+				return pmu_dev->fw_event_validate_encoding(
+							phs->hartid, edata);
+			return SBI_EINVAL;
+		}
+		return event_idx_type;
 	case SBI_PMU_EVENT_TYPE_HW_CACHE:
 		cache_ops_result = event_idx_code &
 					SBI_PMU_EVENT_HW_CACHE_OPS_RESULT;
@@ -256,9 +264,7 @@ int sbi_pmu_ctr_fw_read(unsigned long cidx, uint64_t *cval, bool high_bits)
 	if (event_idx_type != SBI_PMU_EVENT_TYPE_FW)
 		return SBI_EINVAL;
 
-	if ((event_code >= SBI_PMU_FW_MAX &&
-	    event_code <= SBI_PMU_FW_RESERVED_MAX) ||
-	    event_code > SBI_PMU_FW_PLATFORM)
+	if (!pmu_fw_event_code_valid(event_code))
 		return SBI_EINVAL;
 
 	if (SBI_PMU_FW_PLATFORM == event_code) {
@@ -466,9 +472,7 @@ static int pmu_ctr_start_fw(struct sbi_pmu_hart_state *phs,
 {
 	int ret;
 
-	if ((event_code >= SBI_PMU_FW_MAX &&
-	    event_code <= SBI_PMU_FW_RESERVED_MAX) ||
-	    event_code > SBI_PMU_FW_PLATFORM)
+	if (!pmu_fw_event_code_valid(event_code))
 		return SBI_EINVAL;
 
 	if (phs->fw_counters_started & BIT(cidx - num_hw_ctrs))
@@ -641,9 +645,7 @@ static int pmu_ctr_stop_fw(struct sbi_pmu_hart_state *phs,
 {
 	int ret;
 
-	if ((event_code >= SBI_PMU_FW_MAX &&
-	    event_code <= SBI_PMU_FW_RESERVED_MAX) ||
-	    event_code > SBI_PMU_FW_PLATFORM)
+	if (!pmu_fw_event_code_valid(event_code))
 		return SBI_EINVAL;
 
 	if (!(phs->fw_counters_started & BIT(cidx - num_hw_ctrs)))
@@ -996,7 +998,8 @@ int sbi_pmu_ctr_incr_fw(enum sbi_pmu_fw_event_code_id fw_id)
 	if (likely(!phs->fw_counters_started))
 		return 0;
 
-	if (unlikely(fw_id >= SBI_PMU_FW_MAX))
+	if (unlikely(fw_id == SBI_PMU_FW_PLATFORM ||
+		     !pmu_fw_event_code_valid(fw_id)))
 		return SBI_EINVAL;
 
 	for (cidx = num_hw_ctrs; cidx < total_ctrs; cidx++) {
@@ -1062,7 +1065,7 @@ int sbi_pmu_event_get_info(unsigned long shmem_phys_lo, unsigned long shmem_phys
 			   unsigned long num_events, unsigned long flags)
 {
 	unsigned long shmem_size = num_events * sizeof(struct sbi_pmu_event_info);
-	int i, j, event_type;
+	int i, j, event_type, rc;
 	struct sbi_pmu_event_info *einfo;
 	struct sbi_pmu_hart_state *phs = pmu_thishart_state_ptr();
 	uint32_t event_idx;
@@ -1072,26 +1075,14 @@ int sbi_pmu_event_get_info(unsigned long shmem_phys_lo, unsigned long shmem_phys
 	if (flags != 0)
 		return SBI_ERR_INVALID_PARAM;
 
-	/** Check shared memory size and address aligned to 16 byte */
-	if (!num_events || (shmem_phys_lo & 0xF))
+	if (!num_events)
 		return SBI_ERR_INVALID_PARAM;
 
-	/*
-	 * On RV32, the M-mode can only access the first 4GB of
-	 * the physical address space because M-mode does not have
-	 * MMU to access full 34-bit physical address space.
-	 *
-	 * Based on above, we simply fail if the upper 32bits of
-	 * the physical address (i.e. a2 register) is non-zero on
-	 * RV32.
-	 */
-	if (shmem_phys_hi)
-		return SBI_EINVALID_ADDR;
-
-	if (!sbi_domain_check_addr_range(sbi_domain_thishart_ptr(),
-					 shmem_phys_lo, shmem_size, PRV_S,
-					 SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
-		return SBI_ERR_INVALID_ADDRESS;
+	/** Check shared memory address aligned to 16 byte */
+	rc = sbi_shmem_check(PRV_S, shmem_phys_lo, shmem_phys_hi, shmem_size,
+			     16, SBI_DOMAIN_READ | SBI_DOMAIN_WRITE);
+	if (rc)
+		return rc;
 
 	sbi_hart_protection_map_range(shmem_phys_lo, shmem_size);
 
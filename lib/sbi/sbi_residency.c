@@ -0,0 +1,217 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_platform.h>
+#include <sbi/sbi_residency.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_timer.h>
+#include <sbi/sbi_trap.h>
+
+/*
+ * Per-HART residency state
+ *
+ * A stay starts when a trap is taken from a lower privilege mode and
+ * ends when sbi_trap_handler() returns to it. Traps taken from M-mode
+ * are part of the enclosing stay. By the time the stay ends, the code
+ * which took long has already returned so the backtrace is captured
+ * by sbi_residency_check() from the places where M-mode waits.
+ */
+struct sbi_residency {
+	/* Start of the current stay (zero when not in a stay) */
+	u64 start;
+	/* Current stay, copied to info when it exceeds the threshold */
+	struct sbi_residency_record cur;
+	struct sbi_residency_info info;
+};
+
+static unsigned long residency_ptr_offset;
+static u64 residency_threshold;
+
+#define residency_get_hart_ptr(__scratch)				\
+	sbi_scratch_read_type((__scratch), struct sbi_residency *,	\
+			      residency_ptr_offset)
+
+#define residency_set_hart_ptr(__scratch, __res)			\
+	sbi_scratch_write_type((__scratch), struct sbi_residency *,	\
+			       residency_ptr_offset, (__res))
+
+static inline struct sbi_residency *residency_thishart_ptr(void)
+{
+	if (!residency_ptr_offset)
+		return NULL;
+	return residency_get_hart_ptr(sbi_scratch_thishart_ptr());
+}
+
+void sbi_residency_enter(const struct sbi_trap_context *tcntx)
+{
+	struct sbi_residency *res = residency_thishart_ptr();
+	const struct sbi_trap_regs *regs = &tcntx->regs;
+
+	if (!res || sbi_mstatus_prev_mode(regs->mstatus) == PRV_M)
+		return;
+
+	res->start = sbi_timer_value();
+	res->cur.timestamp = res->start;
+	res->cur.mcause = tcntx->trap.cause;
+	res->cur.mepc = regs->mepc;
+	if (tcntx->trap.cause == CAUSE_SUPERVISOR_ECALL) {
+		res->cur.extid = regs->a7;
+		res->cur.fid = regs->a6;
+	} else {
+		res->cur.extid = 0;
+		res->cur.fid = 0;
+	}
+	res->cur.nr_frames = 0;
+}
+
+void sbi_residency_exit(const struct sbi_trap_context *tcntx)
+{
+	struct sbi_residency *res = residency_thishart_ptr();
+	struct sbi_residency_info *info;
+	u64 duration;
+
+	if (!res || !res->start ||
+	    sbi_mstatus_prev_mode(tcntx->regs.mstatus) == PRV_M)
+		return;
+
+	duration = sbi_timer_value() - res->start;
+	res->start = 0;
+
+	info = &res->info;
+	if (info->max_duration < duration)
+		info->max_duration = duration;
+	if (duration <= residency_threshold)
+		return;
+
+	res->cur.duration = duration;
+	info->nr_exceeded++;
+	sbi_memcpy(&info->last, &res->cur, sizeof(info->last));
+	if (info->worst.duration < duration)
+		sbi_memcpy(&info->worst, &res->cur, sizeof(info->worst));
+}
+
+/*
+ * Walk the frame pointer chain of the current HART stack. The chain
+ * ends at the trap entry where the frame pointer still holds a value
+ * of the lower privilege mode, so stop at the first frame outside of
+ * the stack.
+ */
+static __always_inline u64 residency_backtrace(u64 *frames, u64 max)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	u32 stack_size = sbi_platform_hart_stack_size(sbi_platform_ptr(scratch));
+	ulong top = (ulong)scratch;
+	ulong bottom = top + SBI_SCRATCH_SIZE - stack_size;
+	ulong fp = (ulong)__builtin_frame_address(0);
+	ulong prev = bottom;
+	u64 n = 0;
+
+	while (n < max && prev < fp && fp <= top &&
+	       !(fp & (sizeof(ulong) - 1))) {
+		frames[n++] = ((ulong *)fp)[-1];
+		prev = fp;
+		fp = ((ulong *)fp)[-2];
+	}
+
+	return n;
+}
+
+void sbi_residency_check(void)
+{
+	struct sbi_residency *res = residency_thishart_ptr();
+
+	/* Keep the backtrace of the first wait which crossed the threshold */
+	if (!res || !res->start || res->cur.nr_frames)
+		return;
+
+	if (sbi_timer_value() - res->start <= residency_threshold)
+		return;
+
+	res->cur.nr_frames = residency_backtrace(res->cur.backtrace,
+						 SBI_RESIDENCY_FRAMES);
+}
+
+static int residency_hart_ptr(u32 hartindex, struct sbi_residency **res)
+{
+	struct sbi_scratch *scratch;
+
+	if (!residency_ptr_offset)
+		return SBI_ENOTSUPP;
+
+	scratch = sbi_hartindex_to_scratch(hartindex);
+	if (!scratch)
+		return SBI_EINVAL;
+
+	*res = residency_get_hart_ptr(scratch);
+	return *res ? 0 : SBI_ENOTSUPP;
+}
+
+int sbi_residency_get(u32 hartindex, struct sbi_residency_info *out)
+{
+	struct sbi_residency *res;
+	int rc;
+
+	rc = residency_hart_ptr(hartindex, &res);
+	if (rc)
+		return rc;
+
+	sbi_memcpy(out, &res->info, sizeof(*out));
+	return 0;
+}
+
+#ifdef CONFIG_SBIUNIT
+int sbi_residency_set(u32 hartindex, const struct sbi_residency_info *in)
+{
+	struct sbi_residency *res;
+	int rc;
+
+	rc = residency_hart_ptr(hartindex, &res);
+	if (rc)
+		return rc;
+
+	sbi_memcpy(&res->info, in, sizeof(res->info));
+	return 0;
+}
+#endif
+
+int sbi_residency_init(struct sbi_scratch *scratch)
+{
+	struct sbi_scratch *hscratch;
+	struct sbi_residency *res;
+
+	/* Residency tracking stays disabled without a timer device */
+	if (!sbi_timer_get_device())
+		return 0;
+
+	residency_threshold =
+		sbi_timer_compute_udelta(CONFIG_SBI_RESIDENCY_THRESHOLD_US);
+
+	residency_ptr_offset =
+		sbi_scratch_alloc_type_offset(struct sbi_residency *);
+	if (!residency_ptr_offset)
+		return SBI_ENOMEM;
+
+	sbi_for_each_hartindex(i) {
+		hscratch = sbi_hartindex_to_scratch(i);
+		if (!hscratch)
+			continue;
+
+		res = sbi_zalloc(sizeof(*res));
+		if (!res)
+			return SBI_ENOMEM;
+		res->info.threshold = residency_threshold;
+		res->info.hartid = sbi_hartindex_to_hartid(i);
+		residency_set_hart_ptr(hscratch, res);
+	}
+
+	return 0;
+}
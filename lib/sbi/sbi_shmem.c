@@ -0,0 +1,48 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hart_protection.h>
+#include <sbi/sbi_shmem.h>
+
+int sbi_shmem_check(unsigned long mode, unsigned long addr_lo,
+		    unsigned long addr_hi, unsigned long size,
+		    unsigned long align, unsigned long access)
+{
+	if (addr_lo & (align - 1))
+		return SBI_EINVAL;
+
+	/*
+	 * On RV32, the M-mode can only access the first 4GB of
+	 * the physical address space because M-mode does not have
+	 * MMU to access full 34-bit physical address space.
+	 *
+	 * On RV64, kernel sets upper 64bit address part to zero.
+	 *
+	 * So fail if the upper part of the physical address is
+	 * non-zero.
+	 */
+	if (addr_hi)
+		return SBI_EINVALID_ADDR;
+
+	if (!sbi_domain_check_addr_range(sbi_domain_thishart_ptr(),
+					 addr_lo, size, mode, access))
+		return SBI_EINVALID_ADDR;
+
+	return 0;
+}
+
+void sbi_shmem_register(unsigned long addr, unsigned long size)
+{
+	/* Shared memory which can't be kept is mapped for each access */
+	sbi_hart_protection_keep_range(addr, size);
+}
+
+void sbi_shmem_unregister(unsigned long addr, unsigned long size)
+{
+	sbi_hart_protection_forget_range(addr, size);
+}
@@ -24,6 +24,7 @@
 #include <sbi/sbi_pmu.h>
 #include <sbi/sbi_sse.h>
 #include <sbi/sbi_scratch.h>
+#include <sbi/sbi_shmem.h>
 #include <sbi/sbi_slist.h>
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_trap.h>
@@ -983,27 +984,12 @@ int sbi_sse_attr_check(uint32_t base_attr_id, uint32_t attr_count,
 	if (end_id >= SBI_SSE_ATTR_MAX)
 		return SBI_EBAD_RANGE;
 
+	/* Misaligned output is an invalid address for SSE */
 	if (phys_lo & (align - 1))
 		return SBI_EINVALID_ADDR;
 
-	/*
-	 * On RV32, the M-mode can only access the first 4GB of
-	 * the physical address space because M-mode does not have
-	 * MMU to access full 34-bit physical address space.
-	 *
-	 * Based on above, we simply fail if the upper 32bits of
-	 * the physical address (i.e. a2 register) is non-zero on
-	 * RV32.
-	 */
-	if (phys_hi)
-		return SBI_EINVALID_ADDR;
-
-	if (!sbi_domain_check_addr_range(sbi_domain_thishart_ptr(), phys_lo,
-					 sizeof(unsigned long) * attr_count,
-					 PRV_S, access))
-		return SBI_EINVALID_ADDR;
-
-	return SBI_OK;
+	return sbi_shmem_check(PRV_S, phys_lo, phys_hi,
+			       sizeof(unsigned long) * attr_count, 1, access);
 }
 
 static void copy_attrs(unsigned long *out, const unsigned long *in,
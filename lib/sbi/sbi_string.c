@@ -8,12 +8,57 @@
  */
 
 /*
- * Simple libc functions. These are not optimized at all and might have some
- * bugs as well. Use any optimized routines from newlib or glibc if required.
+ * Simple libc functions. The memory and the most frequently used string
+ * functions work a word at a time when the buffers are suitably aligned
+ * (the firmware is built with strict alignment so misaligned word
+ * accesses are never generated). The rest are plain byte loops.
  */
 
 #include <sbi/sbi_string.h>
 
+#define WORD_SIZE		sizeof(unsigned long)
+#define WORD_MASK		(WORD_SIZE - 1)
+#define WORD_ONES		(~0UL / 0xff)
+#define WORD_HIGHS		(WORD_ONES << 7)
+
+#define word_aligned(__p)	(!((unsigned long)(__p) & WORD_MASK))
+#define words_aligned(__a, __b)	\
+	(!(((unsigned long)(__a) ^ (unsigned long)(__b)) & WORD_MASK))
+
+/* Use Zbb orc.b based string functions (set at boot time) */
+static bool string_use_zbb;
+
+void sbi_string_use_zbb(bool enable)
+{
+#ifdef CONFIG_SBI_STRING_ZBB
+	string_use_zbb = enable;
+#endif
+}
+
+/* Non-zero if any byte of the word is zero */
+static inline unsigned long word_has_zero(unsigned long w)
+{
+	return (w - WORD_ONES) & ~w & WORD_HIGHS;
+}
+
+#ifdef CONFIG_SBI_STRING_ZBB
+static inline unsigned long orc_b(unsigned long w)
+{
+	unsigned long ret;
+
+	/* orc.b ret, w (encoded so that the assembler need not know Zbb) */
+	asm(".insn i 0x13, 0x5, %0, %1, 0x287" : "=r"(ret) : "r"(w));
+	return ret;
+}
+
+static inline unsigned long word_has_zero_zbb(unsigned long w)
+{
+	return ~orc_b(w);
+}
+#else
+#define word_has_zero_zbb(__w)	word_has_zero(__w)
+#endif
+
 /*
   Provides sbi_strcmp for the completeness of supporting string functions.
   it is not recommended to use sbi_strcmp() but use sbi_strncmp instead.
@@ -27,8 +72,40 @@ int sbi_strcmp(const char *a, const char *b)
 	return *a - *b;
 }
 
+/*
+ * Skip the words which are equal and have no NUL byte. The byte loop
+ * in the callers then finds the exact position of the difference.
+ */
+#define __strncmp_words(__a, __b, __count, __has_zero)			\
+do {									\
+	const unsigned long *__wa = (const void *)(__a);		\
+	const unsigned long *__wb = (const void *)(__b);		\
+									\
+	while ((__count) >= WORD_SIZE && *__wa == *__wb &&		\
+	       !__has_zero(*__wa)) {					\
+		__wa++;							\
+		__wb++;							\
+		(__count) -= WORD_SIZE;					\
+	}								\
+	(__a) = (const char *)__wa;					\
+	(__b) = (const char *)__wb;					\
+} while (0)
+
 int sbi_strncmp(const char *a, const char *b, size_t count)
 {
+	if (words_aligned(a, b)) {
+		/* Compare the unaligned head byte by byte */
+		for (; count > 0 && !word_aligned(a); a++, b++, count--) {
+			if (*a != *b || *a == '\0')
+				return *a - *b;
+		}
+
+		if (string_use_zbb)
+			__strncmp_words(a, b, count, word_has_zero_zbb);
+		else
+			__strncmp_words(a, b, count, word_has_zero);
+	}
+
 	/* search first diff or end of string */
 	for (; count > 0 && *a == *b && *a != '\0'; a++, b++, count--)
 		;
@@ -40,16 +117,38 @@ int sbi_strncmp(const char *a, const char *b, size_t count)
 	return *a - *b;
 }
 
+/*
+ * Reading the whole aligned word which contains the terminating NUL
+ * never crosses a page or PMP region boundary, so this is safe even
+ * though it reads past the end of the string.
+ */
+#define __strlen_words(__s, __has_zero)					\
+do {									\
+	const unsigned long *__w = (const void *)(__s);			\
+									\
+	while (!__has_zero(*__w))					\
+		__w++;							\
+	(__s) = (const char *)__w;					\
+} while (0)
+
 size_t sbi_strlen(const char *str)
 {
-	unsigned long ret = 0;
+	const char *s = str;
 
-	while (*str != '\0') {
-		ret++;
-		str++;
+	for (; !word_aligned(s); s++) {
+		if (*s == '\0')
+			return s - str;
 	}
 
-	return ret;
+	if (string_use_zbb)
+		__strlen_words(s, word_has_zero_zbb);
+	else
+		__strlen_words(s, word_has_zero);
+
+	while (*s != '\0')
+		s++;
+
+	return s - str;
 }
 
 size_t sbi_strnlen(const char *str, size_t count)
@@ -110,8 +209,27 @@ char *sbi_strrchr(const char *s, int c)
 }
 void *sbi_memset(void *s, int c, size_t count)
 {
+	unsigned long *wtemp, wc;
 	char *temp = s;
 
+	if (count >= 2 * WORD_SIZE) {
+		for (; !word_aligned(temp); count--)
+			*temp++ = c;
+
+		wc = (unsigned char)c * WORD_ONES;
+		wtemp = (unsigned long *)temp;
+		for (; count >= 4 * WORD_SIZE; count -= 4 * WORD_SIZE) {
+			wtemp[0] = wc;
+			wtemp[1] = wc;
+			wtemp[2] = wc;
+			wtemp[3] = wc;
+			wtemp += 4;
+		}
+		for (; count >= WORD_SIZE; count -= WORD_SIZE)
+			*wtemp++ = wc;
+		temp = (char *)wtemp;
+	}
+
 	while (count > 0) {
 		count--;
 		*temp++ = c;
@@ -120,41 +238,85 @@ void *sbi_memset(void *s, int c, size_t count)
 	return s;
 }
 
-void *sbi_memcpy(void *dest, const void *src, size_t count)
+/* Copy forward, a word at a time if dest and src are mutually aligned */
+static void memcpy_forward(char *temp1, const char *temp2, size_t count)
 {
-	char *temp1	  = dest;
-	const char *temp2 = src;
+	const unsigned long *wtemp2;
+	unsigned long *wtemp1;
+
+	if (count >= 2 * WORD_SIZE && words_aligned(temp1, temp2)) {
+		for (; !word_aligned(temp1); count--)
+			*temp1++ = *temp2++;
+
+		wtemp1 = (unsigned long *)temp1;
+		wtemp2 = (const unsigned long *)temp2;
+		for (; count >= 4 * WORD_SIZE; count -= 4 * WORD_SIZE) {
+			wtemp1[0] = wtemp2[0];
+			wtemp1[1] = wtemp2[1];
+			wtemp1[2] = wtemp2[2];
+			wtemp1[3] = wtemp2[3];
+			wtemp1 += 4;
+			wtemp2 += 4;
+		}
+		for (; count >= WORD_SIZE; count -= WORD_SIZE)
+			*wtemp1++ = *wtemp2++;
+		temp1 = (char *)wtemp1;
+		temp2 = (const char *)wtemp2;
+	}
 
 	while (count > 0) {
 		*temp1++ = *temp2++;
 		count--;
 	}
+}
+
+/* Copy backward from the end, used by memmove() for overlapping buffers */
+static void memcpy_backward(char *temp1, const char *temp2, size_t count)
+{
+	const unsigned long *wtemp2;
+	unsigned long *wtemp1;
+
+	temp1 += count;
+	temp2 += count;
+
+	if (count >= 2 * WORD_SIZE && words_aligned(temp1, temp2)) {
+		for (; !word_aligned(temp1); count--)
+			*--temp1 = *--temp2;
+
+		wtemp1 = (unsigned long *)temp1;
+		wtemp2 = (const unsigned long *)temp2;
+		for (; count >= WORD_SIZE; count -= WORD_SIZE)
+			*--wtemp1 = *--wtemp2;
+		temp1 = (char *)wtemp1;
+		temp2 = (const char *)wtemp2;
+	}
+
+	while (count > 0) {
+		*--temp1 = *--temp2;
+		count--;
+	}
+}
+
+void *sbi_memcpy(void *dest, const void *src, size_t count)
+{
+	memcpy_forward(dest, src, count);
 
 	return dest;
 }
 
 void *sbi_memmove(void *dest, const void *src, size_t count)
 {
-	char *temp1	  = (char *)dest;
-	const char *temp2 = (char *)src;
-
 	if (src == dest)
 		return dest;
 
-	if (dest < src) {
-		while (count > 0) {
-			*temp1++ = *temp2++;
-			count--;
-		}
-	} else {
-		temp1 = (char *)dest + count - 1;
-		temp2 = (char *)src + count - 1;
-
-		while (count > 0) {
-			*temp1-- = *temp2--;
-			count--;
-		}
-	}
+	/*
+	 * A forward copy is safe when dest is below src even if the
+	 * buffers overlap since each word is read before it is written.
+	 */
+	if (dest < src || (const char *)src + count <= (char *)dest)
+		memcpy_forward(dest, src, count);
+	else
+		memcpy_backward(dest, src, count);
 
 	return dest;
 }
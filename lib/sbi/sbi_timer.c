@@ -17,8 +17,10 @@
 #include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_pmu.h>
+#include <sbi/sbi_residency.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_timer.h>
+#include <sbi/sbi_trace.h>
 
 struct timer_state {
 	u64 time_delta;
@@ -89,6 +91,8 @@ void sbi_timer_delay_loop(ulong units, u64 unit_freq,
 	delta = sbi_timer_compute_delta(units, unit_freq);
 	while ((get_time_val() - start_val) < delta)
 		delay_fn(opaque);
+
+	sbi_residency_check();
 }
 
 bool sbi_timer_waitms_until(bool (*predicate)(void *), void *arg,
@@ -297,6 +301,33 @@ void sbi_timer_smode_event_start(u64 next_event)
 	}
 }
 
+u64 sbi_timer_smode_event_switch(u64 next_event)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct timer_state *tstate = sbi_scratch_offset_ptr(scratch,
+							    timer_state_off);
+	u64 prev_event;
+
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SSTC))
+		return csr_swap64(CSR_STIMECMP, next_event);
+
+	/* An expired event which is still pending fires again when restored */
+	if (csr_read(CSR_MIP) & MIP_STIP)
+		prev_event = 0;
+	else if (tstate->smode_ev.hart_index > -1)
+		prev_event = tstate->smode_ev.time_stamp;
+	else
+		prev_event = -1ULL;
+
+	csr_clear(CSR_MIP, MIP_STIP);
+	if (next_event == -1ULL)
+		sbi_timer_event_stop(&tstate->smode_ev);
+	else
+		sbi_timer_event_start(&tstate->smode_ev, next_event);
+
+	return prev_event;
+}
+
 void sbi_timer_process(void)
 {
 	struct timer_state *tstate = sbi_scratch_thishart_offset_ptr(timer_state_off);
@@ -312,6 +343,7 @@ void sbi_timer_process(void)
 			break;
 
 		__sbi_timer_event_stop(ev);
+		sbi_trace(TIMER_FIRE, ev->time_stamp, ev->callback);
 		if (ev->callback) {
 			restart.required = false;
 			restart.next_event = 0;
@@ -349,6 +381,42 @@ void sbi_timer_set_device(const struct sbi_timer_device *dev)
 		get_time_val = timer_dev->timer_value;
 }
 
+#ifdef CONFIG_SBI_FAST_COUNTER_EMUL
+unsigned long sbi_timer_fast_addr_offset;
+
+static int timer_fast_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+	unsigned long addr = 0;
+
+	if (cold_boot) {
+		sbi_timer_fast_addr_offset =
+			sbi_scratch_alloc_type_offset(unsigned long);
+		if (!sbi_timer_fast_addr_offset)
+			return SBI_ENOMEM;
+	} else if (!sbi_timer_fast_addr_offset) {
+		return SBI_ENOMEM;
+	}
+
+	/*
+	 * The fast path relies on mcounteren/scounteren for the access
+	 * checks so it is only usable on privileged spec v1.10 and later.
+	 */
+	if (__riscv_xlen == 64 && timer_dev && timer_dev->timer_value_addr &&
+	    get_time_val == timer_dev->timer_value &&
+	    sbi_hart_priv_version(scratch) >= SBI_HART_PRIV_VER_1_10)
+		addr = timer_dev->timer_value_addr();
+
+	sbi_scratch_write_type(scratch, unsigned long,
+			       sbi_timer_fast_addr_offset, addr);
+	return 0;
+}
+#else
+static inline int timer_fast_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+	return 0;
+}
+#endif
+
 int sbi_timer_init(struct sbi_scratch *scratch, bool cold_boot)
 {
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
@@ -385,7 +453,7 @@ int sbi_timer_init(struct sbi_scratch *scratch, bool cold_boot)
 			return ret;
 	}
 
-	return 0;
+	return timer_fast_init(scratch, cold_boot);
 }
 
 void sbi_timer_exit(struct sbi_scratch *scratch)
@@ -11,6 +11,7 @@
 #include <sbi/riscv_asm.h>
 #include <sbi/riscv_atomic.h>
 #include <sbi/riscv_barrier.h>
+#include <sbi/sbi_domain_stats.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_fifo.h>
 #include <sbi/sbi_hart.h>
@@ -23,6 +24,8 @@
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_pmu.h>
+#include <sbi/sbi_residency.h>
+#include <sbi/sbi_trace.h>
 
 static unsigned long tlb_sync_off;
 static unsigned long tlb_fifo_off;
@@ -246,6 +249,7 @@ static void tlb_entry_process(struct sbi_tlb_info *tinfo)
 	struct sbi_scratch *rscratch = NULL;
 	atomic_t *rtlb_sync = NULL;
 
+	sbi_trace(TLB_PROCESS, tinfo->type, tinfo->start);
 	tlb_entry_local_process(tinfo);
 
 	sbi_hartmask_for_each_hartindex(rindex, &tinfo->smask) {
@@ -288,6 +292,7 @@ static void tlb_sync(struct sbi_scratch *scratch)
 		 * consume fifo requests to avoid deadlock.
 		 */
 		tlb_process_once(scratch);
+		sbi_residency_check();
 	}
 
 	return;
@@ -394,6 +399,7 @@ static int tlb_update(struct sbi_scratch *scratch,
 		 * this properly.
 		 */
 		tlb_process_once(scratch);
+		sbi_residency_check();
 		sbi_dprintf("hart%d: hart%d tlb fifo full\n", curr_hartid,
 			    sbi_hartindex_to_hartid(remote_hartindex));
 		return SBI_IPI_UPDATE_RETRY;
@@ -402,6 +408,8 @@ static int tlb_update(struct sbi_scratch *scratch,
 	tlb_sync = sbi_scratch_offset_ptr(scratch, tlb_sync_off);
 	atomic_add_return(tlb_sync, 1);
 
+	sbi_trace(TLB_ENQUEUE, remote_hartindex, tinfo->type);
+
 	return SBI_IPI_UPDATE_SUCCESS;
 }
 
@@ -440,6 +448,7 @@ int sbi_tlb_request(ulong hmask, ulong hbase, struct sbi_tlb_info *tinfo)
 	}
 
 	sbi_pmu_ctr_incr_fw(tlb_type_to_pmu_fw_event[tinfo->type]);
+	sbi_domain_stats_inc(RFENCE);
 
 	return sbi_ipi_send_many(hmask, hbase, tlb_event, tinfo);
 }
@@ -0,0 +1,240 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/sbi_bitops.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hart_protection.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_shmem.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_timer.h>
+#include <sbi/sbi_trace.h>
+
+#define TRACE_STAGE_RECORDS	CONFIG_SBI_TRACE_STAGE_RECORDS
+
+/*
+ * Per-HART trace state
+ *
+ * Tracepoints only append to the staging ring of the current HART
+ * which lives in M-mode memory, so recording an event does not need
+ * any lock or PMP/Smepmp mapping. Staged records are copied to the
+ * shared memory registered by S-mode in batches, either when the
+ * HART returns to a lower privilege mode with enough records pending
+ * or when S-mode explicitly asks for a flush.
+ */
+struct sbi_trace_hart {
+	/* Enabled events (zero when tracing is disabled) */
+	unsigned long event_mask;
+	/* Shared memory registered by S-mode */
+	unsigned long shmem_addr;
+	unsigned long shmem_size;
+	u32 nr_records;
+	/* Domain which registered the shared memory */
+	struct sbi_domain *dom;
+	/* Number of records staged so far */
+	u64 head;
+	/* Number of staged records already copied to shared memory */
+	u64 flushed;
+	/* Number of records written to shared memory */
+	u64 shmem_head;
+	u64 lost;
+	struct sbi_trace_record recs[TRACE_STAGE_RECORDS];
+};
+
+static unsigned long trace_ptr_offset;
+
+#define trace_get_hart_ptr(__scratch)					\
+	sbi_scratch_read_type((__scratch), struct sbi_trace_hart *,	\
+			      trace_ptr_offset)
+
+#define trace_set_hart_ptr(__scratch, __th)				\
+	sbi_scratch_write_type((__scratch), struct sbi_trace_hart *,	\
+			       trace_ptr_offset, (__th))
+
+static inline struct sbi_trace_hart *trace_thishart_ptr(void)
+{
+	if (!trace_ptr_offset)
+		return NULL;
+	return trace_get_hart_ptr(sbi_scratch_thishart_ptr());
+}
+
+void __sbi_trace(u32 event, unsigned long arg0, unsigned long arg1)
+{
+	struct sbi_trace_hart *th = trace_thishart_ptr();
+	struct sbi_trace_record *rec;
+
+	if (!th || !(th->event_mask & BIT(event)))
+		return;
+
+	/*
+	 * Traps taken while M-mode is already writing a record can
+	 * only come from firmware bugs, so a torn record in that case
+	 * is acceptable.
+	 */
+	rec = &th->recs[th->head % TRACE_STAGE_RECORDS];
+	rec->timestamp = sbi_timer_value();
+	rec->event = event;
+	rec->hartid = current_hartid();
+	rec->arg0 = arg0;
+	rec->arg1 = arg1;
+	th->head++;
+}
+
+static void trace_flush(struct sbi_trace_hart *th)
+{
+	struct sbi_trace_shmem_header *hdr;
+	struct sbi_trace_record *recs;
+	u64 start;
+
+	if (th->flushed == th->head)
+		return;
+
+	/*
+	 * The shared memory belongs to the domain which registered it
+	 * so records staged while the HART runs in another domain are
+	 * not flushed until the HART returns to that domain.
+	 */
+	if (!th->shmem_addr || th->dom != sbi_domain_thishart_ptr())
+		return;
+
+	start = th->flushed;
+	if (TRACE_STAGE_RECORDS < th->head - start) {
+		th->lost += th->head - start - TRACE_STAGE_RECORDS;
+		start = th->head - TRACE_STAGE_RECORDS;
+	}
+
+	sbi_hart_protection_map_range(th->shmem_addr, th->shmem_size);
+
+	hdr = (struct sbi_trace_shmem_header *)th->shmem_addr;
+	recs = (struct sbi_trace_record *)(hdr + 1);
+	for (; start < th->head; start++) {
+		sbi_memcpy(&recs[th->shmem_head % th->nr_records],
+			   &th->recs[start % TRACE_STAGE_RECORDS],
+			   sizeof(struct sbi_trace_record));
+		th->shmem_head++;
+	}
+
+	/* Make records visible before the new head */
+	smp_wmb();
+	hdr->lost = th->lost;
+	hdr->head = th->shmem_head;
+
+	sbi_hart_protection_unmap_range(th->shmem_addr, th->shmem_size);
+
+	th->flushed = th->head;
+}
+
+void sbi_trace_flush(void)
+{
+	struct sbi_trace_hart *th = trace_thishart_ptr();
+
+	if (th)
+		trace_flush(th);
+}
+
+void sbi_trace_process(void)
+{
+	struct sbi_trace_hart *th = trace_thishart_ptr();
+
+	if (th && (TRACE_STAGE_RECORDS / 2) <= th->head - th->flushed)
+		trace_flush(th);
+}
+
+int sbi_trace_set_shmem(unsigned long addr, unsigned long size,
+			unsigned long event_mask)
+{
+	struct sbi_trace_hart *th = trace_thishart_ptr();
+	struct sbi_trace_shmem_header *hdr;
+	unsigned long nr_records;
+
+	if (!th)
+		return SBI_ENOTSUPP;
+
+	if (event_mask & ~(BIT(SBI_TRACE_EVENT_MAX) - 1))
+		return SBI_EINVAL;
+
+	if (size < sizeof(*hdr))
+		return SBI_EINVAL;
+	nr_records = (size - sizeof(*hdr)) / sizeof(struct sbi_trace_record);
+	if (!nr_records || (u32)-1 < nr_records)
+		return SBI_EINVAL;
+
+	/* Stop recording while the shared memory is being switched */
+	th->event_mask = 0;
+	trace_flush(th);
+
+	sbi_hart_protection_map_range(addr, size);
+	hdr = (struct sbi_trace_shmem_header *)addr;
+	sbi_memset(hdr, 0, sizeof(*hdr));
+	hdr->version = SBI_TRACE_SHMEM_VERSION;
+	hdr->record_size = sizeof(struct sbi_trace_record);
+	hdr->nr_records = nr_records;
+	hdr->hartid = current_hartid();
+	sbi_hart_protection_unmap_range(addr, size);
+
+	if (th->shmem_addr)
+		sbi_shmem_unregister(th->shmem_addr, th->shmem_size);
+	sbi_shmem_register(addr, size);
+	th->shmem_addr = addr;
+	th->shmem_size = size;
+	th->nr_records = nr_records;
+	th->dom = sbi_domain_thishart_ptr();
+	th->shmem_head = 0;
+	th->lost = 0;
+	th->flushed = th->head;
+	th->event_mask = event_mask;
+
+	return 0;
+}
+
+void sbi_trace_disable(void)
+{
+	struct sbi_trace_hart *th = trace_thishart_ptr();
+
+	if (!th)
+		return;
+
+	th->event_mask = 0;
+	if (th->shmem_addr)
+		sbi_shmem_unregister(th->shmem_addr, th->shmem_size);
+	th->shmem_addr = 0;
+	th->shmem_size = 0;
+	th->nr_records = 0;
+	th->dom = NULL;
+	th->flushed = th->head;
+}
+
+unsigned long sbi_trace_heap_size(u32 hart_count)
+{
+	return sizeof(struct sbi_trace_hart) * hart_count;
+}
+
+int sbi_trace_init(struct sbi_scratch *scratch)
+{
+	struct sbi_scratch *hscratch;
+	struct sbi_trace_hart *th;
+
+	trace_ptr_offset = sbi_scratch_alloc_type_offset(struct sbi_trace_hart *);
+	if (!trace_ptr_offset)
+		return SBI_ENOMEM;
+
+	sbi_for_each_hartindex(i) {
+		hscratch = sbi_hartindex_to_scratch(i);
+		if (!hscratch)
+			continue;
+
+		th = sbi_zalloc(sizeof(*th));
+		if (!th)
+			return SBI_ENOMEM;
+		trace_set_hart_ptr(hscratch, th);
+	}
+
+	return 0;
+}
@@ -11,19 +11,26 @@
 #include <sbi/riscv_encoding.h>
 #include <sbi/sbi_bitops.h>
 #include <sbi/sbi_console.h>
+#include <sbi/sbi_domain_context.h>
+#include <sbi/sbi_domain_stats.h>
 #include <sbi/sbi_double_trap.h>
 #include <sbi/sbi_ecall.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_hart.h>
+#include <sbi/sbi_hart_protection.h>
 #include <sbi/sbi_illegal_insn.h>
 #include <sbi/sbi_ipi.h>
 #include <sbi/sbi_irqchip.h>
 #include <sbi/sbi_trap_ldst.h>
 #include <sbi/sbi_pmu.h>
+#include <sbi/sbi_residency.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_sse.h>
+#include <sbi/sbi_string.h>
 #include <sbi/sbi_timer.h>
+#include <sbi/sbi_trace.h>
+#include <sbi/sbi_trapstat.h>
 #include <sbi/sbi_trap.h>
 
 static void sbi_trap_error_one(const struct sbi_trap_context *tcntx,
@@ -84,6 +91,9 @@ static void __noreturn sbi_trap_error(const char *msg, int rc,
 	for (tc = tcntx; tc; tc = tc->prev_context)
 		depth++;
 
+	sbi_lprintf("%s: %s (error %d) mcause=0x%lx mepc=0x%lx\n", __func__,
+		    msg, rc, tcntx->trap.cause, tcntx->regs.mepc);
+
 	sbi_printf("\n");
 	sbi_printf("%s: hart%d: trap%d: %s (error %d)\n", __func__,
 		   hartid, depth - 1, msg, rc);
@@ -310,11 +320,19 @@ struct sbi_trap_context *sbi_trap_handler(struct sbi_trap_context *tcntx)
 	const struct sbi_trap_info *trap = &tcntx->trap;
 	struct sbi_trap_regs *regs = &tcntx->regs;
 	ulong mcause = tcntx->trap.cause;
+	u64 start = sbi_trapstat_begin();
+	ulong extid = regs->a7;
+	struct sbi_domain_stats_trap dstats;
+
+	sbi_domain_stats_trap_begin(&dstats);
 
 	/* Update trap context pointer */
 	tcntx->prev_context = sbi_trap_get_context(scratch);
 	sbi_trap_set_context(scratch, tcntx);
 
+	sbi_trace(TRAP_ENTRY, mcause, tcntx->trap.tval);
+	sbi_residency_enter(tcntx);
+
 	if (mcause & MCAUSE_IRQ_MASK) {
 		if (sbi_hart_has_extension(sbi_scratch_thishart_ptr(),
 					   SBI_HART_EXT_SMAIA))
@@ -370,12 +388,93 @@ trap_done:
 	if (rc)
 		sbi_trap_error(msg, rc, tcntx);
 
+	if (sbi_mstatus_prev_mode(regs->mstatus) != PRV_M) {
+		sbi_domain_sched_process();
+		sbi_sse_process_pending_events(regs);
+	}
+
+	sbi_trace(TRAP_EXIT, mcause, regs->mepc);
+	if (sbi_mstatus_prev_mode(regs->mstatus) != PRV_M) {
+		sbi_trace_process();
+		sbi_hart_protection_release_ranges();
+		sbi_domain_stats_trap_end(&dstats, mcause);
+	}
+
+	sbi_trapstat_record(mcause, extid, start);
+	sbi_residency_exit(tcntx);
+
+	sbi_trap_set_context(scratch, tcntx->prev_context);
+	return tcntx;
+}
+
+#ifdef CONFIG_SBI_VECTORED_MTVEC
+/**
+ * Handle interrupt taken through a dedicated vectored mtvec entry
+ *
+ * The interrupt entries of the firmware only save MEPC, MSTATUS and
+ * the registers clobbered by a C call in the trap context, which is
+ * all that the interrupt processing and SSE event injection touch.
+ *
+ * @param tcntx pointer to the partially saved trap context
+ * @param irq interrupt number
+ */
+struct sbi_trap_context *sbi_trap_irq_handler(struct sbi_trap_context *tcntx,
+					      unsigned long irq)
+{
+	int rc = 0;
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct sbi_trap_regs *regs = &tcntx->regs;
+	ulong mcause = MCAUSE_IRQ_MASK | irq;
+	u64 start = sbi_trapstat_begin();
+	struct sbi_domain_stats_trap dstats;
+
+	sbi_domain_stats_trap_begin(&dstats);
+
+	sbi_memset(&tcntx->trap, 0, sizeof(tcntx->trap));
+	tcntx->trap.cause = mcause;
+
+	/* Update trap context pointer */
+	tcntx->prev_context = sbi_trap_get_context(scratch);
+	sbi_trap_set_context(scratch, tcntx);
+
+	sbi_trace(TRAP_ENTRY, mcause, 0);
+	sbi_residency_enter(tcntx);
+
+	switch (irq) {
+	case IRQ_M_TIMER:
+		sbi_timer_process();
+		break;
+	case IRQ_M_SOFT:
+		sbi_ipi_process();
+		break;
+	case IRQ_M_EXT:
+		rc = sbi_irqchip_process();
+		break;
+	default:
+		rc = SBI_ENOENT;
+		break;
+	}
+
+	if (rc)
+		sbi_trap_error("unhandled local interrupt", rc, tcntx);
+
 	if (sbi_mstatus_prev_mode(regs->mstatus) != PRV_M)
 		sbi_sse_process_pending_events(regs);
 
+	sbi_trace(TRAP_EXIT, mcause, regs->mepc);
+	if (sbi_mstatus_prev_mode(regs->mstatus) != PRV_M) {
+		sbi_trace_process();
+		sbi_hart_protection_release_ranges();
+		sbi_domain_stats_trap_end(&dstats, mcause);
+	}
+
+	sbi_trapstat_record(mcause, 0, start);
+	sbi_residency_exit(tcntx);
+
 	sbi_trap_set_context(scratch, tcntx->prev_context);
 	return tcntx;
 }
+#endif
 
 /**
  * Default Resumable NMI (RNMI) handler
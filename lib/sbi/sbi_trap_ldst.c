@@ -10,11 +10,13 @@
 #include <sbi/riscv_asm.h>
 #include <sbi/riscv_encoding.h>
 #include <sbi/riscv_fp.h>
+#include <sbi/sbi_emuprof.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_trap_ldst.h>
 #include <sbi/sbi_trap.h>
 #include <sbi/sbi_unpriv.h>
 #include <sbi/sbi_platform.h>
+#include <sbi/sbi_pmu.h>
 
 /**
  * Load emulator callback:
@@ -79,6 +81,13 @@ static inline bool sbi_trap_tinst_valid(ulong tinst)
 	return tinst == (uint32_t)tinst && (tinst & 0x1);
 }
 
+/*
+ * Emulate a trapped load using the emulator callback.
+ *
+ * Returns the length of the emulated instruction, zero if the trap
+ * was redirected to the lower privilege mode instead, or a negative
+ * error code. sbi_trap_emulate_store() returns the same.
+ */
 static int sbi_trap_emulate_load(struct sbi_trap_context *tcntx,
 				 sbi_trap_ld_emulator emu)
 {
@@ -277,7 +286,7 @@ do_emu:
 epc_fixup:
 	regs->mepc += insn_len;
 
-	return 0;
+	return insn_len;
 }
 
 static int sbi_trap_emulate_store(struct sbi_trap_context *tcntx,
@@ -461,7 +470,42 @@ do_emu:
 
 	regs->mepc += insn_len;
 
-	return 0;
+	return insn_len;
+}
+
+/**
+ * Emulate a misaligned load of at most XLEN bits using one or two
+ * naturally aligned XLEN loads followed by shift and merge.
+ *
+ * The aligned loads may touch bytes outside of the original access
+ * so a fault taken by them is not necessarily the fault of the
+ * original access. Return false in that case and let the caller
+ * retry with smaller loads to find the precise faulting address.
+ */
+static bool sbi_misaligned_ld_aligned(ulong addr, int rlen,
+				      union sbi_ldst_data *out_val)
+{
+	ulong base = addr & ~(sizeof(ulong) - 1);
+	ulong shift = (addr - base) * 8;
+	struct sbi_trap_info uptrap;
+	ulong lo, hi = 0;
+
+	if (shift + rlen * 8 > __riscv_xlen)
+		lo = sbi_load_ulong_pair((const ulong *)base, &hi, &uptrap);
+	else
+		lo = sbi_load_ulong_pair((const ulong *)base, NULL, &uptrap);
+	if (uptrap.cause)
+		return false;
+
+	lo >>= shift;
+	if (shift)
+		lo |= hi << (__riscv_xlen - shift);
+	if (rlen < sizeof(ulong))
+		lo &= (1UL << (rlen * 8)) - 1;
+
+	out_val->data_u64 = 0;
+	out_val->data_ulong = lo;
+	return true;
 }
 
 static int sbi_misaligned_ld_emulator(ulong insn, int rlen, ulong addr,
@@ -472,6 +516,8 @@ static int sbi_misaligned_ld_emulator(ulong insn, int rlen, ulong addr,
 	struct sbi_trap_regs *regs = &tcntx->regs;
 	struct sbi_trap_info uptrap;
 
+	sbi_emuprof_record(orig_trap->cause, regs->mepc, insn);
+
 	if (!rlen) {
 		if (IS_VECTOR_LOAD_STORE(insn))
 			return sbi_misaligned_v_ld_emulator(insn, tcntx);
@@ -483,7 +529,11 @@ static int sbi_misaligned_ld_emulator(ulong insn, int rlen, ulong addr,
 	if (addr != orig_trap->tval)
 		return SBI_EFAIL;
 
-	sbi_load_loop(out_val->data_bytes, addr, rlen, &uptrap);
+	if (rlen <= sizeof(ulong) &&
+	    sbi_misaligned_ld_aligned(addr, rlen, out_val))
+		return rlen;
+
+	sbi_copy_from_lower(out_val->data_bytes, addr, rlen, &uptrap);
 	if (uptrap.cause) {
 		sbi_misaligned_tinst_fixup(orig_trap, &uptrap);
 		return sbi_trap_redirect(regs, &uptrap);
@@ -491,11 +541,6 @@ static int sbi_misaligned_ld_emulator(ulong insn, int rlen, ulong addr,
 	return rlen;
 }
 
-int sbi_misaligned_load_handler(struct sbi_trap_context *tcntx)
-{
-	return sbi_trap_emulate_load(tcntx, sbi_misaligned_ld_emulator);
-}
-
 static int sbi_misaligned_st_emulator(ulong insn, int wlen, ulong addr,
 				      union sbi_ldst_data in_val,
 				      struct sbi_trap_context *tcntx)
@@ -504,6 +549,8 @@ static int sbi_misaligned_st_emulator(ulong insn, int wlen, ulong addr,
 	struct sbi_trap_regs *regs = &tcntx->regs;
 	struct sbi_trap_info uptrap;
 
+	sbi_emuprof_record(orig_trap->cause, regs->mepc, insn);
+
 	if (!wlen) {
 		if (IS_VECTOR_LOAD_STORE(insn))
 			return sbi_misaligned_v_st_emulator(insn, tcntx);
@@ -515,7 +562,17 @@ static int sbi_misaligned_st_emulator(ulong insn, int wlen, ulong addr,
 	if (addr != orig_trap->tval)
 		return SBI_EFAIL;
 
-	sbi_store_loop(in_val.data_bytes, addr, wlen, &uptrap);
+	/*
+	 * Don't use aligned read-modify-write here. It could lose
+	 * concurrent updates made by other HARTs to the bytes around
+	 * the store. Byte stores in a single MPRV window avoid most
+	 * of the cost of per-byte MPRV windows instead.
+	 */
+	if (wlen <= sizeof(ulong))
+		sbi_store_ulong_bytes((u8 *)addr, in_val.data_ulong, wlen,
+				      &uptrap);
+	else
+		sbi_copy_to_lower(addr, in_val.data_bytes, wlen, &uptrap);
 	if (uptrap.cause) {
 		sbi_misaligned_tinst_fixup(orig_trap, &uptrap);
 		return sbi_trap_redirect(regs, &uptrap);
@@ -523,9 +580,181 @@ static int sbi_misaligned_st_emulator(ulong insn, int wlen, ulong addr,
 	return wlen;
 }
 
+#if CONFIG_SBI_MISALIGNED_WINDOW > 0
+/**
+ * Decode a simple integer load/store (byte accesses excluded since
+ * they are never misaligned) and compute its effective address.
+ *
+ * @return access width in bytes or 0 if insn is something else
+ */
+static int sbi_misaligned_window_decode(ulong insn, struct sbi_trap_regs *regs,
+					bool *store, ulong *addr)
+{
+	int prev_xlen = sbi_regs_prev_xlen(regs);
+	ulong base, imm;
+	int len = 0;
+
+	*store = false;
+	if ((insn & INSN_MASK_LH) == INSN_MATCH_LH ||
+	    (insn & INSN_MASK_LHU) == INSN_MATCH_LHU) {
+		len = 2;
+	} else if ((insn & INSN_MASK_LW) == INSN_MATCH_LW) {
+		len = 4;
+	} else if (prev_xlen == 64 &&
+		   ((insn & INSN_MASK_LWU) == INSN_MATCH_LWU)) {
+		len = 4;
+	} else if (prev_xlen == 64 &&
+		   ((insn & INSN_MASK_LD) == INSN_MATCH_LD)) {
+		len = 8;
+	}
+	if (len) {
+		base = GET_RS1(insn, regs);
+		imm = (ulong)IMM_I(insn);
+		goto done;
+	}
+
+	if ((insn & INSN_MASK_SH) == INSN_MATCH_SH) {
+		len = 2;
+	} else if ((insn & INSN_MASK_SW) == INSN_MATCH_SW) {
+		len = 4;
+	} else if (prev_xlen == 64 &&
+		   ((insn & INSN_MASK_SD) == INSN_MATCH_SD)) {
+		len = 8;
+	}
+	if (len) {
+		*store = true;
+		base = GET_RS1(insn, regs);
+		imm = (ulong)IMM_S(insn);
+		goto done;
+	}
+
+	/* Zca: c.lw, c.sw, c.lwsp, c.swsp and on RV64 c.ld, c.sd, c.ldsp, c.sdsp */
+	if ((insn & INSN_MASK_C_LW) == INSN_MATCH_C_LW) {
+		len = 4;
+		base = GET_RS1S(insn, regs);
+		imm = RVC_LW_IMM(insn);
+	} else if ((insn & INSN_MASK_C_SW) == INSN_MATCH_C_SW) {
+		len = 4;
+		*store = true;
+		base = GET_RS1S(insn, regs);
+		imm = RVC_SW_IMM(insn);
+	} else if ((insn & INSN_MASK_C_LWSP) == INSN_MATCH_C_LWSP &&
+		   GET_RD_NUM(insn)) {
+		len = 4;
+		base = REG_VAL(2, regs);
+		imm = RVC_LWSP_IMM(insn);
+	} else if ((insn & INSN_MASK_C_SWSP) == INSN_MATCH_C_SWSP) {
+		len = 4;
+		*store = true;
+		base = REG_VAL(2, regs);
+		imm = RVC_SWSP_IMM(insn);
+	} else if (prev_xlen != 64) {
+		return 0;
+	} else if ((insn & INSN_MASK_C_LD) == INSN_MATCH_C_LD) {
+		len = 8;
+		base = GET_RS1S(insn, regs);
+		imm = RVC_LD_IMM(insn);
+	} else if ((insn & INSN_MASK_C_SD) == INSN_MATCH_C_SD) {
+		len = 8;
+		*store = true;
+		base = GET_RS1S(insn, regs);
+		imm = RVC_SD_IMM(insn);
+	} else if ((insn & INSN_MASK_C_LDSP) == INSN_MATCH_C_LDSP &&
+		   GET_RD_NUM(insn)) {
+		len = 8;
+		base = REG_VAL(2, regs);
+		imm = RVC_LDSP_IMM(insn);
+	} else if ((insn & INSN_MASK_C_SDSP) == INSN_MATCH_C_SDSP) {
+		len = 8;
+		*store = true;
+		base = REG_VAL(2, regs);
+		imm = RVC_SDSP_IMM(insn);
+	} else {
+		return 0;
+	}
+
+done:
+	*addr = base + imm;
+	if (prev_xlen == 32)
+		*addr = (u32)*addr;
+
+	return len;
+}
+
+/**
+ * Misaligned accesses tend to come in bursts (e.g. memcpy() on
+ * unaligned buffers), so after emulating the faulting instruction
+ * also emulate the following simple loads/stores as long as they
+ * are misaligned. This saves a full trap round trip for each of
+ * them. Stop at the first instruction which is not a misaligned
+ * load/store or if emulating it redirected a fault to the lower
+ * privilege mode.
+ */
+static int sbi_misaligned_window(struct sbi_trap_context *tcntx)
+{
+	struct sbi_trap_info orig_trap = tcntx->trap, uptrap;
+	struct sbi_trap_regs *regs = &tcntx->regs;
+	ulong insn, addr;
+	int i, len, rc = 0;
+	bool store;
+
+	for (i = 0; i < CONFIG_SBI_MISALIGNED_WINDOW; i++) {
+		insn = sbi_get_insn(regs->mepc, &uptrap);
+		if (uptrap.cause)
+			break;
+
+		len = sbi_misaligned_window_decode(insn, regs, &store, &addr);
+		if (!len || !(addr & (len - 1)))
+			break;
+
+		tcntx->trap.cause = store ? CAUSE_MISALIGNED_STORE :
+					    CAUSE_MISALIGNED_LOAD;
+		tcntx->trap.tval = addr;
+		tcntx->trap.tval2 = 0;
+		tcntx->trap.tinst = 0;
+
+		if (store)
+			rc = sbi_trap_emulate_store(tcntx,
+						    sbi_misaligned_st_emulator);
+		else
+			rc = sbi_trap_emulate_load(tcntx,
+						   sbi_misaligned_ld_emulator);
+		if (rc <= 0)
+			break;
+
+		sbi_pmu_ctr_incr_fw(store ? SBI_PMU_FW_MISALIGNED_STORE_SAVED :
+					    SBI_PMU_FW_MISALIGNED_LOAD_SAVED);
+	}
+
+	tcntx->trap = orig_trap;
+
+	return rc < 0 ? rc : 0;
+}
+#else
+static inline int sbi_misaligned_window(struct sbi_trap_context *tcntx)
+{
+	return 0;
+}
+#endif
+
+int sbi_misaligned_load_handler(struct sbi_trap_context *tcntx)
+{
+	int rc = sbi_trap_emulate_load(tcntx, sbi_misaligned_ld_emulator);
+
+	if (rc <= 0)
+		return rc;
+
+	return sbi_misaligned_window(tcntx);
+}
+
 int sbi_misaligned_store_handler(struct sbi_trap_context *tcntx)
 {
-	return sbi_trap_emulate_store(tcntx, sbi_misaligned_st_emulator);
+	int rc = sbi_trap_emulate_store(tcntx, sbi_misaligned_st_emulator);
+
+	if (rc <= 0)
+		return rc;
+
+	return sbi_misaligned_window(tcntx);
 }
 
 static int sbi_ld_access_emulator(ulong insn, int rlen, ulong addr,
@@ -552,7 +781,9 @@ static int sbi_ld_access_emulator(ulong insn, int rlen, ulong addr,
 
 int sbi_load_access_handler(struct sbi_trap_context *tcntx)
 {
-	return sbi_trap_emulate_load(tcntx, sbi_ld_access_emulator);
+	int rc = sbi_trap_emulate_load(tcntx, sbi_ld_access_emulator);
+
+	return rc < 0 ? rc : 0;
 }
 
 static int sbi_st_access_emulator(ulong insn, int wlen, ulong addr,
@@ -579,5 +810,7 @@ static int sbi_st_access_emulator(ulong insn, int wlen, ulong addr,
 
 int sbi_store_access_handler(struct sbi_trap_context *tcntx)
 {
-	return sbi_trap_emulate_store(tcntx, sbi_st_access_emulator);
+	int rc = sbi_trap_emulate_store(tcntx, sbi_st_access_emulator);
+
+	return rc < 0 ? rc : 0;
 }
@@ -21,6 +21,7 @@
 #ifdef OPENSBI_CC_SUPPORT_VECTOR
 
 #define MASK_BUFFLEN 1024
+#define BOUNCE_BUFFLEN 256
 
 static inline void set_vreg(ulong vlenb, ulong which,
 			    ulong pos, ulong size, const uint8_t *bytes)
@@ -138,6 +139,38 @@ static inline void vsetvl(ulong vl, ulong vtype)
 			:: "r" (vl), "r" (vtype));
 }
 
+/**
+ * Number of elements starting at vstart which can be copied in one go
+ *
+ * Elements of unit-stride accesses without segments are contiguous both
+ * in memory and in the register group, so a run of active elements can
+ * be moved with one bulk copy through the bounce buffer and one vle8/vse8
+ * instead of one round trip per element. Runs stop at the first inactive
+ * element so that masked-off elements are never accessed.
+ */
+static inline ulong sbi_misaligned_v_group_len(ulong vstart, ulong vl,
+					       ulong len, bool masked,
+					       const uint8_t *mask,
+					       ulong mask_len)
+{
+	ulong i, n = BOUNCE_BUFFLEN / len;
+
+	if (vl - vstart < n)
+		n = vl - vstart;
+	if (!masked)
+		return n;
+
+	/* Don't cross the chunk of mask fetched so far */
+	if (mask_len - vstart % mask_len < n)
+		n = mask_len - vstart % mask_len;
+	for (i = 1; i < n; i++) {
+		if (~mask[(vstart + i) % mask_len / 8] & BIT((vstart + i) % 8))
+			break;
+	}
+
+	return i;
+}
+
 /**
  * Handling of misaligned fault is done by a collection of smaller, but
  * aligned load/store(s). Another fault (load/store, page fault...) can
@@ -179,12 +212,14 @@ int sbi_misaligned_v_ld_emulator(ulong insn, struct sbi_trap_context *tcntx)
 	bool illegal = GET_MEW(insn);
 	bool masked = IS_MASKED(insn);
 	uint8_t mask[MASK_BUFFLEN / 8];
-	uint8_t bytes[8 * sizeof(uint64_t)];
+	uint8_t bytes[BOUNCE_BUFFLEN];
 	ulong mask_len = MASK_BUFFLEN < vlenb * 8 ? MASK_BUFFLEN : vlenb * 8;
 	ulong len = GET_LEN(view);
 	ulong nf = GET_NF(insn);
 	ulong vemul = GET_VEMUL(vlmul, view, vsew);
 	ulong emul = GET_EMUL(vemul);
+	ulong copied, n;
+	bool group;
 
 	if (IS_UNIT_STRIDE_LOAD(insn) || IS_FAULT_ONLY_FIRST_LOAD(insn)) {
 		stride = nf * len;
@@ -209,7 +244,10 @@ int sbi_misaligned_v_ld_emulator(ulong insn, struct sbi_trap_context *tcntx)
 		return sbi_trap_redirect(regs, &trap);
 	}
 
+	group = !IS_INDEXED_LOAD(insn) && nf == 1 && stride == len;
+
 	do {
+		n = 1;
 		if (masked) {
 			if (vstart == orig_vstart || vstart % mask_len == 0)
 				/* Fetch a mask_len chunk of mask */
@@ -232,14 +270,27 @@ int sbi_misaligned_v_ld_emulator(ulong insn, struct sbi_trap_context *tcntx)
 
 		csr_write(CSR_VSTART, vstart);
 
-		/* obtain load data from memory */
-		for (ulong seg = 0; seg < nf; seg++) {
-			sbi_load_loop(bytes + seg * len,
-				       addr + seg * len, len, &uptrap);
+		if (group) {
+			n = sbi_misaligned_v_group_len(vstart, vl, len, masked,
+						       mask, mask_len);
 
+			/* obtain load data of a run of elements from memory */
+			copied = sbi_copy_from_lower(bytes, addr, n * len,
+						     &uptrap);
+			n = copied / len;
+			if (n)
+				set_vreg(vlenb, vd, vstart * len, n * len, bytes);
 			if (!uptrap.cause)
 				continue;
 
+			/* Elements before the faulting one are complete */
+			vstart += n;
+		} else {
+			/* obtain load data of all segments from memory */
+			sbi_copy_from_lower(bytes, addr, nf * len, &uptrap);
+		}
+
+		if (uptrap.cause) {
 			if (IS_FAULT_ONLY_FIRST_LOAD(insn) && vstart != 0) {
 				vl = vstart;
 				goto done;
@@ -258,7 +309,7 @@ int sbi_misaligned_v_ld_emulator(ulong insn, struct sbi_trap_context *tcntx)
 		for (ulong seg = 0; seg < nf; seg++)
 			set_vreg(vlenb, vd + seg * emul, vstart * len,
 				 len, &bytes[seg * len]);
-	} while (++vstart < vl);
+	} while ((vstart += n) < vl);
 
 done:
 	/* restore clobbered vl/vtype */
@@ -292,12 +343,14 @@ int sbi_misaligned_v_st_emulator(ulong insn, struct sbi_trap_context *tcntx)
 	bool illegal = GET_MEW(insn);
 	bool masked = IS_MASKED(insn);
 	uint8_t mask[MASK_BUFFLEN / 8];
-	uint8_t bytes[8 * sizeof(uint64_t)];
+	uint8_t bytes[BOUNCE_BUFFLEN];
 	ulong mask_len = MASK_BUFFLEN < vlenb * 8 ? MASK_BUFFLEN : vlenb * 8;
 	ulong len = GET_LEN(view);
 	ulong nf = GET_NF(insn);
 	ulong vemul = GET_VEMUL(vlmul, view, vsew);
 	ulong emul = GET_EMUL(vemul);
+	ulong copied, n;
+	bool group;
 
 	if (IS_UNIT_STRIDE_STORE(insn)) {
 		stride = nf * len;
@@ -322,7 +375,10 @@ int sbi_misaligned_v_st_emulator(ulong insn, struct sbi_trap_context *tcntx)
 		return sbi_trap_redirect(regs, &trap);
 	}
 
+	group = !IS_INDEXED_STORE(insn) && nf == 1 && stride == len;
+
 	do {
+		n = 1;
 		if (masked) {
 			if (vstart == orig_vstart || vstart % mask_len == 0)
 				/* Fetch a mask_len chunk of mask */
@@ -343,19 +399,28 @@ int sbi_misaligned_v_st_emulator(ulong insn, struct sbi_trap_context *tcntx)
 			addr = base + offset;
 		}
 
-		/* obtain store data from regfile */
-		for (ulong seg = 0; seg < nf; seg++)
-			get_vreg(vlenb, vd + seg * emul, vstart * len,
-				 len, &bytes[seg * len]);
-
-		/* write store data to memory */
-		for (ulong seg = 0; seg < nf; seg++) {
-			sbi_store_loop(bytes + seg * len,
-					addr + seg * len, len, &uptrap);
-
-			if (!uptrap.cause)
-				continue;
+		if (group) {
+			n = sbi_misaligned_v_group_len(vstart, vl, len, masked,
+						       mask, mask_len);
+
+			/* write store data of a run of elements to memory */
+			get_vreg(vlenb, vd, vstart * len, n * len, bytes);
+			copied = sbi_copy_to_lower(addr, bytes, n * len, &uptrap);
+
+			/* Elements before the faulting one are complete */
+			if (uptrap.cause)
+				vstart += copied / len;
+		} else {
+			/* obtain store data from regfile */
+			for (ulong seg = 0; seg < nf; seg++)
+				get_vreg(vlenb, vd + seg * emul, vstart * len,
+					 len, &bytes[seg * len]);
+
+			/* write store data of all segments to memory */
+			sbi_copy_to_lower(addr, bytes, nf * len, &uptrap);
+		}
 
+		if (uptrap.cause) {
 			vsetvl(vl, vtype);
 			csr_write(CSR_VSTART, vstart);
 			/* Don't forget to set dirty if vstart has changed */
@@ -364,7 +429,7 @@ int sbi_misaligned_v_st_emulator(ulong insn, struct sbi_trap_context *tcntx)
 			sbi_misaligned_v_tinst_fixup(&uptrap);
 			return sbi_trap_redirect(regs, &uptrap);
 		}
-	} while (++vstart < vl);
+	} while ((vstart += n) < vl);
 
 	/* restore clobbered vl/vtype */
 	vsetvl(vl, vtype); // VSTART resets to 0
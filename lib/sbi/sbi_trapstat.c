@@ -0,0 +1,245 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_bitops.h>
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_trapstat.h>
+
+#define TRAPSTAT_EXC_SLOTS	24
+#define TRAPSTAT_IRQ_SLOTS	16
+#define TRAPSTAT_ECALL_SLOTS	CONFIG_SBI_TRAPSTAT_ECALL_SLOTS
+
+#define TRAPSTAT_IRQ_BASE	TRAPSTAT_EXC_SLOTS
+#define TRAPSTAT_ECALL_BASE	(TRAPSTAT_IRQ_BASE + TRAPSTAT_IRQ_SLOTS)
+#define TRAPSTAT_SLOTS		(TRAPSTAT_ECALL_BASE + TRAPSTAT_ECALL_SLOTS)
+
+/*
+ * Per-HART trap statistics
+ *
+ * Exceptions and interrupts are indexed by cause while ecalls are
+ * looked up by extension ID in a small table. Only the owner HART
+ * updates its statistics so no lock is needed. A reader on another
+ * HART may see an entry which is being updated, which is acceptable
+ * for statistics.
+ */
+struct sbi_trapstat {
+	u64 dropped;
+	u32 nr_ecalls;
+	/* Exceptions, interrupts and then ecalls */
+	struct sbi_trapstat_entry ents[TRAPSTAT_SLOTS];
+};
+
+static unsigned long trapstat_ptr_offset;
+
+#define trapstat_get_hart_ptr(__scratch)				\
+	sbi_scratch_read_type((__scratch), struct sbi_trapstat *,	\
+			      trapstat_ptr_offset)
+
+#define trapstat_set_hart_ptr(__scratch, __ts)				\
+	sbi_scratch_write_type((__scratch), struct sbi_trapstat *,	\
+			       trapstat_ptr_offset, (__ts))
+
+static struct sbi_trapstat_entry *trapstat_ecall_entry(struct sbi_trapstat *ts,
+							unsigned long extid)
+{
+	struct sbi_trapstat_entry *ent = &ts->ents[TRAPSTAT_ECALL_BASE];
+	u32 i;
+
+	for (i = 0; i < ts->nr_ecalls; i++) {
+		if (ent[i].key == extid)
+			return &ent[i];
+	}
+
+	if (ts->nr_ecalls == TRAPSTAT_ECALL_SLOTS)
+		return NULL;
+
+	ent = &ent[ts->nr_ecalls++];
+	ent->key = extid;
+	ent->type = SBI_TRAPSTAT_TYPE_ECALL;
+	return ent;
+}
+
+static void trapstat_account(struct sbi_trapstat_entry *ent, u64 ticks)
+{
+	unsigned long bucket = SBI_TRAPSTAT_BUCKETS - 1;
+
+	if (ticks < BIT(SBI_TRAPSTAT_BUCKETS - 2))
+		bucket = ticks ? sbi_fls(ticks) + 1 : 0;
+
+	ent->count++;
+	ent->total_ticks += ticks;
+	if (ent->max_ticks < ticks)
+		ent->max_ticks = ticks;
+	ent->hist[bucket]++;
+}
+
+void sbi_trapstat_record(unsigned long mcause, unsigned long extid,
+			 u64 start)
+{
+	u64 ticks = sbi_timer_value() - start;
+	struct sbi_trapstat_entry *ent = NULL;
+	struct sbi_trapstat *ts;
+
+	if (!trapstat_ptr_offset)
+		return;
+
+	ts = trapstat_get_hart_ptr(sbi_scratch_thishart_ptr());
+	if (!ts)
+		return;
+
+	if (mcause & MCAUSE_IRQ_MASK) {
+		mcause &= ~MCAUSE_IRQ_MASK;
+		if (mcause < TRAPSTAT_IRQ_SLOTS)
+			ent = &ts->ents[TRAPSTAT_IRQ_BASE + mcause];
+	} else if (mcause < TRAPSTAT_EXC_SLOTS) {
+		ent = &ts->ents[mcause];
+	}
+	if (ent)
+		trapstat_account(ent, ticks);
+
+	if (mcause == CAUSE_SUPERVISOR_ECALL || mcause == CAUSE_MACHINE_ECALL) {
+		ent = trapstat_ecall_entry(ts, extid);
+		if (ent)
+			trapstat_account(ent, ticks);
+		else
+			ts->dropped++;
+	}
+}
+
+static struct sbi_trapstat *trapstat_hart_ptr(u32 hartindex)
+{
+	struct sbi_scratch *scratch;
+
+	if (!trapstat_ptr_offset)
+		return NULL;
+
+	scratch = sbi_hartindex_to_scratch(hartindex);
+	if (!scratch)
+		return NULL;
+
+	return trapstat_get_hart_ptr(scratch);
+}
+
+static void trapstat_reset(struct sbi_trapstat *ts)
+{
+	u32 i;
+
+	sbi_memset(ts, 0, sizeof(*ts));
+	for (i = 0; i < TRAPSTAT_EXC_SLOTS; i++) {
+		ts->ents[i].key = i;
+		ts->ents[i].type = SBI_TRAPSTAT_TYPE_EXCEPTION;
+	}
+	for (i = 0; i < TRAPSTAT_IRQ_SLOTS; i++) {
+		ts->ents[TRAPSTAT_IRQ_BASE + i].key = i;
+		ts->ents[TRAPSTAT_IRQ_BASE + i].type = SBI_TRAPSTAT_TYPE_INTERRUPT;
+	}
+}
+
+unsigned long sbi_trapstat_read(u32 hartindex, unsigned long flags,
+				void *out, unsigned long size)
+{
+	struct sbi_trapstat *ts = trapstat_hart_ptr(hartindex);
+	struct sbi_trapstat_header *hdr = out;
+	struct sbi_trapstat_entry *dst;
+	unsigned long i, nr, max, count = 0;
+
+	if (!ts || size < sizeof(*hdr))
+		return 0;
+
+	nr = TRAPSTAT_ECALL_BASE + ts->nr_ecalls;
+	dst = (struct sbi_trapstat_entry *)(hdr + 1);
+	max = (size - sizeof(*hdr)) / sizeof(*dst);
+	for (i = 0; i < nr && count < max; i++) {
+		if (!ts->ents[i].count)
+			continue;
+		sbi_memcpy(&dst[count++], &ts->ents[i], sizeof(*dst));
+	}
+
+	hdr->dropped = ts->dropped;
+	hdr->nr_entries = count;
+	hdr->hartid = sbi_hartindex_to_hartid(hartindex);
+
+	if (flags & SBI_TRAPSTAT_READ_RESET)
+		trapstat_reset(ts);
+
+	return count;
+}
+
+static const char *const trapstat_type_names[] = {
+	[SBI_TRAPSTAT_TYPE_EXCEPTION]	= "exception",
+	[SBI_TRAPSTAT_TYPE_INTERRUPT]	= "interrupt",
+	[SBI_TRAPSTAT_TYPE_ECALL]	= "ecall",
+};
+
+void sbi_trapstat_dump(u32 hartindex)
+{
+	struct sbi_trapstat *ts = trapstat_hart_ptr(hartindex);
+	struct sbi_trapstat_entry *ent;
+	unsigned long i, b, nr;
+
+	if (!ts)
+		return;
+
+	sbi_printf("HART%u trap statistics (timer ticks):\n",
+		   sbi_hartindex_to_hartid(hartindex));
+	sbi_printf("%-10s %-10s %12s %12s %12s\n",
+		   "type", "key", "count", "average", "worst");
+
+	nr = TRAPSTAT_ECALL_BASE + ts->nr_ecalls;
+	for (i = 0; i < nr; i++) {
+		ent = &ts->ents[i];
+		if (!ent->count)
+			continue;
+
+		sbi_printf("%-10s 0x%08lx %12lu %12lu %12lu\n",
+			   trapstat_type_names[ent->type], (ulong)ent->key,
+			   (ulong)ent->count,
+			   (ulong)(ent->total_ticks / ent->count),
+			   (ulong)ent->max_ticks);
+		sbi_printf("%-10s histogram:", "");
+		for (b = 0; b < SBI_TRAPSTAT_BUCKETS; b++)
+			sbi_printf(" %u", ent->hist[b]);
+		sbi_printf("\n");
+	}
+
+	if (ts->dropped)
+		sbi_printf("%lu ecalls not accounted\n", (ulong)ts->dropped);
+}
+
+unsigned long sbi_trapstat_heap_size(u32 hart_count)
+{
+	return sizeof(struct sbi_trapstat) * hart_count;
+}
+
+int sbi_trapstat_init(struct sbi_scratch *scratch)
+{
+	struct sbi_scratch *hscratch;
+	struct sbi_trapstat *ts;
+
+	trapstat_ptr_offset = sbi_scratch_alloc_type_offset(struct sbi_trapstat *);
+	if (!trapstat_ptr_offset)
+		return SBI_ENOMEM;
+
+	sbi_for_each_hartindex(i) {
+		hscratch = sbi_hartindex_to_scratch(i);
+		if (!hscratch)
+			continue;
+
+		ts = sbi_malloc(sizeof(*ts));
+		if (!ts)
+			return SBI_ENOMEM;
+		trapstat_reset(ts);
+		trapstat_set_hart_ptr(hscratch, ts);
+	}
+
+	return 0;
+}
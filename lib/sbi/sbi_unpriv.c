@@ -7,6 +7,7 @@
  *   Anup Patel <anup.patel@wdc.com>
  */
 
+#include <sbi/riscv_asm.h>
 #include <sbi/riscv_encoding.h>
 #include <sbi/sbi_bitops.h>
 #include <sbi/sbi_hart.h>
@@ -15,16 +16,6 @@
 #include <sbi/sbi_trap.h>
 #include <sbi/sbi_unpriv.h>
 
-union sbi_unpriv_data {
-	u8 b;
-	u16 h;
-	u32 w;
-#if __riscv_xlen == 64
-	u64 d;
-#endif
-	u8 bytes[__riscv_xlen / 8];
-};
-
 /**
  * a3 must a pointer to the sbi_trap_info and a4 is used as a temporary
  * register in the trap handler. Make sure that compiler doesn't use a3 & a4.
@@ -124,82 +115,205 @@ void sbi_store_u64(u64 *addr, u64 val,
 # error "Unexpected __riscv_xlen"
 #endif
 
-void sbi_load_loop(u8 *buffer, ulong addr, ulong len,
-		   struct sbi_trap_info *trap)
+/*
+ * The copy loops below install the expected trap handler once for
+ * the whole buffer. MPRV is only set around the lower privilege mode
+ * accesses since it also applies to the accesses of the M-mode side
+ * of the copy. Naturally aligned XLEN words are used when both sides
+ * are aligned, bytes otherwise. The expected trap handler writes a
+ * non-zero value to a4 which ends the loop at the faulting access.
+ */
+ulong sbi_copy_from_lower(void *dst, ulong src, ulong len,
+			  struct sbi_trap_info *trap)
 {
-	union sbi_unpriv_data data;
+	register ulong tinfo asm("a3") = (ulong)trap;
+	register ulong ttmp asm("a4") = 0;
+	register ulong mtvec = (ulong)sbi_hart_expected_trap;
+	ulong mstatus, data, tmp, left = len;
+	ulong to = (ulong)dst;
 
 	trap->cause = 0;
-	while (len) {
-		unsigned int width = __riscv_xlen / 8;
-		void *ptr = (void*)addr;
-
-		while (len < width || (addr & (width - 1)))
-			width /= 2;
-
-		switch (width) {
-		case 1:
-			data.b = sbi_load_u8(ptr, trap);
-			break;
-		case 2:
-			data.h = sbi_load_u16(ptr, trap);
-			break;
-		case 4:
-			data.w = sbi_load_u32(ptr, trap);
-			break;
-#if __riscv_xlen == 64
-		case 8:
-			data.d = sbi_load_u64(ptr, trap);
-			break;
-#endif
-		}
-		if (trap->cause)
-			return;
-
-		sbi_memcpy(buffer, data.bytes, width);
-		len -= width;
-		addr += width;
-		buffer += width;
-	}
+	if (!len)
+		return 0;
+
+	asm volatile(
+	    "csrr %[mstatus], " STR(CSR_MSTATUS) "\n"
+	    "csrrw %[mtvec], " STR(CSR_MTVEC) ", %[mtvec]\n"
+	    ".option push\n"
+	    ".option norvc\n"
+	    "1: or %[tmp], %[src], %[to]\n"
+	    "andi %[tmp], %[tmp], " SZREG " - 1\n"
+	    "bne %[tmp], zero, 2f\n"
+	    "sltiu %[tmp], %[left], " SZREG "\n"
+	    "bne %[tmp], zero, 2f\n"
+	    "csrs " STR(CSR_MSTATUS) ", %[mprv]\n"
+	    REG_L " %[data], 0(%[src])\n"
+	    "csrc " STR(CSR_MSTATUS) ", %[mprv]\n"
+	    "bne %[ttmp], zero, 3f\n"
+	    REG_S " %[data], 0(%[to])\n"
+	    "addi %[src], %[src], " SZREG "\n"
+	    "addi %[to], %[to], " SZREG "\n"
+	    "addi %[left], %[left], -" SZREG "\n"
+	    "bne %[left], zero, 1b\n"
+	    "j 3f\n"
+	    "2: csrs " STR(CSR_MSTATUS) ", %[mprv]\n"
+	    "lbu %[data], 0(%[src])\n"
+	    "csrc " STR(CSR_MSTATUS) ", %[mprv]\n"
+	    "bne %[ttmp], zero, 3f\n"
+	    "sb %[data], 0(%[to])\n"
+	    "addi %[src], %[src], 1\n"
+	    "addi %[to], %[to], 1\n"
+	    "addi %[left], %[left], -1\n"
+	    "bne %[left], zero, 1b\n"
+	    "3:\n"
+	    ".option pop\n"
+	    "csrw " STR(CSR_MSTATUS) ", %[mstatus]\n"
+	    "csrw " STR(CSR_MTVEC) ", %[mtvec]"
+	    : [mstatus] "=&r"(mstatus), [mtvec] "+&r"(mtvec),
+	      [tinfo] "+&r"(tinfo), [ttmp] "+&r"(ttmp),
+	      [data] "=&r"(data), [tmp] "=&r"(tmp),
+	      [src] "+&r"(src), [to] "+&r"(to), [left] "+&r"(left)
+	    : [mprv] "r"(MSTATUS_MPRV)
+	    : "memory");
+
+	return len - left;
 }
 
-void sbi_store_loop(u8 *buffer, ulong addr, ulong len,
-		    struct sbi_trap_info *trap)
+ulong sbi_copy_to_lower(ulong dst, const void *src, ulong len,
+			struct sbi_trap_info *trap)
 {
-	union sbi_unpriv_data data;
+	register ulong tinfo asm("a3") = (ulong)trap;
+	register ulong ttmp asm("a4") = 0;
+	register ulong mtvec = (ulong)sbi_hart_expected_trap;
+	ulong mstatus, data, tmp, left = len;
+	ulong from = (ulong)src;
 
 	trap->cause = 0;
-	while (len) {
-		unsigned int width = __riscv_xlen / 8;
-		void *ptr = (void*)addr;
-
-		while (len < width || (addr & (width - 1)))
-			width /= 2;
-
-		sbi_memcpy(data.bytes, buffer, width);
-		switch (width) {
-		case 1:
-			sbi_store_u8(ptr, data.b, trap);
-			break;
-		case 2:
-			sbi_store_u16(ptr, data.h, trap);
-			break;
-		case 4:
-			sbi_store_u32(ptr, data.w, trap);
-			break;
-#if __riscv_xlen == 64
-		case 8:
-			sbi_store_u64(ptr, data.d, trap);
-			break;
-#endif
-		}
-		if (trap->cause)
-			return;
+	if (!len)
+		return 0;
 
-		len -= width;
-		addr += width;
-		buffer += width;
-	}
+	asm volatile(
+	    "csrr %[mstatus], " STR(CSR_MSTATUS) "\n"
+	    "csrrw %[mtvec], " STR(CSR_MTVEC) ", %[mtvec]\n"
+	    ".option push\n"
+	    ".option norvc\n"
+	    "1: or %[tmp], %[from], %[dst]\n"
+	    "andi %[tmp], %[tmp], " SZREG " - 1\n"
+	    "bne %[tmp], zero, 2f\n"
+	    "sltiu %[tmp], %[left], " SZREG "\n"
+	    "bne %[tmp], zero, 2f\n"
+	    REG_L " %[data], 0(%[from])\n"
+	    "csrs " STR(CSR_MSTATUS) ", %[mprv]\n"
+	    REG_S " %[data], 0(%[dst])\n"
+	    "csrc " STR(CSR_MSTATUS) ", %[mprv]\n"
+	    "bne %[ttmp], zero, 3f\n"
+	    "addi %[from], %[from], " SZREG "\n"
+	    "addi %[dst], %[dst], " SZREG "\n"
+	    "addi %[left], %[left], -" SZREG "\n"
+	    "bne %[left], zero, 1b\n"
+	    "j 3f\n"
+	    "2: lbu %[data], 0(%[from])\n"
+	    "csrs " STR(CSR_MSTATUS) ", %[mprv]\n"
+	    "sb %[data], 0(%[dst])\n"
+	    "csrc " STR(CSR_MSTATUS) ", %[mprv]\n"
+	    "bne %[ttmp], zero, 3f\n"
+	    "addi %[from], %[from], 1\n"
+	    "addi %[dst], %[dst], 1\n"
+	    "addi %[left], %[left], -1\n"
+	    "bne %[left], zero, 1b\n"
+	    "3:\n"
+	    ".option pop\n"
+	    "csrw " STR(CSR_MSTATUS) ", %[mstatus]\n"
+	    "csrw " STR(CSR_MTVEC) ", %[mtvec]"
+	    : [mstatus] "=&r"(mstatus), [mtvec] "+&r"(mtvec),
+	      [tinfo] "+&r"(tinfo), [ttmp] "+&r"(ttmp),
+	      [data] "=&r"(data), [tmp] "=&r"(tmp),
+	      [from] "+&r"(from), [dst] "+&r"(dst), [left] "+&r"(left)
+	    : [mprv] "r"(MSTATUS_MPRV)
+	    : "memory");
+
+	return len - left;
+}
+
+/**
+ * Load one or two consecutive naturally aligned XLEN words using a
+ * single MPRV window. The expected trap handler writes a non-zero
+ * value to a4 so the second load is skipped if the first one faults.
+ */
+ulong sbi_load_ulong_pair(const ulong *addr, ulong *hi,
+			  struct sbi_trap_info *trap)
+{
+	register ulong tinfo asm("a3") = (ulong)trap;
+	register ulong ttmp asm("a4") = 0;
+	register ulong mstatus = 0;
+	register ulong mtvec = (ulong)sbi_hart_expected_trap;
+	ulong lo = 0, hi_val = 0;
+
+	trap->cause = 0;
+
+	asm volatile(
+	    "csrrw %[mtvec], " STR(CSR_MTVEC) ", %[mtvec]\n"
+	    "csrrs %[mstatus], " STR(CSR_MSTATUS) ", %[mprv]\n"
+	    ".option push\n"
+	    ".option norvc\n"
+	    REG_L " %[lo], 0(%[addr])\n"
+	    "bne %[ttmp], zero, 2f\n"
+	    "beq %[two], zero, 2f\n"
+	    REG_L " %[hi], " SZREG "(%[addr])\n"
+	    "2:\n"
+	    ".option pop\n"
+	    "csrw " STR(CSR_MSTATUS) ", %[mstatus]\n"
+	    "csrw " STR(CSR_MTVEC) ", %[mtvec]"
+	    : [mstatus] "+&r"(mstatus), [mtvec] "+&r"(mtvec),
+	      [tinfo] "+&r"(tinfo), [ttmp] "+&r"(ttmp),
+	      [lo] "=&r"(lo), [hi] "=&r"(hi_val)
+	    : [addr] "r"(addr), [two] "r"(hi != NULL),
+	      [mprv] "r"(MSTATUS_MPRV)
+	    : "memory");
+
+	if (hi)
+		*hi = hi_val;
+
+	return lo;
+}
+
+/**
+ * Store the low len bytes of val byte by byte using a single MPRV
+ * window. Stops at the first faulting byte, leaving the bytes before
+ * it written, like a sequence of byte stores would.
+ */
+void sbi_store_ulong_bytes(u8 *addr, ulong val, ulong len,
+			   struct sbi_trap_info *trap)
+{
+	register ulong tinfo asm("a3") = (ulong)trap;
+	register ulong ttmp asm("a4") = 0;
+	register ulong mstatus = 0;
+	register ulong mtvec = (ulong)sbi_hart_expected_trap;
+
+	trap->cause = 0;
+	if (!len)
+		return;
+
+	asm volatile(
+	    "csrrw %[mtvec], " STR(CSR_MTVEC) ", %[mtvec]\n"
+	    "csrrs %[mstatus], " STR(CSR_MSTATUS) ", %[mprv]\n"
+	    ".option push\n"
+	    ".option norvc\n"
+	    "1: sb %[val], 0(%[addr])\n"
+	    "bne %[ttmp], zero, 2f\n"
+	    "srli %[val], %[val], 8\n"
+	    "addi %[addr], %[addr], 1\n"
+	    "addi %[len], %[len], -1\n"
+	    "bne %[len], zero, 1b\n"
+	    "2:\n"
+	    ".option pop\n"
+	    "csrw " STR(CSR_MSTATUS) ", %[mstatus]\n"
+	    "csrw " STR(CSR_MTVEC) ", %[mtvec]"
+	    : [mstatus] "+&r"(mstatus), [mtvec] "+&r"(mtvec),
+	      [tinfo] "+&r"(tinfo), [ttmp] "+&r"(ttmp),
+	      [addr] "+&r"(addr), [val] "+&r"(val), [len] "+&r"(len)
+	    : [mprv] "r"(MSTATUS_MPRV)
+	    : "memory");
 }
 
 ulong sbi_get_insn(ulong mepc, struct sbi_trap_info *trap)
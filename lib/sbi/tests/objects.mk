@@ -25,6 +25,17 @@ libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_bitops_test.o
 carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += string_test_suite
 libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_string_test.o
 
+carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += domain_test_suite
+libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_domain_test.o
+
+carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += hart_pmp_test_suite
+libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_hart_pmp_test.o
+
+ifeq ($(CONFIG_SBI_RESIDENCY),y)
+carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += residency_test_suite
+libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_residency_test.o
+endif
+
 ifeq ($(UBSAN),y)
 carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += ubsan_test_suite
 libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_ubsan_test.o
@@ -5,19 +5,25 @@
  */
 #include <sbi/riscv_locks.h>
 #include <sbi/sbi_console.h>
+#include <sbi/sbi_timer.h>
 #include <sbi/sbi_unit_test.h>
 
 #define TEST_CONSOLE_BUF_LEN 1024
+#define TEST_CONSOLE_BENCH_ITERS 256
 
 static const struct sbi_console_device *old_dev;
 static char test_console_buf[TEST_CONSOLE_BUF_LEN];
 static u32 test_console_buf_pos;
+/* Characters written to the test console, not counting '\r' */
+static u32 test_console_count;
 static spinlock_t test_console_lock = SPIN_LOCK_INITIALIZER;
 
 static void test_console_putc(char c)
 {
 	test_console_buf[test_console_buf_pos] = c;
 	test_console_buf_pos = (test_console_buf_pos + 1) % TEST_CONSOLE_BUF_LEN;
+	if (c != '\r')
+		test_console_count++;
 }
 
 static void clear_test_console_buf(void)
@@ -95,12 +101,64 @@ static void printf_test(struct sbiunit_test_case *test)
 	PRINTF_TEST(test, "-2147483647", "%ld", -2147483647l);
 	PRINTF_TEST(test, "-9223372036854775807", "%lld", -9223372036854775807LL);
 	PRINTF_TEST(test, "18446744073709551615", "%llu", 18446744073709551615ULL);
+	PRINTF_TEST(test, "0 9 10 99 100 1000", "%d %d %d %d %d %d",
+		    0, 9, 10, 99, 100, 1000);
+	PRINTF_TEST(test, "-10 +7", "%d %+d", -10, 7);
+	PRINTF_TEST(test, "00042|42   |   42", "%05d|%-5d|%5d", 42, 42, 42);
+	PRINTF_TEST(test, "0 17 0x1f 0X1F", "%o %o %#x %#X", 0, 15, 31, 31);
+	PRINTF_TEST(test, "0xdeadbeef", "0x%08lx", 0xdeadbeefUL);
+}
+
+static void printf_long_test(struct sbiunit_test_case *test)
+{
+	char expected[TEST_CONSOLE_BUF_LEN / 2];
+	char str[TEST_CONSOLE_BUF_LEN / 4];
+	u32 i;
+
+	/* Output longer than the console formatting buffer */
+	for (i = 0; i < sizeof(str) - 1; i++)
+		str[i] = 'a' + (i % 26);
+	str[i] = '\0';
+	sbi_sprintf(expected, "%s|%s", str, str);
+
+	PRINTF_TEST(test, expected, "%s|%s", str, str);
+}
+
+#define TEST_CONSOLE_BENCH_FMT "%s: %d 0x%lx %lu\n"
+
+static void printf_bench_test(struct sbiunit_test_case *test)
+{
+	u32 i, len = 0;
+	u64 start, end;
+
+	for (i = 0; i < TEST_CONSOLE_BENCH_ITERS; i++)
+		len += sbi_snprintf(NULL, 0, TEST_CONSOLE_BENCH_FMT,
+				    __func__, i, -1UL, -1UL);
+
+	spin_lock(&test_console_lock);
+	clear_test_console_buf();
+	test_console_count = 0;
+	test_console_begin(&test_console_dev);
+	start = sbi_timer_value();
+	for (i = 0; i < TEST_CONSOLE_BENCH_ITERS; i++)
+		sbi_printf(TEST_CONSOLE_BENCH_FMT, __func__, i, -1UL, -1UL);
+	end = sbi_timer_value();
+	test_console_end();
+	spin_unlock(&test_console_lock);
+
+	/* All output reached the console and nothing else did */
+	SBIUNIT_EXPECT_EQ(test, test_console_count, len);
+
+	sbi_printf("[SBIUnit] %s: %u sbi_printf() calls took %lu timer ticks\n",
+		   test->name, TEST_CONSOLE_BENCH_ITERS, (ulong)(end - start));
 }
 
 static struct sbiunit_test_case console_test_cases[] = {
 	SBIUNIT_TEST_CASE(putc_test),
 	SBIUNIT_TEST_CASE(puts_test),
 	SBIUNIT_TEST_CASE(printf_test),
+	SBIUNIT_TEST_CASE(printf_long_test),
+	SBIUNIT_TEST_CASE(printf_bench_test),
 	SBIUNIT_END_CASE,
 };
 
@@ -0,0 +1,148 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_unit_test.h>
+
+static const unsigned long domain_test_access[] = {
+	SBI_DOMAIN_READ,
+	SBI_DOMAIN_WRITE,
+	SBI_DOMAIN_EXECUTE,
+	SBI_DOMAIN_READ | SBI_DOMAIN_WRITE,
+	SBI_DOMAIN_READ | SBI_DOMAIN_MMIO,
+};
+
+/* Reference lookup walking the sorted regions like the unindexed path */
+static bool domain_test_check_linear(const struct sbi_domain *dom,
+				     unsigned long addr, unsigned long mode,
+				     unsigned long access_flags)
+{
+	const struct sbi_domain_memregion *reg;
+	unsigned long rend, rwx = 0, rrwx;
+
+	if (access_flags & SBI_DOMAIN_READ)
+		rwx |= SBI_DOMAIN_MEMREGION_M_READABLE;
+	if (access_flags & SBI_DOMAIN_WRITE)
+		rwx |= SBI_DOMAIN_MEMREGION_M_WRITABLE;
+	if (access_flags & SBI_DOMAIN_EXECUTE)
+		rwx |= SBI_DOMAIN_MEMREGION_M_EXECUTABLE;
+
+	sbi_domain_for_each_memregion(dom, reg) {
+		rend = (reg->order < __riscv_xlen) ?
+			reg->base + ((1UL << reg->order) - 1) : -1UL;
+		if (addr < reg->base || rend < addr)
+			continue;
+
+		if (!(access_flags & SBI_DOMAIN_MMIO) &&
+		    (reg->flags & SBI_DOMAIN_MEMREGION_MMIO))
+			return false;
+
+		rrwx = (mode == PRV_M) ?
+			(reg->flags & SBI_DOMAIN_MEMREGION_M_ACCESS_MASK) :
+			((reg->flags & SBI_DOMAIN_MEMREGION_SU_ACCESS_MASK) >>
+			 SBI_DOMAIN_MEMREGION_SU_ACCESS_SHIFT);
+		return (rrwx & rwx) == rwx;
+	}
+
+	return mode == PRV_M;
+}
+
+static void domain_test_probe(struct sbiunit_test_case *test,
+			      const struct sbi_domain *dom, unsigned long addr)
+{
+	unsigned long mode;
+	int i;
+
+	for (mode = PRV_U; mode <= PRV_M; mode++) {
+		if (mode == PRV_S + 1)
+			continue;
+		for (i = 0; i < array_size(domain_test_access); i++)
+			SBIUNIT_EXPECT_EQ(test,
+				sbi_domain_check_addr(dom, addr, mode,
+						      domain_test_access[i]),
+				domain_test_check_linear(dom, addr, mode,
+						      domain_test_access[i]));
+	}
+}
+
+static void domain_memindex_sorted_test(struct sbiunit_test_case *test)
+{
+	const struct sbi_domain_memindex *idx;
+	struct sbi_domain *dom;
+	u32 i;
+
+	sbi_domain_for_each(dom) {
+		SBIUNIT_ASSERT(test, dom->memindex != NULL);
+		SBIUNIT_EXPECT(test, 0 < dom->memindex_count);
+		for (i = 0; i < dom->memindex_count; i++) {
+			idx = &dom->memindex[i];
+			SBIUNIT_EXPECT(test, idx->start <= idx->end);
+			if (i)
+				SBIUNIT_EXPECT(test, idx[-1].end < idx->start);
+		}
+	}
+}
+
+static void domain_memindex_lookup_test(struct sbiunit_test_case *test)
+{
+	const struct sbi_domain_memregion *reg;
+	struct sbi_domain *dom;
+	unsigned long end;
+
+	/* Probe around every region boundary */
+	sbi_domain_for_each(dom) {
+		sbi_domain_for_each_memregion(dom, reg) {
+			end = (reg->order < __riscv_xlen) ?
+				reg->base + ((1UL << reg->order) - 1) : -1UL;
+			domain_test_probe(test, dom, reg->base - 1);
+			domain_test_probe(test, dom, reg->base);
+			domain_test_probe(test, dom, end);
+			domain_test_probe(test, dom, end + 1);
+		}
+	}
+}
+
+static void domain_memindex_range_test(struct sbiunit_test_case *test)
+{
+	const struct sbi_domain_memindex *idx;
+	struct sbi_domain *dom;
+	unsigned long size;
+	u32 i;
+
+	sbi_domain_for_each(dom) {
+		for (i = 0; i < dom->memindex_count; i++) {
+			idx = &dom->memindex[i];
+			size = idx->end - idx->start + 1;
+			if (!size)
+				continue;
+
+			/* A whole interval has the permissions of its start */
+			SBIUNIT_EXPECT_EQ(test,
+				sbi_domain_check_addr_range(dom, idx->start,
+						size, PRV_S, SBI_DOMAIN_READ),
+				sbi_domain_check_addr(dom, idx->start, PRV_S,
+						      SBI_DOMAIN_READ));
+
+			/* Ranges running into a gap are never allowed */
+			if (idx->end != -1UL &&
+			    (i + 1 == dom->memindex_count ||
+			     idx[1].start != idx->end + 1))
+				SBIUNIT_EXPECT(test,
+					!sbi_domain_check_addr_range(dom,
+						idx->start, size + 1, PRV_M,
+						SBI_DOMAIN_READ));
+		}
+	}
+}
+
+static struct sbiunit_test_case domain_test_cases[] = {
+	SBIUNIT_TEST_CASE(domain_memindex_sorted_test),
+	SBIUNIT_TEST_CASE(domain_memindex_lookup_test),
+	SBIUNIT_TEST_CASE(domain_memindex_range_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(domain_test_suite, domain_test_cases);
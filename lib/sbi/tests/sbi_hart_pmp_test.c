@@ -0,0 +1,169 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_hart_pmp.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_unit_test.h>
+
+#define PMP_TEST_M_RX		(SBI_DOMAIN_MEMREGION_M_READABLE | \
+				 SBI_DOMAIN_MEMREGION_M_EXECUTABLE)
+#define PMP_TEST_SU_RW		(SBI_DOMAIN_MEMREGION_SU_READABLE | \
+				 SBI_DOMAIN_MEMREGION_SU_WRITABLE)
+#define PMP_TEST_SU_RWX		(PMP_TEST_SU_RW | \
+				 SBI_DOMAIN_MEMREGION_SU_EXECUTABLE)
+#define PMP_TEST_TOP(__n)	(-(__n) * (1UL << 20))
+
+/*
+ * Nine regions for eight PMP entries, so the builder has to merge:
+ *  - three M-only regions into a TOR with a disabled bottom entry
+ *  - two SU regions into a TOR starting at the previous TOR top
+ *  - the two lowest regions below the top of the address space into
+ *    a TOR, while the last one must stay NAPOT because a TOR can not
+ *    end at the top of the address space
+ */
+static struct sbi_domain_memregion pmp_test_regions[] = {
+	{ .order = 16, .base = 0x80000000UL, .flags = PMP_TEST_M_RX },
+	{ .order = 16, .base = 0x80010000UL, .flags = PMP_TEST_M_RX },
+	{ .order = 16, .base = 0x80020000UL, .flags = PMP_TEST_M_RX },
+	{ .order = 16, .base = 0x80030000UL, .flags = PMP_TEST_SU_RW },
+	{ .order = 16, .base = 0x80040000UL, .flags = PMP_TEST_SU_RW },
+	{ .order = 20, .base = PMP_TEST_TOP(3),
+	  .flags = SBI_DOMAIN_MEMREGION_SU_READABLE },
+	{ .order = 20, .base = PMP_TEST_TOP(2),
+	  .flags = SBI_DOMAIN_MEMREGION_SU_READABLE },
+	{ .order = 20, .base = PMP_TEST_TOP(1),
+	  .flags = SBI_DOMAIN_MEMREGION_SU_READABLE },
+	{ .order = __riscv_xlen, .base = 0, .flags = PMP_TEST_SU_RWX },
+	{ .order = 0 },
+};
+
+static struct sbi_domain pmp_test_domain = {
+	.name = "pmp-test",
+	.regions = pmp_test_regions,
+};
+
+static struct hart_pmp_image *pmp_test_build(struct sbiunit_test_case *test,
+					     bool smepmp)
+{
+	struct hart_pmp_image *img;
+
+	img = sbi_hart_pmp_test_image(&pmp_test_domain, 8, 12,
+				      __riscv_xlen, smepmp);
+	SBIUNIT_ASSERT(test, img != NULL);
+	return img;
+}
+
+/* Compare the first matching PMP entry with the first containing region */
+static void pmp_test_probe(struct sbiunit_test_case *test,
+			   const struct hart_pmp_image *img, bool smepmp,
+			   unsigned long addr)
+{
+	const unsigned long mask = PMP_L | PMP_R | PMP_W | PMP_X;
+	struct sbi_domain_memregion *reg;
+	unsigned long cfg, end, prot;
+	int n;
+
+	n = sbi_hart_pmp_test_match(img, addr, &cfg);
+
+	sbi_domain_for_each_memregion(&pmp_test_domain, reg) {
+		end = (reg->order < __riscv_xlen) ?
+			reg->base + ((1UL << reg->order) - 1) : -1UL;
+		if (addr < reg->base || end < addr)
+			continue;
+
+		prot = smepmp ? sbi_domain_get_smepmp_flags(reg) :
+				sbi_domain_get_oldpmp_flags(reg);
+		SBIUNIT_EXPECT(test, 0 <= n);
+		SBIUNIT_EXPECT_EQ(test, cfg & mask, prot & mask);
+		break;
+	}
+
+	/* Entry 0 is reserved for the Smepmp shared region */
+	if (smepmp)
+		SBIUNIT_EXPECT_NE(test, n, 0);
+}
+
+static void pmp_test_first_match(struct sbiunit_test_case *test, bool smepmp)
+{
+	struct sbi_domain_memregion *reg;
+	struct hart_pmp_image *img;
+	unsigned long end;
+
+	img = pmp_test_build(test, smepmp);
+
+	sbi_domain_for_each_memregion(&pmp_test_domain, reg) {
+		end = (reg->order < __riscv_xlen) ?
+			reg->base + ((1UL << reg->order) - 1) : -1UL;
+		pmp_test_probe(test, img, smepmp, reg->base - 1);
+		pmp_test_probe(test, img, smepmp, reg->base);
+		pmp_test_probe(test, img, smepmp, end);
+		pmp_test_probe(test, img, smepmp, end + 1);
+	}
+
+	sbi_free(img);
+}
+
+static void hart_pmp_oldpmp_test(struct sbiunit_test_case *test)
+{
+	pmp_test_first_match(test, false);
+}
+
+static void hart_pmp_smepmp_test(struct sbiunit_test_case *test)
+{
+	pmp_test_first_match(test, true);
+}
+
+static void hart_pmp_layout_test(struct sbiunit_test_case *test)
+{
+	struct hart_pmp_image *img;
+	unsigned long cfg;
+	int n, smepmp;
+
+	for (smepmp = 0; smepmp <= 1; smepmp++) {
+		img = pmp_test_build(test, smepmp);
+
+		/* Disabled bottom entry goes after the reserved one */
+		n = sbi_hart_pmp_test_match(img, 0x80000000UL, &cfg);
+		SBIUNIT_EXPECT_EQ(test, n, smepmp + 1);
+		SBIUNIT_EXPECT_EQ(test, cfg & PMP_A, PMP_A_TOR);
+
+		/* The SU TOR reuses the top of the M-only TOR */
+		n = sbi_hart_pmp_test_match(img, 0x80030000UL, &cfg);
+		SBIUNIT_EXPECT_EQ(test, n, smepmp + 2);
+		SBIUNIT_EXPECT_EQ(test, cfg & PMP_A, PMP_A_TOR);
+
+		/* Merged TOR below the top needs its own bottom entry */
+		n = sbi_hart_pmp_test_match(img, PMP_TEST_TOP(3), &cfg);
+		SBIUNIT_EXPECT_EQ(test, n, smepmp + 4);
+		SBIUNIT_EXPECT_EQ(test, cfg & PMP_A, PMP_A_TOR);
+		n = sbi_hart_pmp_test_match(img, PMP_TEST_TOP(1) - 1, &cfg);
+		SBIUNIT_EXPECT_EQ(test, n, smepmp + 4);
+
+		/* The range ending at the top of the address space stays NAPOT */
+		n = sbi_hart_pmp_test_match(img, PMP_TEST_TOP(1), &cfg);
+		SBIUNIT_EXPECT_EQ(test, n, smepmp + 5);
+		SBIUNIT_EXPECT_EQ(test, cfg & PMP_A, PMP_A_NAPOT);
+		SBIUNIT_EXPECT_EQ(test,
+				  sbi_hart_pmp_test_match(img, -1UL, &cfg), n);
+
+		/* Catch-all region in the last entry */
+		n = sbi_hart_pmp_test_match(img, 0, &cfg);
+		SBIUNIT_EXPECT_EQ(test, n, smepmp + 6);
+		SBIUNIT_EXPECT_EQ(test, cfg & PMP_A, PMP_A_NAPOT);
+
+		sbi_free(img);
+	}
+}
+
+static struct sbiunit_test_case hart_pmp_test_cases[] = {
+	SBIUNIT_TEST_CASE(hart_pmp_oldpmp_test),
+	SBIUNIT_TEST_CASE(hart_pmp_smepmp_test),
+	SBIUNIT_TEST_CASE(hart_pmp_layout_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(hart_pmp_test_suite, hart_pmp_test_cases);
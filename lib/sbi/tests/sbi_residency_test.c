@@ -0,0 +1,104 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI Contributors
+ */
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_ecall_interface.h>
+#include <sbi/sbi_residency.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_timer.h>
+#include <sbi/sbi_trap.h>
+#include <sbi/sbi_unit_test.h>
+
+#define TEST_RESIDENCY_MEPC	0x80200000UL
+
+/* Pretend an ecall from S-mode is being handled */
+static void residency_test_context(struct sbi_trap_context *tcntx)
+{
+	sbi_memset(tcntx, 0, sizeof(*tcntx));
+	tcntx->regs.mstatus = (ulong)PRV_S << MSTATUS_MPP_SHIFT;
+	tcntx->regs.mepc = TEST_RESIDENCY_MEPC;
+	tcntx->regs.a7 = SBI_EXT_OPENSBI;
+	tcntx->regs.a6 = SBI_EXT_OPENSBI_RESIDENCY_READ;
+	tcntx->trap.cause = CAUSE_SUPERVISOR_ECALL;
+}
+
+/*
+ * Run one stay on the current HART and read the statistics before and
+ * after it. The statistics are restored afterwards so that the injected
+ * stay is never seen by S-mode.
+ */
+static void residency_test_stay(struct sbiunit_test_case *test,
+				const struct sbi_trap_context *tcntx,
+				ulong delay_us,
+				struct sbi_residency_info *before,
+				struct sbi_residency_info *after)
+{
+	u32 hartindex = current_hartindex();
+
+	SBIUNIT_ASSERT_EQ(test, sbi_residency_get(hartindex, before), 0);
+	sbi_residency_enter(tcntx);
+	/* The delay loop is a residency checkpoint */
+	if (delay_us)
+		sbi_timer_udelay(delay_us);
+	sbi_residency_exit(tcntx);
+	SBIUNIT_ASSERT_EQ(test, sbi_residency_get(hartindex, after), 0);
+	SBIUNIT_ASSERT_EQ(test, sbi_residency_set(hartindex, before), 0);
+}
+
+static void residency_short_stay_test(struct sbiunit_test_case *test)
+{
+	struct sbi_residency_info before, after;
+	struct sbi_trap_context tcntx;
+
+	residency_test_context(&tcntx);
+	residency_test_stay(test, &tcntx, 0, &before, &after);
+
+	SBIUNIT_EXPECT_EQ(test, after.nr_exceeded, before.nr_exceeded);
+}
+
+static void residency_long_stay_test(struct sbiunit_test_case *test)
+{
+	struct sbi_residency_info before, after;
+	struct sbi_trap_context tcntx;
+
+	residency_test_context(&tcntx);
+	residency_test_stay(test, &tcntx, 2 * CONFIG_SBI_RESIDENCY_THRESHOLD_US,
+			    &before, &after);
+
+	SBIUNIT_EXPECT_EQ(test, after.nr_exceeded, before.nr_exceeded + 1);
+	SBIUNIT_EXPECT(test, after.threshold < after.last.duration);
+	SBIUNIT_EXPECT(test, after.last.duration <= after.max_duration);
+	SBIUNIT_EXPECT(test, after.last.duration <= after.worst.duration);
+	SBIUNIT_EXPECT_EQ(test, after.last.mcause, CAUSE_SUPERVISOR_ECALL);
+	SBIUNIT_EXPECT_EQ(test, after.last.mepc, TEST_RESIDENCY_MEPC);
+	SBIUNIT_EXPECT_EQ(test, after.last.extid, SBI_EXT_OPENSBI);
+	SBIUNIT_EXPECT_EQ(test, after.last.fid, SBI_EXT_OPENSBI_RESIDENCY_READ);
+	SBIUNIT_EXPECT(test, 0 < after.last.nr_frames);
+	SBIUNIT_EXPECT(test, after.last.nr_frames <= SBI_RESIDENCY_FRAMES);
+}
+
+static void residency_mmode_trap_test(struct sbiunit_test_case *test)
+{
+	struct sbi_residency_info before, after;
+	struct sbi_trap_context tcntx;
+
+	/* Traps taken from M-mode are part of the enclosing stay */
+	residency_test_context(&tcntx);
+	tcntx.regs.mstatus = (ulong)PRV_M << MSTATUS_MPP_SHIFT;
+	residency_test_stay(test, &tcntx, 2 * CONFIG_SBI_RESIDENCY_THRESHOLD_US,
+			    &before, &after);
+
+	SBIUNIT_EXPECT_EQ(test, after.nr_exceeded, before.nr_exceeded);
+}
+
+static struct sbiunit_test_case residency_test_cases[] = {
+	SBIUNIT_TEST_CASE(residency_short_stay_test),
+	SBIUNIT_TEST_CASE(residency_long_stay_test),
+	SBIUNIT_TEST_CASE(residency_mmode_trap_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(residency_test_suite, residency_test_cases);
@@ -4,9 +4,16 @@
  * Author: Chen Pei <cp0613@linux.alibaba.com>
  */
 
+#include <sbi/sbi_console.h>
 #include <sbi/sbi_string.h>
+#include <sbi/sbi_timer.h>
 #include <sbi/sbi_unit_test.h>
 
+#define TEST_MEM_BUF_SIZE	256
+#define TEST_MEM_MAX_OFFSET	(2 * sizeof(unsigned long))
+#define TEST_MEM_BENCH_SIZE	4096
+#define TEST_MEM_BENCH_ITERS	64
+
 /* Test data for string functions */
 static const char test_str1[] = "Hello, World!";
 static const char test_str2[] = "Hello, World!";
@@ -352,6 +359,181 @@ static void memory_memchr_test(struct sbiunit_test_case *test)
 	SBIUNIT_EXPECT_EQ(test, pos, NULL);
 }
 
+static u8 test_mem_src[TEST_MEM_BUF_SIZE];
+static u8 test_mem_dst[TEST_MEM_BUF_SIZE];
+
+static void test_mem_fill(u8 *buf, size_t size, u8 seed)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++)
+		buf[i] = seed + i * 7;
+}
+
+/* Byte by byte check of dst[doff, doff + len) against src[soff...] */
+static bool test_mem_check(const u8 *dst, size_t doff, const u8 *src,
+			   size_t soff, size_t len, u8 seed)
+{
+	size_t i;
+
+	for (i = 0; i < TEST_MEM_BUF_SIZE; i++) {
+		if (i >= doff && i < doff + len) {
+			if (dst[i] != src[soff + i - doff])
+				return false;
+		} else if (dst[i] != (u8)(seed + i * 7)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void memory_memcpy_align_test(struct sbiunit_test_case *test)
+{
+	size_t soff, doff, len;
+	bool ok = true;
+
+	test_mem_fill(test_mem_src, TEST_MEM_BUF_SIZE, 0x5a);
+	for (soff = 0; soff < TEST_MEM_MAX_OFFSET; soff++) {
+		for (doff = 0; doff < TEST_MEM_MAX_OFFSET; doff++) {
+			for (len = 0; len < 80; len++) {
+				test_mem_fill(test_mem_dst,
+					      TEST_MEM_BUF_SIZE, 0x33);
+				sbi_memcpy(test_mem_dst + doff,
+					   test_mem_src + soff, len);
+				ok &= test_mem_check(test_mem_dst, doff,
+						     test_mem_src, soff,
+						     len, 0x33);
+			}
+		}
+	}
+
+	SBIUNIT_EXPECT(test, ok);
+}
+
+static void memory_memset_align_test(struct sbiunit_test_case *test)
+{
+	size_t off, len, i;
+	bool ok = true;
+
+	for (off = 0; off < TEST_MEM_MAX_OFFSET; off++) {
+		for (len = 0; len < 80; len++) {
+			test_mem_fill(test_mem_dst, TEST_MEM_BUF_SIZE, 0x33);
+			sbi_memset(test_mem_dst + off, 0xa5, len);
+			for (i = 0; i < TEST_MEM_BUF_SIZE; i++) {
+				if (i >= off && i < off + len)
+					ok &= test_mem_dst[i] == 0xa5;
+				else
+					ok &= test_mem_dst[i] == (u8)(0x33 + i * 7);
+			}
+		}
+	}
+
+	SBIUNIT_EXPECT(test, ok);
+}
+
+static void memory_memmove_align_test(struct sbiunit_test_case *test)
+{
+	size_t soff, doff, len;
+	bool ok = true;
+
+	/* Overlapping moves in both directions, all relative alignments */
+	for (soff = 0; soff < 2 * TEST_MEM_MAX_OFFSET; soff++) {
+		for (doff = 0; doff < 2 * TEST_MEM_MAX_OFFSET; doff++) {
+			len = 64 + soff;
+			test_mem_fill(test_mem_src, TEST_MEM_BUF_SIZE, 0x33);
+			test_mem_fill(test_mem_dst, TEST_MEM_BUF_SIZE, 0x33);
+			sbi_memmove(test_mem_dst + doff,
+				    test_mem_dst + soff, len);
+			ok &= test_mem_check(test_mem_dst, doff,
+					     test_mem_src, soff, len, 0x33);
+		}
+	}
+
+	SBIUNIT_EXPECT(test, ok);
+}
+
+static void string_strlen_align_test(struct sbiunit_test_case *test)
+{
+	char *str = (char *)test_mem_dst;
+	size_t off, len;
+	bool ok = true;
+
+	for (off = 0; off < TEST_MEM_MAX_OFFSET; off++) {
+		for (len = 0; len < 40; len++) {
+			sbi_memset(str, 0x80, TEST_MEM_BUF_SIZE);
+			str[off + len] = '\0';
+			ok &= sbi_strlen(str + off) == len;
+			ok &= sbi_strnlen(str + off, len / 2) == len / 2;
+		}
+	}
+
+	SBIUNIT_EXPECT(test, ok);
+}
+
+static void string_strncmp_align_test(struct sbiunit_test_case *test)
+{
+	char *a = (char *)test_mem_src, *b = (char *)test_mem_dst;
+	size_t off, len, diff;
+	bool ok = true;
+
+	for (off = 0; off < TEST_MEM_MAX_OFFSET; off++) {
+		for (len = 1; len < 40; len++) {
+			sbi_memset(a, 'x', TEST_MEM_BUF_SIZE);
+			sbi_memset(b, 'x', TEST_MEM_BUF_SIZE);
+			a[off + len] = '\0';
+			b[off + len] = '\0';
+
+			/* Equal strings, bytes after the NUL must not matter */
+			b[off + len + 1] = 'y';
+			ok &= sbi_strncmp(a + off, b + off, len + 8) == 0;
+
+			/* A difference at every position is found */
+			for (diff = 0; diff < len; diff++) {
+				b[off + diff] = 'y';
+				ok &= sbi_strncmp(a + off, b + off, len) < 0;
+				ok &= sbi_strncmp(a + off, b + off, diff) == 0;
+				b[off + diff] = 'x';
+			}
+		}
+	}
+
+	SBIUNIT_EXPECT(test, ok);
+}
+
+static void memory_bench_test(struct sbiunit_test_case *test)
+{
+	static u8 src[TEST_MEM_BENCH_SIZE], dst[TEST_MEM_BENCH_SIZE];
+	u64 start, copy, set, len;
+	u32 i;
+
+	sbi_memset(src, 'x', sizeof(src) - 1);
+	src[sizeof(src) - 1] = '\0';
+
+	start = sbi_timer_value();
+	for (i = 0; i < TEST_MEM_BENCH_ITERS; i++)
+		sbi_memcpy(dst, src, sizeof(dst));
+	copy = sbi_timer_value() - start;
+
+	start = sbi_timer_value();
+	for (i = 0; i < TEST_MEM_BENCH_ITERS; i++)
+		sbi_memset(dst, i, sizeof(dst));
+	set = sbi_timer_value() - start;
+
+	start = sbi_timer_value();
+	for (i = 0; i < TEST_MEM_BENCH_ITERS; i++)
+		sbi_strlen((const char *)src);
+	len = sbi_timer_value() - start;
+
+	SBIUNIT_EXPECT_EQ(test, sbi_strlen((const char *)src),
+			  (size_t)(TEST_MEM_BENCH_SIZE - 1));
+
+	sbi_printf("[SBIUnit] %s: %u x %u bytes memcpy %lu, memset %lu, "
+		   "strlen %lu timer ticks\n", test->name,
+		   TEST_MEM_BENCH_ITERS, TEST_MEM_BENCH_SIZE,
+		   (ulong)copy, (ulong)set, (ulong)len);
+}
+
 static struct sbiunit_test_case string_test_cases[] = {
 	SBIUNIT_TEST_CASE(string_strcmp_test),
 	SBIUNIT_TEST_CASE(string_strncmp_test),
@@ -366,6 +548,12 @@ static struct sbiunit_test_case string_test_cases[] = {
 	SBIUNIT_TEST_CASE(memory_memmove_test),
 	SBIUNIT_TEST_CASE(memory_memcmp_test),
 	SBIUNIT_TEST_CASE(memory_memchr_test),
+	SBIUNIT_TEST_CASE(memory_memcpy_align_test),
+	SBIUNIT_TEST_CASE(memory_memset_align_test),
+	SBIUNIT_TEST_CASE(memory_memmove_align_test),
+	SBIUNIT_TEST_CASE(string_strlen_align_test),
+	SBIUNIT_TEST_CASE(string_strncmp_align_test),
+	SBIUNIT_TEST_CASE(memory_bench_test),
 	SBIUNIT_END_CASE,
 };
 
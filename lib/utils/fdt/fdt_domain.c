@@ -12,6 +12,7 @@
 #include <libfdt_env.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_domain.h>
+#include <sbi/sbi_domain_channel.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_heap.h>
@@ -483,6 +484,16 @@ static int __fdt_parse_domain(const void *fdt, int domain_offset, void *opaque)
 	else
 		dom->system_suspend_allowed = false;
 
+	/* Read "sched-budget-us" DT property */
+	val = fdt_getprop(fdt, domain_offset, "sched-budget-us", &len);
+	if (val && len >= 4)
+		dom->sched_budget_us = fdt32_to_cpu(*val);
+
+	/* Read "sched-priority" DT property */
+	val = fdt_getprop(fdt, domain_offset, "sched-priority", &len);
+	if (val && len >= 4)
+		dom->sched_priority = fdt32_to_cpu(*val);
+
 	/* Find /cpus DT node */
 	cpus_offset = fdt_path_offset(fdt, "/cpus");
 	if (cpus_offset < 0) {
@@ -535,6 +546,125 @@ fail_free_domain:
 	return err;
 }
 
+#ifdef CONFIG_SBI_DOMAIN_CHANNEL
+static struct sbi_domain *__fdt_find_domain(const void *fdt, int phandle)
+{
+	struct sbi_domain *dom;
+	const char *name;
+	int doffset;
+
+	doffset = fdt_node_offset_by_phandle(fdt, phandle);
+	if (doffset < 0 || fdt_node_check_compatible(fdt, doffset,
+						     "opensbi,domain,instance"))
+		return NULL;
+
+	name = fdt_get_name(fdt, doffset, NULL);
+	sbi_domain_for_each(dom) {
+		if (!strncmp(dom->name, name, sizeof(dom->name)))
+			return dom;
+	}
+
+	return NULL;
+}
+
+static int __fdt_parse_channel(const void *fdt, int channel_offset)
+{
+	u64 val64;
+	const u32 *val;
+	struct sbi_domain_channel *chan;
+	int i, err, len, region_offset;
+
+	chan = sbi_zalloc(sizeof(*chan));
+	if (!chan)
+		return SBI_ENOMEM;
+
+	/* Read DT node name */
+	strncpy(chan->name, fdt_get_name(fdt, channel_offset, NULL),
+		    sizeof(chan->name));
+	chan->name[sizeof(chan->name) - 1] = '\0';
+
+	/* Read "domains" DT property */
+	err = SBI_EINVAL;
+	val = fdt_getprop(fdt, channel_offset, "domains", &len);
+	if (!val || len != 2 * sizeof(u32))
+		goto fail_free_channel;
+	for (i = 0; i < 2; i++) {
+		chan->end[i].dom = __fdt_find_domain(fdt, fdt32_to_cpu(val[i]));
+		if (!chan->end[i].dom)
+			goto fail_free_channel;
+	}
+
+	/* Read "memregion" DT property */
+	val = fdt_getprop(fdt, channel_offset, "memregion", &len);
+	if (!val || len < 4)
+		goto fail_free_channel;
+	region_offset = fdt_node_offset_by_phandle(fdt, fdt32_to_cpu(*val));
+	if (region_offset < 0 ||
+	    fdt_node_check_compatible(fdt, region_offset,
+				      "opensbi,domain,memregion"))
+		goto fail_free_channel;
+
+	val = fdt_getprop(fdt, region_offset, "base", &len);
+	if (!val || len != 8)
+		goto fail_free_channel;
+	val64 = fdt32_to_cpu(val[0]);
+	val64 = (val64 << 32) | fdt32_to_cpu(val[1]);
+	chan->shmem_addr = val64;
+
+	val = fdt_getprop(fdt, region_offset, "order", &len);
+	if (!val || len != 4 || fdt32_to_cpu(*val) < 3 ||
+	    __riscv_xlen <= fdt32_to_cpu(*val))
+		goto fail_free_channel;
+	chan->shmem_size = BIT(fdt32_to_cpu(*val));
+
+	/* Read "desc-count" DT property */
+	val = fdt_getprop(fdt, channel_offset, "desc-count", &len);
+	if (val && len >= 4)
+		chan->desc_count = fdt32_to_cpu(*val);
+
+	/* Register the channel */
+	err = sbi_domain_channel_register(chan);
+	if (err)
+		goto fail_free_channel;
+
+	return 0;
+
+fail_free_channel:
+	sbi_free(chan);
+	return err;
+}
+
+static int __fdt_parse_channels(const void *fdt)
+{
+	int err, poffset, coffset;
+
+	poffset = fdt_path_offset(fdt, "/chosen");
+	if (poffset < 0)
+		return 0;
+	poffset = fdt_node_offset_by_compatible(fdt, poffset,
+						"opensbi,domain,config");
+	if (poffset < 0)
+		return 0;
+
+	fdt_for_each_subnode(coffset, fdt, poffset) {
+		if (fdt_node_check_compatible(fdt, coffset,
+					      "opensbi,domain,channel"))
+			continue;
+
+		err = __fdt_parse_channel(fdt, coffset);
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+#else
+static int __fdt_parse_channels(const void *fdt)
+{
+	return 0;
+}
+#endif
+
 int fdt_domains_populate(const void *fdt)
 {
 	const u32 *val;
@@ -574,6 +704,11 @@ int fdt_domains_populate(const void *fdt)
 	}
 
 	/* Iterate over each domain in FDT and populate details */
-	return fdt_iterate_each_domain_ro(fdt, &cold_domain_offset,
-					  __fdt_parse_domain);
+	err = fdt_iterate_each_domain_ro(fdt, &cold_domain_offset,
+					 __fdt_parse_domain);
+	if (err)
+		return err;
+
+	/* Channels refer to domains so parse them last */
+	return __fdt_parse_channels(fdt);
 }
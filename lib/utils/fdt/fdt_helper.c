@@ -80,6 +80,59 @@ int fdt_parse_phandle_with_args(const void *fdt, int nodeoff,
 	return SBI_ENOENT;
 }
 
+int fdt_parse_interrupt(const void *fdt, int nodeoff, int index,
+			struct fdt_phandle_args *out_args)
+{
+	u32 i, pcells;
+	int len, pnodeoff;
+	const fdt32_t *list, *val;
+
+	if (!fdt || (nodeoff < 0) || (index < 0) || !out_args)
+		return SBI_EINVAL;
+
+	if (fdt_getprop(fdt, nodeoff, "interrupts-extended", &len))
+		return fdt_parse_phandle_with_args(fdt, nodeoff,
+						   "interrupts-extended",
+						   "#interrupt-cells",
+						   index, out_args);
+
+	list = fdt_getprop(fdt, nodeoff, "interrupts", &len);
+	if (!list)
+		return SBI_ENOENT;
+
+	/* The interrupt-parent property may be inherited from ancestors */
+	pnodeoff = nodeoff;
+	do {
+		val = fdt_getprop(fdt, pnodeoff, "interrupt-parent", NULL);
+		if (val)
+			break;
+		pnodeoff = fdt_parent_offset(fdt, pnodeoff);
+	} while (pnodeoff >= 0);
+	if (!val)
+		return SBI_ENOENT;
+
+	pnodeoff = fdt_node_offset_by_phandle(fdt, fdt32_to_cpu(*val));
+	if (pnodeoff < 0)
+		return pnodeoff;
+
+	val = fdt_getprop(fdt, pnodeoff, "#interrupt-cells", NULL);
+	if (!val)
+		return SBI_ENOENT;
+	pcells = fdt32_to_cpu(*val);
+	if (!pcells || FDT_MAX_PHANDLE_ARGS < pcells)
+		return SBI_EINVAL;
+	if ((index + 1) * pcells * sizeof(*list) > len)
+		return SBI_ENOENT;
+
+	list += index * pcells;
+	out_args->node_offset = pnodeoff;
+	out_args->args_count = pcells;
+	for (i = 0; i < pcells; i++)
+		out_args->args[i] = fdt32_to_cpu(list[i]);
+
+	return 0;
+}
+
 static int fdt_translate_address(const void *fdt, uint64_t reg, int parent,
 				 uint64_t *addr)
 {
@@ -7,6 +7,7 @@
  *   Anup Patel <anup.patel@wdc.com>
  */
 
+#include <libfdt.h>
 #include <sbi_utils/fdt/fdt_helper.h>
 #include <sbi_utils/serial/fdt_serial.h>
 #include <sbi_utils/serial/sifive-uart.h>
@@ -15,13 +16,27 @@ static int serial_sifive_init(const void *fdt, int nodeoff,
 			      const struct fdt_match *match)
 {
 	int rc;
+	struct fdt_phandle_args irq;
 	struct platform_uart_data uart = { 0 };
 
 	rc = fdt_parse_sifive_uart_node(fdt, nodeoff, &uart);
 	if (rc)
 		return rc;
 
-	return sifive_uart_init(uart.addr, uart.freq, uart.baud);
+	rc = sifive_uart_init(uart.addr, uart.freq, uart.baud);
+	if (rc)
+		return rc;
+
+	/*
+	 * Interrupt is optional and only used for buffered output. The
+	 * S-mode driver also owns the interrupt enable register so only
+	 * use it when the UART is reserved for M-mode.
+	 */
+	if (fdt_getprop(fdt, nodeoff, "opensbi,m-mode-only", NULL) &&
+	    !fdt_parse_interrupt(fdt, nodeoff, 0, &irq) && irq.args_count)
+		sifive_uart_set_tx_irq(irq.node_offset, irq.args[0]);
+
+	return 0;
 }
 
 static const struct fdt_match serial_sifive_match[] = {
@@ -7,6 +7,7 @@
  *   Anup Patel <anup.patel@wdc.com>
  */
 
+#include <libfdt.h>
 #include <sbi_utils/fdt/fdt_helper.h>
 #include <sbi_utils/serial/fdt_serial.h>
 #include <sbi_utils/serial/uart8250.h>
@@ -15,22 +16,45 @@ static int serial_uart8250_init(const void *fdt, int nodeoff,
 				const struct fdt_match *match)
 {
 	struct platform_uart_data uart = { 0 };
+	struct fdt_phandle_args irq;
 	ulong caps = (ulong)match->data;
-	int rc;
+	const fdt32_t *val;
+	int len, rc;
 
 	rc = fdt_parse_uart_node(fdt, nodeoff, &uart);
 	if (rc)
 		return rc;
 
-	return uart8250_init(uart.addr, uart.freq, uart.baud,
-			     uart.reg_shift, uart.reg_io_width,
-			     uart.reg_offset, caps);
+	val = fdt_getprop(fdt, nodeoff, "fifo-size", &len);
+	if (val && len >= sizeof(fdt32_t)) {
+		caps &= ~(UART_CAP_FIFO_SIZE_MASK | UART_CAP_DW_CPR);
+		caps |= UART_CAP_FIFO_SIZE(fdt32_to_cpu(*val));
+	}
+
+	rc = uart8250_init(uart.addr, uart.freq, uart.baud,
+			   uart.reg_shift, uart.reg_io_width,
+			   uart.reg_offset, caps);
+	if (rc)
+		return rc;
+
+	/*
+	 * Interrupt is optional and only used for buffered output. The
+	 * S-mode driver also owns the interrupt enable register so only
+	 * use it when the UART is reserved for M-mode.
+	 */
+	if (fdt_getprop(fdt, nodeoff, "opensbi,m-mode-only", NULL) &&
+	    !fdt_parse_interrupt(fdt, nodeoff, 0, &irq) && irq.args_count)
+		uart8250_set_tx_irq(irq.node_offset, irq.args[0]);
+
+	return 0;
 }
 
 static const struct fdt_match serial_uart8250_match[] = {
 	{ .compatible = "ns16550" },
-	{ .compatible = "ns16550a" },
-	{ .compatible = "snps,dw-apb-uart" },
+	{ .compatible = "ns16550a",
+	  .data = (void *)UART_CAP_FIFO_SIZE(16) },
+	{ .compatible = "snps,dw-apb-uart",
+	  .data = (void *)UART_CAP_DW_CPR },
 	{ .compatible = "intel,xscale-uart",
 	  .data = (void *)UART_CAP_UUE },
 	{ },
@@ -10,6 +10,8 @@
 #include <sbi/riscv_io.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_domain.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_irqchip.h>
 #include <sbi_utils/serial/sifive-uart.h>
 
 /* clang-format off */
@@ -26,13 +28,18 @@
 #define UART_RXFIFO_EMPTY	0x80000000
 #define UART_RXFIFO_DATA	0x000000ff
 #define UART_TXCTRL_TXEN	0x1
+#define UART_TXCTRL_TXCNT_SHIFT	16
 #define UART_RXCTRL_RXEN	0x1
+#define UART_IE_TXWM		0x1
 
 /* clang-format on */
 
 static volatile char *uart_base;
 static u32 uart_in_freq;
 static u32 uart_baudrate;
+static bool uart_tx_irq_valid;
+static u32 uart_tx_irqchip_id;
+static u32 uart_tx_hwirq;
 
 /**
  * Find minimum divisor divides in_freq to max_target_hz;
@@ -75,6 +82,23 @@ static void sifive_uart_putc(char ch)
 	set_reg(UART_REG_TXFIFO, ch);
 }
 
+static unsigned long sifive_uart_puts(const char *str, unsigned long len)
+{
+	unsigned long i;
+
+	/*
+	 * The S-mode driver may reprogram the TX watermark so TXWM does
+	 * not tell how much room is left. Check the full flag per byte.
+	 */
+	for (i = 0; i < len; i++) {
+		if (str[i] == '\n')
+			sifive_uart_putc('\r');
+		sifive_uart_putc(str[i]);
+	}
+
+	return len;
+}
+
 static int sifive_uart_getc(void)
 {
 	u32 ret = get_reg(UART_REG_RXFIFO);
@@ -85,12 +109,72 @@ static int sifive_uart_getc(void)
 	return -1;
 }
 
+static unsigned long sifive_uart_tx_try_puts(const char *str,
+					     unsigned long len)
+{
+	unsigned long i = 0;
+
+	while (i < len && !(get_reg(UART_REG_TXFIFO) & UART_TXFIFO_FULL))
+		set_reg(UART_REG_TXFIFO, str[i++]);
+
+	return i;
+}
+
+/* Note: Only used when the UART is reserved for M-mode */
+static void sifive_uart_tx_irq_enable(bool enable)
+{
+	u32 ie = get_reg(UART_REG_IE);
+
+	if (enable)
+		ie |= UART_IE_TXWM;
+	else
+		ie &= ~UART_IE_TXWM;
+	set_reg(UART_REG_IE, ie);
+}
+
+static int sifive_uart_tx_irq_handler(u32 hwirq, void *priv)
+{
+	sbi_console_tx_process();
+
+	return 0;
+}
+
+static int sifive_uart_tx_irq_init(void)
+{
+	struct sbi_irqchip_device *chip;
+	int rc;
+
+	if (!uart_tx_irq_valid)
+		return SBI_ENODEV;
+
+	chip = sbi_irqchip_find_device(uart_tx_irqchip_id);
+	if (!chip || !(chip->caps & SBI_IRQCHIP_CAPS_WIRED))
+		return SBI_ENODEV;
+
+	/* Interrupt might be delegated to S-mode so fallback to polling */
+	rc = sbi_irqchip_register_handler(chip, uart_tx_hwirq, 1,
+					  SBI_HWIRQ_FLAGS_LEVEL_HIGH,
+					  sifive_uart_tx_irq_handler, NULL);
+	return rc ? SBI_ENODEV : 0;
+}
+
 static struct sbi_console_device sifive_console = {
 	.name = "sifive_uart",
 	.console_putc = sifive_uart_putc,
-	.console_getc = sifive_uart_getc
+	.console_puts = sifive_uart_puts,
+	.console_getc = sifive_uart_getc,
+	.console_tx_try_puts = sifive_uart_tx_try_puts,
+	.console_tx_irq_enable = sifive_uart_tx_irq_enable,
+	.console_tx_irq_init = sifive_uart_tx_irq_init
 };
 
+void sifive_uart_set_tx_irq(u32 irqchip_id, u32 hwirq)
+{
+	uart_tx_irqchip_id = irqchip_id;
+	uart_tx_hwirq = hwirq;
+	uart_tx_irq_valid = true;
+}
+
 int sifive_uart_init(unsigned long base, u32 in_freq, u32 baudrate)
 {
 	uart_base     = (volatile char *)base;
@@ -104,8 +188,9 @@ int sifive_uart_init(unsigned long base, u32 in_freq, u32 baudrate)
 	/* Disable interrupts */
 	set_reg(UART_REG_IE, 0);
 
-	/* Enable TX */
-	set_reg(UART_REG_TXCTRL, UART_TXCTRL_TXEN);
+	/* Enable TX and flag TX watermark only when the TX FIFO is empty */
+	set_reg(UART_REG_TXCTRL,
+		UART_TXCTRL_TXEN | (1 << UART_TXCTRL_TXCNT_SHIFT));
 
 	/* Enable Rx */
 	set_reg(UART_REG_RXCTRL, UART_RXCTRL_RXEN);
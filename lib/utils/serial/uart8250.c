@@ -11,6 +11,8 @@
 #include <sbi/riscv_io.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_domain.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_irqchip.h>
 #include <sbi_utils/serial/uart8250.h>
 
 /* clang-format off */
@@ -29,6 +31,9 @@
 #define UART_SCR_OFFSET		7	/* I/O: Scratch Register */
 #define UART_MDR1_OFFSET	8	/* I/O:  Mode Register */
 
+#define DW_UART_CPR_OFFSET	0xf4	/* In:  Component Parameter Register */
+#define DW_UART_CPR_FIFO_MODE(__cpr)	(((__cpr) >> 16) & 0xff)
+
 #define UART_LSR_FIFOE		0x80	/* Fifo error */
 #define UART_LSR_TEMT		0x40	/* Transmitter empty */
 #define UART_LSR_THRE		0x20	/* Transmit-hold-register empty */
@@ -39,6 +44,8 @@
 #define UART_LSR_DR		0x01	/* Receiver data ready */
 #define UART_LSR_BRK_ERROR_BITS	0x1E	/* BI, FE, PE, OE bits */
 
+#define UART_IER_THRI		0x02	/* Enable Transmitter holding register int. */
+
 /* The XScale PXA UARTs define these bits */
 #define UART_IER_DMAE		0x80	/* DMA Requests Enable */
 #define UART_IER_UUE		0x40	/* UART Unit Enable */
@@ -48,6 +55,9 @@
 /* clang-format on */
 
 static struct uart8250_device uart8250_dev;
+static bool uart8250_tx_irq_valid;
+static u32 uart8250_tx_irqchip_id;
+static u32 uart8250_tx_hwirq;
 
 static u32 get_reg(struct uart8250_device *dev, u32 num)
 {
@@ -93,17 +103,113 @@ int uart8250_device_getc(struct uart8250_device *dev)
 	return -1;
 }
 
+static void uart8250_fifo_putc(struct uart8250_device *dev, u32 *room,
+			       char ch)
+{
+	if (!*room) {
+		while ((get_reg(dev, UART_LSR_OFFSET) & UART_LSR_THRE) == 0)
+			;
+		*room = dev->fifo_size;
+	}
+
+	set_reg(dev, UART_THR_OFFSET, ch);
+	(*room)--;
+}
+
+static unsigned long uart8250_puts(const char *str, unsigned long len)
+{
+	unsigned long i;
+	u32 room = 0;
+
+	/* THRE means the whole TX FIFO is empty so fill it per wait */
+	for (i = 0; i < len; i++) {
+		if (str[i] == '\n')
+			uart8250_fifo_putc(&uart8250_dev, &room, '\r');
+		uart8250_fifo_putc(&uart8250_dev, &room, str[i]);
+	}
+
+	return len;
+}
+
 static int uart8250_getc(void)
 {
 	return uart8250_device_getc(&uart8250_dev);
 }
 
+static unsigned long uart8250_tx_try_puts(const char *str, unsigned long len)
+{
+	unsigned long i = 0;
+
+	if (!(get_reg(&uart8250_dev, UART_LSR_OFFSET) & UART_LSR_THRE))
+		return 0;
+
+	while (i < len && i < uart8250_dev.fifo_size)
+		set_reg(&uart8250_dev, UART_THR_OFFSET, str[i++]);
+
+	return i;
+}
+
+/* Note: Only used when the UART is reserved for M-mode */
+static void uart8250_tx_irq_enable(bool enable)
+{
+	u32 ier = get_reg(&uart8250_dev, UART_IER_OFFSET);
+
+	if (enable)
+		ier |= UART_IER_THRI;
+	else
+		ier &= ~UART_IER_THRI;
+	set_reg(&uart8250_dev, UART_IER_OFFSET, ier);
+}
+
+static int uart8250_tx_irq_handler(u32 hwirq, void *priv)
+{
+	/*
+	 * Reading IIR acknowledges the THRE interrupt which is fine
+	 * because S-mode does not use this UART.
+	 */
+	get_reg(&uart8250_dev, UART_IIR_OFFSET);
+
+	sbi_console_tx_process();
+
+	return 0;
+}
+
+static int uart8250_tx_irq_init(void)
+{
+	struct sbi_irqchip_device *chip;
+	int rc;
+
+	if (!uart8250_tx_irq_valid)
+		return SBI_ENODEV;
+
+	chip = sbi_irqchip_find_device(uart8250_tx_irqchip_id);
+	if (!chip || !(chip->caps & SBI_IRQCHIP_CAPS_WIRED))
+		return SBI_ENODEV;
+
+	/* Interrupt might be delegated to S-mode so fallback to polling */
+	rc = sbi_irqchip_register_handler(chip, uart8250_tx_hwirq, 1,
+					  SBI_HWIRQ_FLAGS_LEVEL_HIGH,
+					  uart8250_tx_irq_handler, NULL);
+	return rc ? SBI_ENODEV : 0;
+}
+
 static struct sbi_console_device uart8250_console = {
 	.name = "uart8250",
 	.console_putc = uart8250_putc,
-	.console_getc = uart8250_getc
+	.console_puts = uart8250_puts,
+	.console_getc = uart8250_getc,
+	.console_tx_try_puts = uart8250_tx_try_puts,
+	.console_tx_irq_enable = uart8250_tx_irq_enable,
+	.console_tx_irq_init = uart8250_tx_irq_init
 };
 
+void uart8250_set_tx_irq(u32 irqchip_id, u32 hwirq)
+{
+	uart8250_tx_irqchip_id = irqchip_id;
+	uart8250_tx_hwirq = hwirq;
+	uart8250_tx_irq_valid = true;
+}
+
 void uart8250_device_init(struct uart8250_device *dev, unsigned long base,
 			  u32 in_freq, u32 baudrate, u32 reg_shift,
 			  u32 reg_width, u32 reg_offset, u32 caps)
@@ -115,6 +221,17 @@ void uart8250_device_init(struct uart8250_device *dev, unsigned long base,
 	dev->reg_width = reg_width;
 	dev->in_freq   = in_freq;
 	dev->baudrate  = baudrate;
+	dev->fifo_size = (caps & UART_CAP_FIFO_SIZE_MASK) >>
+			 UART_CAP_FIFO_SIZE_SHIFT;
+	/*
+	 * The DesignWare FIFO depth is a synthesis parameter which may be
+	 * zero. CPR reads as zero when it is not implemented.
+	 */
+	if (!dev->fifo_size && (caps & UART_CAP_DW_CPR))
+		dev->fifo_size = DW_UART_CPR_FIFO_MODE(
+				readl(dev->base + DW_UART_CPR_OFFSET)) * 16;
+	if (!dev->fifo_size)
+		dev->fifo_size = 1;
 
 	if (dev->baudrate) {
 		bdiv = (dev->in_freq + 8 * dev->baudrate) /
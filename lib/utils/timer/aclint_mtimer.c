@@ -69,6 +69,19 @@ static u64 mtimer_value(void)
 	return mt->time_rd((void *)mt->mtime_addr);
 }
 
+#if __riscv_xlen != 32
+static unsigned long mtimer_value_addr(void)
+{
+	struct aclint_mtimer_data *mt;
+
+	mt = mtimer_get_hart_data_ptr(sbi_scratch_thishart_ptr());
+	if (!mt || mt->time_rd != mtimer_time_rd64)
+		return 0;
+
+	return mt->mtime_addr;
+}
+#endif
+
 static void mtimer_event_stop(void)
 {
 	u32 target_hart = current_hartid();
@@ -105,6 +118,9 @@ static void mtimer_event_start(u64 next_event)
 static struct sbi_timer_device mtimer = {
 	.name = "aclint-mtimer",
 	.timer_value = mtimer_value,
+#if __riscv_xlen != 32
+	.timer_value_addr = mtimer_value_addr,
+#endif
 	.timer_event_start = mtimer_event_start,
 	.timer_event_stop = mtimer_event_stop
 };
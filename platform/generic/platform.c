@@ -11,12 +11,17 @@
 #include <platform_override.h>
 #include <sbi/riscv_asm.h>
 #include <sbi/sbi_bitops.h>
+#include <sbi/sbi_domain_stats.h>
+#include <sbi/sbi_emuprof.h>
+#include <sbi/sbi_fwlog.h>
 #include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_heap.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_system.h>
 #include <sbi/sbi_tlb.h>
+#include <sbi/sbi_trace.h>
+#include <sbi/sbi_trapstat.h>
 #include <sbi_utils/cache/fdt_cmo_helper.h>
 #include <sbi_utils/fdt/fdt_domain.h>
 #include <sbi_utils/fdt/fdt_driver.h>
@@ -33,7 +38,30 @@
 /* List of platform override modules generated at compile time */
 extern const struct fdt_driver *const platform_override_modules[];
 
-static u32 fw_platform_calculate_heap_size(u32 hart_count)
+static u32 fw_platform_count_domains(const void *fdt)
+{
+	int config_offset, domain_offset;
+	u32 domain_count = 1;
+
+	config_offset = fdt_path_offset(fdt, "/chosen");
+	if (config_offset < 0)
+		return domain_count;
+
+	config_offset = fdt_node_offset_by_compatible(fdt, config_offset,
+						      "opensbi,domain,config");
+	if (config_offset < 0)
+		return domain_count;
+
+	fdt_for_each_subnode(domain_offset, fdt, config_offset) {
+		if (!fdt_node_check_compatible(fdt, domain_offset,
+					       "opensbi,domain,instance"))
+			domain_count++;
+	}
+
+	return domain_count;
+}
+
+static u32 fw_platform_calculate_heap_size(const void *fdt, u32 hart_count)
 {
 	u32 heap_size;
 
@@ -42,6 +70,16 @@ static u32 fw_platform_calculate_heap_size(u32 hart_count)
 	/* For TLB fifo */
 	heap_size += SBI_TLB_INFO_SIZE * (hart_count) * (hart_count);
 
+	/* For per-HART firmware diagnostics */
+	heap_size += sbi_fwlog_heap_size(hart_count);
+	heap_size += sbi_trace_heap_size(hart_count);
+	heap_size += sbi_emuprof_heap_size(hart_count);
+	heap_size += sbi_trapstat_heap_size(hart_count);
+
+	/* For per-domain statistics of the ROOT and DT domains */
+	heap_size += sbi_domain_stats_heap_size(fw_platform_count_domains(fdt),
+						hart_count);
+
 	return BIT_ALIGN(heap_size, HEAP_BASE_ALIGN);
 }
 
@@ -64,7 +102,7 @@ static u32 fw_platform_get_heap_size(const void *fdt, u32 hart_count)
 		return BIT_ALIGN(fdt32_to_cpu(*val), HEAP_BASE_ALIGN);
 
 default_config:
-	return fw_platform_calculate_heap_size(hart_count);
+	return fw_platform_calculate_heap_size(fdt, hart_count);
 }
 
 extern struct sbi_platform platform;
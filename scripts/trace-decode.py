@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Copyright (c) 2026 OpenSBI Contributors
+#
+# Decode OpenSBI binary trace shared memory dumps
+#
+# Each input file is a raw copy of the shared memory registered by one
+# HART using the OpenSBI firmware specific extension (TRACE_SET_SHMEM).
+# The layout is described by struct sbi_trace_shmem_header and
+# struct sbi_trace_record in include/sbi/sbi_trace.h. Records from all
+# input files are merged and printed in timestamp order.
+
+import argparse
+import struct
+import sys
+
+HEADER_FMT = "<QQIIII32x"
+RECORD_FMT = "<QHHIQQ"
+SHMEM_VERSION = 1
+
+EVENTS = [
+    "trap_entry",
+    "trap_exit",
+    "ecall",
+    "ipi_send",
+    "ipi_recv",
+    "tlb_enqueue",
+    "tlb_process",
+    "timer_fire",
+    "hsm_state",
+    "domain_switch",
+]
+
+ARG_NAMES = {
+    "trap_entry": ("mcause", "mtval"),
+    "trap_exit": ("mcause", "mepc"),
+    "ecall": ("ext", "fid"),
+    "ipi_send": ("hartindex", "event"),
+    "ipi_recv": ("events", None),
+    "tlb_enqueue": ("hartindex", "type"),
+    "tlb_process": ("type", "start"),
+    "timer_fire": ("time", "callback"),
+    "hsm_state": ("old", "new"),
+    "domain_switch": ("from", "to"),
+}
+
+
+def decode_file(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    hdr_size = struct.calcsize(HEADER_FMT)
+    if len(data) < hdr_size:
+        sys.exit("%s: too small for trace header" % path)
+
+    head, lost, version, rec_size, nr_records, hartid = \
+        struct.unpack_from(HEADER_FMT, data, 0)
+    if version != SHMEM_VERSION:
+        sys.exit("%s: unsupported trace version %d" % (path, version))
+    if rec_size < struct.calcsize(RECORD_FMT):
+        sys.exit("%s: invalid record size %d" % (path, rec_size))
+
+    nr_records = min(nr_records, (len(data) - hdr_size) // rec_size)
+    count = min(head, nr_records)
+    records = []
+    for n in range(head - count, head):
+        off = hdr_size + (n % nr_records) * rec_size
+        ts, event, _, rec_hartid, arg0, arg1 = \
+            struct.unpack_from(RECORD_FMT, data, off)
+        records.append((ts, rec_hartid, event, arg0, arg1))
+
+    return hartid, head, lost, records
+
+
+def format_record(rec):
+    ts, hartid, event, arg0, arg1 = rec
+    if event < len(EVENTS):
+        name = EVENTS[event]
+        a0, a1 = ARG_NAMES[name]
+    else:
+        name = "event%d" % event
+        a0, a1 = "arg0", "arg1"
+
+    args = "%s=0x%x" % (a0, arg0)
+    if a1:
+        args += " %s=0x%x" % (a1, arg1)
+    return "%20d hart%-4d %-14s %s" % (ts, hartid, name, args)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Decode OpenSBI binary trace shared memory dumps")
+    parser.add_argument("files", nargs="+", metavar="FILE",
+                        help="raw dump of a trace shared memory")
+    args = parser.parse_args()
+
+    records = []
+    for path in args.files:
+        hartid, head, lost, recs = decode_file(path)
+        print("# hart%d: %d records written, %d lost, %d available" %
+              (hartid, head, lost, len(recs)))
+        records.extend(recs)
+
+    for rec in sorted(records, key=lambda r: r[0]):
+        print(format_record(rec))
+
+
+if __name__ == "__main__":
+    main()